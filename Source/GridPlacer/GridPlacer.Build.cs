@@ -26,6 +26,7 @@ public class GridPlacer : ModuleRules
 			new string[]
 			{
 				"Core",
+				"GridPlacerRuntime",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -45,12 +46,23 @@ public class GridPlacer : ModuleRules
 				"LevelEditor",
 				"InteractiveToolsFramework",
 				"EditorInteractiveToolsFramework",
-				"EditorWidgets"
+				"EditorWidgets",
+				"EditorWidgets",
+				"MeshDescription",
+				"StaticMeshDescription",
+				"AssetRegistry",
+				"AssetTools",
+				"Projects",
+				"PropertyEditor"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
 		
 		
+		//Layout images are decoded row by row straight through libpng and OpenEXR, which reports errors by throwing
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "UElibPNG", "zlib", "UEOpenExr", "Imath");
+		bEnableExceptions = true;
+		
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerAutotileSet.h"
+#include "Engine/StaticMesh.h"
+
+const FIntPoint UGridPlacerAutotileSet::NeighborOffsets[8] = {
+	FIntPoint(1, 0),	//North
+	FIntPoint(1, 1),	//NorthEast
+	FIntPoint(0, 1),	//East
+	FIntPoint(-1, 1),	//SouthEast
+	FIntPoint(-1, 0),	//South
+	FIntPoint(-1, -1),	//SouthWest
+	FIntPoint(0, -1),	//West
+	FIntPoint(1, -1)	//NorthWest
+};
+
+const UGridPlacerAutotileSet::FResolvedVariant& UGridPlacerAutotileSet::Resolve(uint8 NeighborMask) const
+{
+	if(LookupTable.Num() == 0)
+		BuildLookupTable();
+	return LookupTable[NeighborMask];
+}
+
+UStaticMesh* UGridPlacerAutotileSet::GetMesh(const FResolvedVariant& Resolved) const
+{
+	return Variants.IsValidIndex(Resolved.VariantIndex) ? Variants[Resolved.VariantIndex].StaticMesh : nullptr;
+}
+
+bool UGridPlacerAutotileSet::ContainsMesh(const UStaticMesh* StaticMesh) const
+{
+	for(const FGridPlacerAutotileVariant& Variant : Variants)
+		if(Variant.StaticMesh == StaticMesh)
+			return true;
+	return false;
+}
+
+void UGridPlacerAutotileSet::PostLoad()
+{
+	Super::PostLoad();
+	LookupTable.Reset();
+}
+
+#if WITH_EDITOR
+void UGridPlacerAutotileSet::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	LookupTable.Reset();
+}
+#endif
+
+uint8 UGridPlacerAutotileSet::NormalizeMask(uint8 NeighborMask) const
+{
+	//Orthogonal neighbors only
+	if(Neighborhood == EGridPlacerAutotileNeighborhood::FourNeighbors)
+		return NeighborMask & 0x55;
+	//A diagonal only matters if both orthogonal neighbors next to it are there as well
+	uint8 Normalized = NeighborMask & 0x55;
+	for(int32 Diagonal = 1; Diagonal < 8; Diagonal += 2)
+	{
+		const uint8 Adjacent = (1 << (Diagonal - 1)) | (1 << ((Diagonal + 1) % 8));
+		if((NeighborMask & (1 << Diagonal)) && (NeighborMask & Adjacent) == Adjacent)
+			Normalized |= 1 << Diagonal;
+	}
+	return Normalized;
+}
+
+uint8 UGridPlacerAutotileSet::RotateMask(uint8 NeighborMask, int32 Steps)
+{
+	const int32 Shift = (Steps % 4) * 2;
+	return static_cast<uint8>((NeighborMask << Shift) | (NeighborMask >> ((8 - Shift) % 8)));
+}
+
+void UGridPlacerAutotileSet::BuildLookupTable() const
+{
+	LookupTable.SetNum(256);
+	for(int32 Mask = 0; Mask < 256; ++Mask)
+	{
+		const uint8 Target = NormalizeMask(static_cast<uint8>(Mask));
+		FResolvedVariant& Best = LookupTable[Mask];
+		Best = FResolvedVariant();
+		int32 BestMismatches = MAX_int32;
+		for(int32 VariantIndex = 0; VariantIndex < Variants.Num(); ++VariantIndex)
+		{
+			const FGridPlacerAutotileVariant& Variant = Variants[VariantIndex];
+			if(!Variant.StaticMesh)
+				continue;
+			const uint8 Connections = NormalizeMask(static_cast<uint8>(Variant.Connections));
+			const int32 NumRotations = Variant.AllowRotation ? 4 : 1;
+			for(int32 Steps = 0; Steps < NumRotations; ++Steps)
+			{
+				const int32 Mismatches = FMath::CountBits(RotateMask(Connections, Steps) ^ Target);
+				if(Mismatches < BestMismatches)
+				{
+					BestMismatches = Mismatches;
+					Best.VariantIndex = VariantIndex;
+					Best.RotationSteps = static_cast<uint8>(Steps);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerChanges.h"
+#include "GridPlacerSubsystem.h"
+#include "Engine/Level.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/MaterialInterface.h"
+#include "Engine/World.h"
+
+namespace
+{
+	UGridPlacerSubsystem* GetSubsystemFromTarget(UObject* Object)
+	{
+		UWorld* World = Object ? Object->GetWorld() : nullptr;
+		return World ? World->GetSubsystem<UGridPlacerSubsystem>() : nullptr;
+	}
+}
+
+void FGridPlacerPlacementChange::AddRecord(uint32 Id, const FGridPlacerSpawnRequest& Request)
+{
+	const int32 AssetIndex = Assets.AddUnique(TSoftObjectPtr<UObject>(Request.Asset));
+	Records.Add({Id, AssetIndex, Request.Transform, Request.AsInstance, Request.Component, Request.CustomData});
+}
+
+void FGridPlacerPlacementChange::Apply(UObject* Object)
+{
+	if(Kind == EKind::Added)
+		SpawnRecords(Object);
+	else
+		RemoveRecords(Object);
+}
+
+void FGridPlacerPlacementChange::Revert(UObject* Object)
+{
+	if(Kind == EKind::Added)
+		RemoveRecords(Object);
+	else
+		SpawnRecords(Object);
+}
+
+bool FGridPlacerPlacementChange::HasExpired(UObject* Object) const
+{
+	return GetSubsystemFromTarget(Object) == nullptr;
+}
+
+FString FGridPlacerPlacementChange::ToString() const
+{
+	return FString::Printf(TEXT("GridPlacer %s %d objects"), Kind == EKind::Added ? TEXT("Place") : TEXT("Remove"), Records.Num());
+}
+
+void FGridPlacerPlacementChange::SpawnRecords(UObject* Object)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystemFromTarget(Object);
+	if(!Subsystem)
+		return;
+	TArray<UObject*> ResolvedAssets;
+	ResolvedAssets.Reserve(Assets.Num());
+	for(const TSoftObjectPtr<UObject>& Asset : Assets)
+		ResolvedAssets.Add(Asset.LoadSynchronous());
+	for(const FRecord& Record : Records)
+	{
+		FGridPlacerSpawnRequest Request;
+		Request.Asset = ResolvedAssets[Record.AssetIndex];
+		Request.Transform = Record.Transform;
+		Request.AsInstance = Record.AsInstance;
+		Request.Component = Record.Component;
+		Request.CustomData = Record.CustomData;
+		Subsystem->SpawnItem(Request, Record.Id);
+	}
+}
+
+void FGridPlacerPlacementChange::RemoveRecords(UObject* Object)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystemFromTarget(Object);
+	if(!Subsystem)
+		return;
+	for(int32 i = Records.Num() - 1; i >= 0; --i)
+		Subsystem->RemoveItem(Records[i].Id);
+}
+
+void FGridPlacerReplaceChange::AddRecord(uint32 Id, UObject* PreviousAsset, UObject* NewAsset)
+{
+	const int32 PreviousAssetIndex = Assets.AddUnique(TSoftObjectPtr<UObject>(PreviousAsset));
+	const int32 NewAssetIndex = Assets.AddUnique(TSoftObjectPtr<UObject>(NewAsset));
+	Records.Add({Id, PreviousAssetIndex, NewAssetIndex});
+}
+
+void FGridPlacerReplaceChange::Apply(UObject* Object)
+{
+	ReplaceRecords(Object, true);
+}
+
+void FGridPlacerReplaceChange::Revert(UObject* Object)
+{
+	ReplaceRecords(Object, false);
+}
+
+bool FGridPlacerReplaceChange::HasExpired(UObject* Object) const
+{
+	return GetSubsystemFromTarget(Object) == nullptr;
+}
+
+FString FGridPlacerReplaceChange::ToString() const
+{
+	return FString::Printf(TEXT("GridPlacer Replace %d objects"), Records.Num());
+}
+
+void FGridPlacerReplaceChange::ReplaceRecords(UObject* Object, bool UseNewAssets)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystemFromTarget(Object);
+	if(!Subsystem)
+		return;
+	TArray<UObject*> ResolvedAssets;
+	ResolvedAssets.Reserve(Assets.Num());
+	for(const TSoftObjectPtr<UObject>& Asset : Assets)
+		ResolvedAssets.Add(Asset.LoadSynchronous());
+	TArray<FGridPlacerReplaceRequest> Requests;
+	Requests.Reserve(Records.Num());
+	for(const FRecord& Record : Records)
+		Requests.Add({Record.Id, ResolvedAssets[UseNewAssets ? Record.NewAssetIndex : Record.PreviousAssetIndex]});
+	Subsystem->ReplaceItems(Requests);
+}
+
+void FGridPlacerConsolidateChange::AddRecord(const FGridPlacerConsolidateRequest& Request)
+{
+	FRecord& Record = Records.AddDefaulted_GetRef();
+	Record.Id = Request.Id;
+	Record.MeshIndex = Assets.AddUnique(TSoftObjectPtr<UObject>(Request.Mesh));
+	Record.MaterialIndices.Reserve(Request.Materials.Num());
+	for(UMaterialInterface* Material : Request.Materials)
+		Record.MaterialIndices.Add(Material ? Assets.AddUnique(TSoftObjectPtr<UObject>(Material)) : INDEX_NONE);
+	Record.Transform = Request.Transform;
+	Record.Chunk = Request.Chunk;
+	Record.CustomData = Request.CustomData;
+}
+
+void FGridPlacerConsolidateChange::Apply(UObject* Object)
+{
+	if(UGridPlacerSubsystem* Subsystem = GetSubsystemFromTarget(Object))
+		Subsystem->ConsolidateItems(ResolveRequests());
+}
+
+void FGridPlacerConsolidateChange::Revert(UObject* Object)
+{
+	if(UGridPlacerSubsystem* Subsystem = GetSubsystemFromTarget(Object))
+		Subsystem->ExpandItems(ResolveRequests());
+}
+
+bool FGridPlacerConsolidateChange::HasExpired(UObject* Object) const
+{
+	return GetSubsystemFromTarget(Object) == nullptr;
+}
+
+FString FGridPlacerConsolidateChange::ToString() const
+{
+	return FString::Printf(TEXT("GridPlacer Consolidate %d objects"), Records.Num());
+}
+
+TArray<FGridPlacerConsolidateRequest> FGridPlacerConsolidateChange::ResolveRequests() const
+{
+	TArray<UObject*> ResolvedAssets;
+	ResolvedAssets.Reserve(Assets.Num());
+	for(const TSoftObjectPtr<UObject>& Asset : Assets)
+		ResolvedAssets.Add(Asset.LoadSynchronous());
+	TArray<FGridPlacerConsolidateRequest> Requests;
+	Requests.Reserve(Records.Num());
+	for(const FRecord& Record : Records)
+	{
+		FGridPlacerConsolidateRequest& Request = Requests.AddDefaulted_GetRef();
+		Request.Id = Record.Id;
+		Request.Mesh = Cast<UStaticMesh>(ResolvedAssets[Record.MeshIndex]);
+		for(const int32 MaterialIndex : Record.MaterialIndices)
+			Request.Materials.Add(MaterialIndex != INDEX_NONE ? Cast<UMaterialInterface>(ResolvedAssets[MaterialIndex]) : nullptr);
+		Request.Transform = Record.Transform;
+		Request.Chunk = Record.Chunk;
+		Request.CustomData = Record.CustomData;
+	}
+	return Requests;
+}
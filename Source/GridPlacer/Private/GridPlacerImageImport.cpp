@@ -0,0 +1,283 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerImageImport.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include <exception>
+
+THIRD_PARTY_INCLUDES_START
+#include "png.h"
+#include "Imath/ImathBox.h"
+#include "OpenEXR/Iex.h"
+#include "OpenEXR/ImfChannelList.h"
+#include "OpenEXR/ImfFrameBuffer.h"
+#include "OpenEXR/ImfHeader.h"
+#include "OpenEXR/ImfInputFile.h"
+#include "OpenEXR/ImfIO.h"
+THIRD_PARTY_INCLUDES_END
+
+#define LOCTEXT_NAMESPACE "GridPlacerImageImport"
+
+namespace
+{
+	using namespace GridPlacerImageImport;
+
+	/**
+	 * 16 bit little endian heights, read straight from the file row by row
+	 */
+	class FRawRowReader : public FRowReader
+	{
+	public:
+		bool Open(TUniquePtr<IFileHandle>&& InFile, int32 RawWidth, FText& OutError)
+		{
+			File = MoveTemp(InFile);
+			const int64 NumPixels = File->Size() / 2;
+			const int64 RowWidth = RawWidth > 0 ? RawWidth : FMath::FloorToInt64(FMath::Sqrt(static_cast<double>(NumPixels)));
+			if(RowWidth <= 0 || NumPixels % RowWidth != 0 || NumPixels / RowWidth > MAX_int32)
+			{
+				OutError = LOCTEXT("RawSize", "The raw file doesn't hold whole rows of 16 bit heights for that width");
+				return false;
+			}
+			Width = static_cast<int32>(RowWidth);
+			Height = static_cast<int32>(NumPixels / RowWidth);
+			Color = false;
+			RowBuffer.SetNumUninitialized(Width * 2);
+			return true;
+		}
+
+		virtual bool ReadRow(TArray<FLinearColor>& OutRow) override
+		{
+			if(!File->Read(RowBuffer.GetData(), RowBuffer.Num()))
+				return false;
+			OutRow.SetNumUninitialized(Width);
+			for(int32 X = 0; X < Width; ++X)
+			{
+				const float Value = (RowBuffer[X * 2] | RowBuffer[X * 2 + 1] << 8) / 65535.0f;
+				OutRow[X] = FLinearColor(Value, Value, Value);
+			}
+			return true;
+		}
+
+	private:
+		TUniquePtr<IFileHandle> File;
+		TArray<uint8> RowBuffer;
+	};
+
+	/**
+	 * Decodes one row per call through libpng, expanded to 8 or 16 bit RGBA
+	 */
+	class FPngRowReader : public FRowReader
+	{
+	public:
+		virtual ~FPngRowReader() override
+		{
+			if(Png)
+				png_destroy_read_struct(&Png, Info ? &Info : nullptr, nullptr);
+		}
+
+		bool Open(TUniquePtr<IFileHandle>&& InFile, FText& OutError)
+		{
+			File = MoveTemp(InFile);
+			OutError = LOCTEXT("PngCorrupt", "The PNG file is damaged or not a PNG");
+			Png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, OnWarning);
+			Info = Png ? png_create_info_struct(Png) : nullptr;
+			if(!Info)
+				return false;
+			png_set_read_fn(Png, File.Get(), OnRead);
+			//libpng jumps back here on errors
+			if(setjmp(png_jmpbuf(Png)))
+				return false;
+			png_read_info(Png, Info);
+			//Interlaced rows only come together after the last pass, they can't be streamed
+			if(png_get_interlace_type(Png, Info) != PNG_INTERLACE_NONE)
+			{
+				OutError = LOCTEXT("PngInterlaced", "Interlaced PNGs can't be imported row by row, save the image without interlacing");
+				return false;
+			}
+			png_set_expand(Png);
+			png_set_gray_to_rgb(Png);
+			png_set_add_alpha(Png, 0xFFFF, PNG_FILLER_AFTER);
+			png_read_update_info(Png, Info);
+			Width = png_get_image_width(Png, Info);
+			Height = png_get_image_height(Png, Info);
+			Wide = png_get_bit_depth(Png, Info) == 16;
+			RowBuffer.SetNumUninitialized(png_get_rowbytes(Png, Info));
+			return true;
+		}
+
+		virtual bool ReadRow(TArray<FLinearColor>& OutRow) override
+		{
+			if(setjmp(png_jmpbuf(Png)))
+				return false;
+			png_read_row(Png, RowBuffer.GetData(), nullptr);
+			OutRow.SetNumUninitialized(Width);
+			const uint8* Pixel = RowBuffer.GetData();
+			for(int32 X = 0; X < Width; ++X)
+			{
+				//16 bit channels are big endian
+				float Channels[4];
+				for(float& Channel : Channels)
+				{
+					Channel = Wide ? (Pixel[0] << 8 | Pixel[1]) / 65535.0f : Pixel[0] / 255.0f;
+					Pixel += Wide ? 2 : 1;
+				}
+				OutRow[X] = FLinearColor(Channels[0], Channels[1], Channels[2], Channels[3]);
+			}
+			return true;
+		}
+
+	private:
+		static void OnRead(png_structp Png, png_bytep Data, png_size_t Length)
+		{
+			if(!static_cast<IFileHandle*>(png_get_io_ptr(Png))->Read(Data, Length))
+				png_error(Png, "Unexpected end of file");
+		}
+
+		static void OnWarning(png_structp Png, png_const_charp Message)
+		{
+		}
+
+		TUniquePtr<IFileHandle> File;
+		png_structp Png = nullptr;
+		png_infop Info = nullptr;
+		bool Wide = false;
+		TArray<uint8> RowBuffer;
+	};
+
+	/**
+	 * Decodes one scanline per call through OpenEXR, which only reads the chunk of the file holding it
+	 */
+	class FExrRowReader : public FRowReader
+	{
+	public:
+		bool Open(TUniquePtr<IFileHandle>&& InFile, const FString& Filename, FText& OutError)
+		{
+			OutError = FText::Format(LOCTEXT("ExrCorrupt", "Couldn't decode {0}, the EXR file is damaged or not an EXR"), FText::FromString(FPaths::GetCleanFilename(Filename)));
+			//OpenEXR reports errors by throwing
+			try
+			{
+				Stream = MakeUnique<FFileStream>(MoveTemp(InFile), TCHAR_TO_UTF8(*Filename));
+				File = MakeUnique<Imf::InputFile>(*Stream);
+				const Imath::Box2i DataWindow = File->header().dataWindow();
+				Width = DataWindow.max.x - DataWindow.min.x + 1;
+				Height = DataWindow.max.y - DataWindow.min.y + 1;
+				FirstRow = DataWindow.min.y;
+				const Imf::ChannelList& Channels = File->header().channels();
+				//Grayscale images only have luminance, it is spread over all three channels when read
+				Luminance = !Channels.findChannel("R") && !Channels.findChannel("G") && !Channels.findChannel("B") && Channels.findChannel("Y");
+				if(Width <= 0 || Height <= 0)
+					return false;
+
+				//Every scanline is decoded straight into the row, a y stride of 0 makes all of them land in the same place
+				RowBuffer.SetNumUninitialized(Width);
+				char* Base = reinterpret_cast<char*>(RowBuffer.GetData() - DataWindow.min.x);
+				const size_t Stride = sizeof(FLinearColor);
+				Imf::FrameBuffer FrameBuffer;
+				FrameBuffer.insert(Luminance ? "Y" : "R", Imf::Slice(Imf::FLOAT, Base + STRUCT_OFFSET(FLinearColor, R), Stride, 0, 1, 1, 0.0));
+				if(!Luminance)
+				{
+					FrameBuffer.insert("G", Imf::Slice(Imf::FLOAT, Base + STRUCT_OFFSET(FLinearColor, G), Stride, 0, 1, 1, 0.0));
+					FrameBuffer.insert("B", Imf::Slice(Imf::FLOAT, Base + STRUCT_OFFSET(FLinearColor, B), Stride, 0, 1, 1, 0.0));
+				}
+				FrameBuffer.insert("A", Imf::Slice(Imf::FLOAT, Base + STRUCT_OFFSET(FLinearColor, A), Stride, 0, 1, 1, 1.0));
+				File->setFrameBuffer(FrameBuffer);
+			}
+			catch(const std::exception&)
+			{
+				return false;
+			}
+			return true;
+		}
+
+		virtual bool ReadRow(TArray<FLinearColor>& OutRow) override
+		{
+			if(NextRow >= Height)
+				return false;
+			try
+			{
+				File->readPixels(FirstRow + NextRow, FirstRow + NextRow);
+			}
+			catch(const std::exception&)
+			{
+				return false;
+			}
+			++NextRow;
+			OutRow = RowBuffer;
+			if(Luminance)
+				for(FLinearColor& Pixel : OutRow)
+					Pixel.G = Pixel.B = Pixel.R;
+			return true;
+		}
+
+	private:
+		/**
+		 * Hands OpenEXR the file through the platform file layer instead of letting it open the file itself
+		 */
+		class FFileStream : public Imf::IStream
+		{
+		public:
+			FFileStream(TUniquePtr<IFileHandle>&& InFile, const char* Filename)
+				: Imf::IStream(Filename)
+				, File(MoveTemp(InFile))
+			{
+			}
+
+			virtual bool read(char Data[], int Length) override
+			{
+				if(!File->Read(reinterpret_cast<uint8*>(Data), Length))
+					throw Iex::InputExc("Unexpected end of file");
+				return File->Tell() < File->Size();
+			}
+			virtual uint64_t tellg() override { return File->Tell(); }
+			virtual void seekg(uint64_t Position) override { File->Seek(static_cast<int64>(Position)); }
+
+		private:
+			TUniquePtr<IFileHandle> File;
+		};
+
+		//The stream has to outlive the file reading from it
+		TUniquePtr<FFileStream> Stream;
+		TUniquePtr<Imf::InputFile> File;
+		TArray<FLinearColor> RowBuffer;
+		int32 FirstRow = 0;
+		int32 NextRow = 0;
+		bool Luminance = false;
+	};
+}
+
+TUniquePtr<GridPlacerImageImport::FRowReader> GridPlacerImageImport::OpenImage(const FString& Filename, int32 RawWidth, FText& OutError)
+{
+	const FString Extension = FPaths::GetExtension(Filename).ToLower();
+	if(Extension != TEXT("png") && Extension != TEXT("exr") && Extension != TEXT("r16") && Extension != TEXT("raw"))
+	{
+		OutError = LOCTEXT("UnknownFormat", "Only .png, .exr and 16 bit .r16 or .raw heightmaps can be imported");
+		return nullptr;
+	}
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if(!File)
+	{
+		OutError = FText::Format(LOCTEXT("OpenFailed", "Couldn't open {0}"), FText::FromString(Filename));
+		return nullptr;
+	}
+	if(Extension == TEXT("png"))
+	{
+		TUniquePtr<FPngRowReader> Reader = MakeUnique<FPngRowReader>();
+		if(!Reader->Open(MoveTemp(File), OutError))
+			return nullptr;
+		return MoveTemp(Reader);
+	}
+	if(Extension == TEXT("exr"))
+	{
+		TUniquePtr<FExrRowReader> Reader = MakeUnique<FExrRowReader>();
+		if(!Reader->Open(MoveTemp(File), Filename, OutError))
+			return nullptr;
+		return MoveTemp(Reader);
+	}
+	TUniquePtr<FRawRowReader> Reader = MakeUnique<FRawRowReader>();
+	if(!Reader->Open(MoveTemp(File), RawWidth, OutError))
+		return nullptr;
+	return MoveTemp(Reader);
+}
+
+#undef LOCTEXT_NAMESPACE
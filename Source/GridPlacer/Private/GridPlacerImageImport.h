@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Reads layout sketches and heightmaps one row of pixels at a time, so importing them never needs the whole image at once.
+ */
+namespace GridPlacerImageImport
+{
+	class FRowReader
+	{
+	public:
+		virtual ~FRowReader() {}
+
+		/** Reads the next row from top to bottom. Channels of 8 and 16 bit images are scaled to 0 to 1 */
+		virtual bool ReadRow(TArray<FLinearColor>& OutRow) = 0;
+
+		int32 GetWidth() const { return Width; }
+		int32 GetHeight() const { return Height; }
+		/*Raw heightmaps only hold brightness, their pixels are gray*/
+		bool HasColor() const { return Color; }
+
+	protected:
+		int32 Width = 0;
+		int32 Height = 0;
+		bool Color = true;
+	};
+
+	/**
+	 * Opens a .png, .exr or 16 bit little endian raw heightmap (.r16, .raw).
+	 * RawWidth is the width of a raw heightmap in pixels, 0 takes it as square.
+	 * Returns null and fills OutError if the file can't be read.
+	 */
+	TUniquePtr<FRowReader> OpenImage(const FString& Filename, int32 RawWidth, FText& OutError);
+}
@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerJournal.h"
+#include "HAL/FileManager.h"
+
+namespace
+{
+	constexpr uint32 JournalMagic = 0x314A5047; //GPJ1
+	/*Version 1 journals have no sections and save records, they read the same. Before version 3 erase records only held the id*/
+	constexpr uint32 JournalVersion = 3;
+	/*Buffered records are written out once they take up this many bytes, even if FlushInterval hasn't passed*/
+	constexpr int32 FlushSize = 64 * 1024;
+}
+
+void FGridPlacerJournal::Open(const FString& InFilename)
+{
+	Close();
+	Filename = InFilename;
+	LastFlushTime = FPlatformTime::Seconds();
+	SectionStarted = false;
+	LastErased = 0;
+}
+
+void FGridPlacerJournal::Close()
+{
+	Flush();
+	Writer.Reset();
+	Filename.Reset();
+	AssetIndices.Reset();
+}
+
+void FGridPlacerJournal::RecordPlace(uint32 Id, const UObject* Asset, const FIntVector& Cell, const FTransform& Transform, bool AsInstance, TArrayView<const float> CustomData)
+{
+	if(!IsOpen() || !Asset)
+		return;
+	BeginRecord();
+	const bool Replace = LastErased == Id;
+	LastErased = 0;
+	const int32 AssetIndex = WriteAsset(Asset);
+	Write(Replace ? ERecord::Replace : ERecord::Place);
+	Write(Id);
+	Write(AssetIndex);
+	Write(Cell);
+	WriteTransform(Transform);
+	Write(static_cast<uint8>(AsInstance));
+	const uint8 NumCustomData = static_cast<uint8>(FMath::Min(CustomData.Num(), static_cast<int32>(MAX_uint8)));
+	Write(NumCustomData);
+	Buffer.Append(reinterpret_cast<const uint8*>(CustomData.GetData()), NumCustomData * sizeof(float));
+	Tick();
+}
+
+void FGridPlacerJournal::RecordErase(uint32 Id, const UObject* Asset, const FTransform& Transform, bool AsInstance)
+{
+	if(!IsOpen() || !Asset)
+		return;
+	BeginRecord();
+	const int32 AssetIndex = WriteAsset(Asset);
+	Write(ERecord::Erase);
+	Write(Id);
+	Write(AssetIndex);
+	WriteTransform(Transform);
+	Write(static_cast<uint8>(AsInstance));
+	LastErased = Id;
+	Tick();
+}
+
+void FGridPlacerJournal::RecordSave()
+{
+	//A save before anything was recorded has nothing to cut off
+	if(!IsOpen() || !SectionStarted)
+		return;
+	Write(ERecord::Save);
+	LastErased = 0;
+	Flush();
+}
+
+void FGridPlacerJournal::BeginRecord()
+{
+	if(SectionStarted)
+		return;
+	SectionStarted = true;
+	Write(ERecord::Section);
+}
+
+int32 FGridPlacerJournal::WriteAsset(const UObject* Asset)
+{
+	const FSoftObjectPath AssetPath(Asset);
+	if(const int32* FoundIndex = AssetIndices.Find(AssetPath))
+		return *FoundIndex;
+	const FTCHARToUTF8 Path(*AssetPath.ToString());
+	Write(ERecord::Asset);
+	Write(Path.Length());
+	Buffer.Append(reinterpret_cast<const uint8*>(Path.Get()), Path.Length());
+	return AssetIndices.Add(AssetPath, AssetIndices.Num());
+}
+
+void FGridPlacerJournal::WriteTransform(const FTransform& Transform)
+{
+	Write(Transform.GetLocation());
+	Write(Transform.GetRotation());
+	Write(Transform.GetScale3D());
+}
+
+void FGridPlacerJournal::Tick()
+{
+	if(Buffer.Num() >= FlushSize || (Buffer.Num() > 0 && FPlatformTime::Seconds() - LastFlushTime >= FlushInterval))
+		Flush();
+}
+
+void FGridPlacerJournal::Flush()
+{
+	if(!IsOpen())
+		return;
+	LastFlushTime = FPlatformTime::Seconds();
+	if(Buffer.Num() == 0)
+		return;
+	if(!Writer)
+	{
+		Writer.Reset(IFileManager::Get().CreateFileWriter(*Filename, FILEWRITE_Append | FILEWRITE_AllowRead));
+		if(!Writer)
+			return;
+		if(Writer->TotalSize() == 0)
+		{
+			uint32 Header[2] = {JournalMagic, JournalVersion};
+			Writer->Serialize(Header, sizeof(Header));
+		}
+	}
+	Writer->Serialize(Buffer.GetData(), Buffer.Num());
+	Writer->Flush();
+	Buffer.Reset();
+}
+
+bool FGridPlacerJournal::Read(const FString& Filename, TArray<FEntry>& OutEntries, TArray<FEntry>& OutErased, int32& OutNumRecords)
+{
+	OutNumRecords = 0;
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename, FILEREAD_AllowWrite));
+	if(!Reader)
+		return false;
+	const int64 TotalSize = Reader->TotalSize();
+	//Reading past the end would only log errors, a record cut off by a crash simply ends the journal
+	auto ReadBytes = [&](void* Data, int64 Size)
+	{
+		if(Reader->Tell() + Size > TotalSize)
+			return false;
+		Reader->Serialize(Data, Size);
+		return !Reader->IsError();
+	};
+	uint32 Header[2];
+	if(!ReadBytes(Header, sizeof(Header)) || Header[0] != JournalMagic || Header[1] < 1 || Header[1] > JournalVersion)
+		return false;
+
+	const uint32 Version = Header[1];
+
+	TArray<FSoftObjectPath> Assets;
+	TMap<uint32, FEntry> Alive;
+	/*Items still alive at the end of earlier sections, their ids mean something else in later ones, erases find them by what they were*/
+	TArray<FEntry> Finished;
+	/*Erased items that were there before the journal placed anything*/
+	TArray<FEntry> Erased;
+	TArray<uint8> Path;
+	auto ReadTransform = [&](FTransform& OutTransform)
+	{
+		FVector Location;
+		FQuat Rotation;
+		FVector Scale;
+		if(!ReadBytes(&Location, sizeof(Location)) || !ReadBytes(&Rotation, sizeof(Rotation)) || !ReadBytes(&Scale, sizeof(Scale)))
+			return false;
+		OutTransform = FTransform(Rotation, Location, Scale);
+		return true;
+	};
+	for(;;)
+	{
+		ERecord Type;
+		if(!ReadBytes(&Type, sizeof(Type)))
+			break;
+		if(Type == ERecord::Asset)
+		{
+			int32 Length = 0;
+			if(!ReadBytes(&Length, sizeof(Length)) || Length < 0)
+				break;
+			Path.SetNumUninitialized(Length);
+			if(!ReadBytes(Path.GetData(), Length))
+				break;
+			Assets.Add(FSoftObjectPath(FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Path.GetData()), Length))));
+		}
+		else if(Type == ERecord::Place || Type == ERecord::Replace)
+		{
+			uint32 Id;
+			int32 AssetIndex;
+			FEntry Entry;
+			uint8 AsInstance;
+			uint8 NumCustomData;
+			if(!ReadBytes(&Id, sizeof(Id)) || !ReadBytes(&AssetIndex, sizeof(AssetIndex)) || !ReadBytes(&Entry.Cell, sizeof(Entry.Cell))
+				|| !ReadTransform(Entry.Transform) || !ReadBytes(&AsInstance, sizeof(AsInstance)) || !ReadBytes(&NumCustomData, sizeof(NumCustomData)))
+				break;
+			Entry.CustomData.SetNumUninitialized(NumCustomData);
+			if(!ReadBytes(Entry.CustomData.GetData(), NumCustomData * sizeof(float)) || !Assets.IsValidIndex(AssetIndex))
+				break;
+			Entry.Asset = Assets[AssetIndex];
+			Entry.AsInstance = AsInstance != 0;
+			Alive.Add(Id, MoveTemp(Entry));
+		}
+		else if(Type == ERecord::Erase)
+		{
+			uint32 Id;
+			if(!ReadBytes(&Id, sizeof(Id)))
+				break;
+			if(Version < 3)
+				Alive.Remove(Id);
+			else
+			{
+				int32 AssetIndex;
+				FEntry Entry;
+				uint8 AsInstance;
+				if(!ReadBytes(&AssetIndex, sizeof(AssetIndex)) || !ReadTransform(Entry.Transform) || !ReadBytes(&AsInstance, sizeof(AsInstance)) || !Assets.IsValidIndex(AssetIndex))
+					break;
+				Entry.Asset = Assets[AssetIndex];
+				Entry.AsInstance = AsInstance != 0;
+				//Placed in this section, placed in an earlier one or there before the journal started
+				if(Alive.Remove(Id) == 0)
+				{
+					const int32 FinishedIndex = Finished.IndexOfByPredicate([&Entry](const FEntry& Other)
+					{
+						return Other.Asset == Entry.Asset && Other.Transform.Equals(Entry.Transform, 0.01);
+					});
+					if(FinishedIndex != INDEX_NONE)
+						Finished.RemoveAtSwap(FinishedIndex);
+					else
+						Erased.Add(MoveTemp(Entry));
+				}
+			}
+		}
+		else if(Type == ERecord::Section)
+		{
+			for(TPair<uint32, FEntry>& Pair : Alive)
+				Finished.Add(MoveTemp(Pair.Value));
+			Alive.Reset();
+			Assets.Reset();
+		}
+		else if(Type == ERecord::Save)
+		{
+			Alive.Reset();
+			Finished.Reset();
+			Erased.Reset();
+		}
+		else
+			break;
+		++OutNumRecords;
+	}
+
+	OutEntries.Reserve(OutEntries.Num() + Finished.Num() + Alive.Num());
+	OutEntries.Append(MoveTemp(Finished));
+	for(TPair<uint32, FEntry>& Pair : Alive)
+		OutEntries.Add(MoveTemp(Pair.Value));
+	OutErased.Append(MoveTemp(Erased));
+	return true;
+}
@@ -0,0 +1,253 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerMeshMerge.h"
+
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "MeshDescription.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "UObject/Package.h"
+#include "Misc/PackageName.h"
+#include "Materials/MaterialInterface.h"
+
+namespace GridPlacerMeshMerge
+{
+	void FindRectangles(const TSet<FIntPoint>& Cells, TArray<FIntRect>& OutRectangles)
+	{
+		TArray<FIntPoint> Sorted = Cells.Array();
+		Sorted.Sort([](const FIntPoint& A, const FIntPoint& B) { return A.Y != B.Y ? A.Y < B.Y : A.X < B.X; });
+		TSet<FIntPoint> Used;
+		Used.Reserve(Sorted.Num());
+		const auto IsFree = [&Cells, &Used](const FIntPoint& Cell) { return Cells.Contains(Cell) && !Used.Contains(Cell); };
+		for(const FIntPoint& Start : Sorted)
+		{
+			if(Used.Contains(Start))
+				continue;
+			int32 Width = 1;
+			while(IsFree(FIntPoint(Start.X + Width, Start.Y)))
+				++Width;
+			int32 Height = 1;
+			for(bool RowFree = true; RowFree; )
+			{
+				for(int32 X = Start.X; X < Start.X + Width && RowFree; ++X)
+					RowFree = IsFree(FIntPoint(X, Start.Y + Height));
+				if(RowFree)
+					++Height;
+			}
+			for(int32 Y = Start.Y; Y < Start.Y + Height; ++Y)
+				for(int32 X = Start.X; X < Start.X + Width; ++X)
+					Used.Add(FIntPoint(X, Y));
+			OutRectangles.Add(FIntRect(Start.X, Start.Y, Start.X + Width, Start.Y + Height));
+		}
+	}
+
+	namespace
+	{
+		//Tiles can only merge if they would look the same when swapped
+		using FCoplanarKey = TTuple<UStaticMesh*, FIntVector, FIntVector, int32>;
+
+		FCoplanarKey MakeCoplanarKey(const FTile& Tile, const FGridPlacerFrame& Frame)
+		{
+			const FRotator Rotation = Tile.Transform.Rotator();
+			const FVector Scale = Tile.Transform.GetScale3D();
+			const double Height = Frame.GridToWorld.InverseTransformPosition(Tile.Transform.GetLocation()).Z;
+			return FCoplanarKey(Tile.Mesh,
+				FIntVector(FMath::RoundToInt32(Rotation.Pitch * 100.0), FMath::RoundToInt32(Rotation.Yaw * 100.0), FMath::RoundToInt32(Rotation.Roll * 100.0)),
+				FIntVector(FMath::RoundToInt32(Scale.X * 1000.0), FMath::RoundToInt32(Scale.Y * 1000.0), FMath::RoundToInt32(Scale.Z * 1000.0)),
+				FMath::RoundToInt32(Height * 100.0));
+		}
+
+		/** Transform of one copy of First stretched over all tiles from First to Last, both ends of a rectangle. OutStretch receives the stretch along the tile's local axes */
+		FTransform StretchTile(const FTile& First, const FTile& Last, const FIntRect& Rectangle, const FGridPlacerFrame& Frame, FVector& OutStretch)
+		{
+			const FVector LocalCenter = First.Mesh->GetBoundingBox().GetCenter();
+			const FVector FirstCenter = First.Transform.TransformPosition(LocalCenter);
+			const FVector Center = FirstCenter + (Last.Transform.GetLocation() - First.Transform.GetLocation()) * 0.5;
+			//Tiles are turned in quarter steps on the grid, so their X axis either runs along the grid's X or its Y
+			const FVector GridX = Frame.GridToWorld.GetUnitAxis(EAxis::X);
+			const bool AlongGridX = FMath::Abs(FVector::DotProduct(First.Transform.GetUnitAxis(EAxis::X), GridX)) > 0.5;
+			const FIntPoint Size = Rectangle.Size();
+			OutStretch = AlongGridX ? FVector(Size.X, Size.Y, 1.0) : FVector(Size.Y, Size.X, 1.0);
+
+			FTransform Stretched(First.Transform.GetRotation(), FVector::ZeroVector, First.Transform.GetScale3D() * OutStretch);
+			Stretched.SetTranslation(Center - Stretched.TransformVector(LocalCenter));
+			return Stretched;
+		}
+
+		/**
+		 * Copy of Source whose UVs keep their density once it is scaled by Stretch, so a stretched tile repeats its texture once per tile
+		 * instead of smearing it over the whole rectangle. The linear UV mapping of every triangle is carried on across the stretch,
+		 * starting at the minimum of Bounds so the first tile keeps its UVs. Vertex instances shared by several triangles follow the first one.
+		 */
+		FMeshDescription StretchUVs(const FMeshDescription& Source, const FBox& Bounds, const FVector& Stretch)
+		{
+			FMeshDescription Stretched = Source;
+			const FStaticMeshConstAttributes SourceAttributes(Source);
+			const TVertexAttributesConstRef<FVector3f> Positions = SourceAttributes.GetVertexPositions();
+			const TVertexInstanceAttributesConstRef<FVector2f> SourceUVs = SourceAttributes.GetVertexInstanceUVs();
+			TVertexInstanceAttributesRef<FVector2f> StretchedUVs = FStaticMeshAttributes(Stretched).GetVertexInstanceUVs();
+			const FVector3f Growth = FVector3f(Stretch) - FVector3f::OneVector;
+			const FVector3f Min = FVector3f(Bounds.Min);
+
+			TSet<FVertexInstanceID> Done;
+			for(const FTriangleID Triangle : Source.Triangles().GetElementIDs())
+			{
+				const TArrayView<const FVertexInstanceID> Corners = Source.GetTriangleVertexInstances(Triangle);
+				FVector3f Corner[3];
+				for(int32 i = 0; i < 3; ++i)
+					Corner[i] = Positions[Source.GetVertexInstanceVertex(Corners[i])];
+				const FVector3f Edge1 = Corner[1] - Corner[0];
+				const FVector3f Edge2 = Corner[2] - Corner[0];
+				const float E11 = Edge1 | Edge1;
+				const float E12 = Edge1 | Edge2;
+				const float E22 = Edge2 | Edge2;
+				const float Determinant = E11 * E22 - E12 * E12;
+				if(FMath::Abs(Determinant) < UE_SMALL_NUMBER)
+					continue;
+				for(int32 Channel = 0; Channel < SourceUVs.GetNumChannels(); ++Channel)
+				{
+					//Gradient of U and V in the triangle's plane: G.Edge1 = dUV1 and G.Edge2 = dUV2
+					const FVector2f DeltaUV1 = SourceUVs.Get(Corners[1], Channel) - SourceUVs.Get(Corners[0], Channel);
+					const FVector2f DeltaUV2 = SourceUVs.Get(Corners[2], Channel) - SourceUVs.Get(Corners[0], Channel);
+					const FVector2f A = (DeltaUV1 * E22 - DeltaUV2 * E12) / Determinant;
+					const FVector2f B = (DeltaUV2 * E11 - DeltaUV1 * E12) / Determinant;
+					const FVector3f GradientU = Edge1 * A.X + Edge2 * B.X;
+					const FVector3f GradientV = Edge1 * A.Y + Edge2 * B.Y;
+					for(int32 i = 0; i < 3; ++i)
+					{
+						if(Done.Contains(Corners[i]))
+							continue;
+						const FVector3f Offset = Growth * (Corner[i] - Min);
+						StretchedUVs.Set(Corners[i], Channel, SourceUVs.Get(Corners[i], Channel) + FVector2f(GradientU | Offset, GradientV | Offset));
+					}
+				}
+				for(int32 i = 0; i < 3; ++i)
+					Done.Add(Corners[i]);
+			}
+			return Stretched;
+		}
+
+		/*A copy of a tile in the merged mesh, Stretch is one for tiles that weren't merged*/
+		struct FPiece
+		{
+			int32 TileIndex = INDEX_NONE;
+			FTransform Transform;
+			FVector Stretch = FVector::OneVector;
+		};
+	}
+
+	UStaticMesh* BuildMergedMesh(TArrayView<const FTile> Tiles, const FGridPlacerFrame& Frame, const FTransform& Pivot, const FString& PackageName, int32& OutNumPieces)
+	{
+		OutNumPieces = 0;
+
+		//Group the tiles that may merge by what they look like, one cell each
+		TMap<FCoplanarKey, TMap<FIntPoint, int32>> CoplanarTiles;
+		TArray<FPiece> Pieces;
+		for(int32 TileIndex = 0; TileIndex < Tiles.Num(); ++TileIndex)
+		{
+			const FTile& Tile = Tiles[TileIndex];
+			if(!Tile.Mesh || !Tile.Mesh->GetMeshDescription(0))
+				continue;
+			const FIntVector Cell = Frame.WorldToCell(Tile.Transform.GetLocation());
+			const FGridPlacerCellBox Footprint = Frame.GetFootprint(Tile.Mesh->GetBoundingBox(), Tile.Transform);
+			if(Tile.MergeCoplanar && Footprint.Size().X == 1 && Footprint.Size().Y == 1)
+			{
+				TMap<FIntPoint, int32>& Cells = CoplanarTiles.FindOrAdd(MakeCoplanarKey(Tile, Frame));
+				if(!Cells.Contains(FIntPoint(Cell.X, Cell.Y)))
+				{
+					Cells.Add(FIntPoint(Cell.X, Cell.Y), TileIndex);
+					continue;
+				}
+			}
+			Pieces.Add({TileIndex, Tile.Transform});
+		}
+		TSet<FIntPoint> CellSet;
+		TArray<FIntRect> Rectangles;
+		for(const TPair<FCoplanarKey, TMap<FIntPoint, int32>>& Group : CoplanarTiles)
+		{
+			CellSet.Reset();
+			for(const TPair<FIntPoint, int32>& Cell : Group.Value)
+				CellSet.Add(Cell.Key);
+			Rectangles.Reset();
+			FindRectangles(CellSet, Rectangles);
+			for(const FIntRect& Rectangle : Rectangles)
+			{
+				const FTile& First = Tiles[Group.Value[Rectangle.Min]];
+				const FTile& Last = Tiles[Group.Value[Rectangle.Max - FIntPoint(1, 1)]];
+				FPiece& Piece = Pieces.AddDefaulted_GetRef();
+				Piece.TileIndex = Group.Value[Rectangle.Min];
+				Piece.Transform = StretchTile(First, Last, Rectangle, Frame, Piece.Stretch);
+			}
+		}
+		if(Pieces.Num() == 0)
+			return nullptr;
+
+		FMeshDescription MergedDescription;
+		FStaticMeshAttributes MergedAttributes(MergedDescription);
+		MergedAttributes.Register();
+		TPolygonGroupAttributesRef<FName> MergedSlotNames = MergedAttributes.GetPolygonGroupMaterialSlotNames();
+		TArray<FStaticMaterial> Materials;
+		TMap<UMaterialInterface*, FPolygonGroupID> MaterialGroups;
+
+		UStaticMesh* SourceMesh = nullptr;
+		FStaticMeshOperations::FAppendSettings AppendSettings;
+		//Polygon groups of every source mesh end up in one group per material
+		AppendSettings.PolygonGroupsDelegate = FAppendPolygonGroupsDelegate::CreateLambda([&SourceMesh, &Materials, &MaterialGroups, &MergedSlotNames]
+			(const FMeshDescription& Source, FMeshDescription& Target, PolygonGroupMap& RemapPolygonGroups)
+		{
+			const TPolygonGroupAttributesConstRef<FName> SourceSlotNames = FStaticMeshConstAttributes(Source).GetPolygonGroupMaterialSlotNames();
+			for(const FPolygonGroupID SourceGroup : Source.PolygonGroups().GetElementIDs())
+			{
+				const TArray<FStaticMaterial>& SourceMaterials = SourceMesh->GetStaticMaterials();
+				int32 MaterialIndex = SourceMaterials.IndexOfByPredicate([&](const FStaticMaterial& Material) { return Material.ImportedMaterialSlotName == SourceSlotNames[SourceGroup]; });
+				if(MaterialIndex == INDEX_NONE)
+					MaterialIndex = SourceGroup.GetValue();
+				UMaterialInterface* Material = SourceMaterials.IsValidIndex(MaterialIndex) ? SourceMaterials[MaterialIndex].MaterialInterface.Get() : nullptr;
+				FPolygonGroupID* TargetGroup = MaterialGroups.Find(Material);
+				if(!TargetGroup)
+				{
+					const FName SlotName(TEXT("Material"), Materials.Num());
+					TargetGroup = &MaterialGroups.Add(Material, Target.CreatePolygonGroup());
+					MergedSlotNames[*TargetGroup] = SlotName;
+					Materials.Add(FStaticMaterial(Material, SlotName, SlotName));
+				}
+				RemapPolygonGroups.Add(SourceGroup, *TargetGroup);
+			}
+		});
+		for(const FPiece& Piece : Pieces)
+		{
+			SourceMesh = Tiles[Piece.TileIndex].Mesh;
+			AppendSettings.MeshTransform = Piece.Transform.GetRelativeTransform(Pivot);
+			const FMeshDescription& SourceDescription = *SourceMesh->GetMeshDescription(0);
+			if(Piece.Stretch.Equals(FVector::OneVector))
+				FStaticMeshOperations::AppendMeshDescription(SourceDescription, MergedDescription, AppendSettings);
+			else
+				FStaticMeshOperations::AppendMeshDescription(StretchUVs(SourceDescription, SourceMesh->GetBoundingBox(), Piece.Stretch), MergedDescription, AppendSettings);
+		}
+		OutNumPieces = Pieces.Num();
+
+		UPackage* Package = CreatePackage(*PackageName);
+		Package->FullyLoad();
+		UStaticMesh* MergedMesh = NewObject<UStaticMesh>(Package, FName(*FPackageName::GetShortName(PackageName)), RF_Public | RF_Standalone);
+		MergedMesh->InitResources();
+		MergedMesh->SetLightingGuid();
+		FStaticMeshSourceModel& SourceModel = MergedMesh->AddSourceModel();
+		//Normals and tangents come from the tiles, only the lightmap has to be laid out for the whole chunk
+		SourceModel.BuildSettings.bRecomputeNormals = false;
+		SourceModel.BuildSettings.bRecomputeTangents = false;
+		SourceModel.BuildSettings.bGenerateLightmapUVs = true;
+		MergedMesh->SetStaticMaterials(Materials);
+		MergedMesh->CreateMeshDescription(0, MoveTemp(MergedDescription));
+		MergedMesh->CommitMeshDescription(0);
+		MergedMesh->CreateBodySetup();
+		MergedMesh->GetBodySetup()->CollisionTraceFlag = CTF_UseComplexAsSimple;
+		MergedMesh->Build(false);
+		MergedMesh->PostEditChange();
+		MergedMesh->MarkPackageDirty();
+		FAssetRegistryModule::AssetCreated(MergedMesh);
+		return MergedMesh;
+	}
+}
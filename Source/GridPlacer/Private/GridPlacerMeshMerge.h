@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridPlacerOccupancy.h"
+
+class UStaticMesh;
+
+/**
+ * Bakes placed grid tiles into a single static mesh.
+ * Neighboring tiles that share mesh, rotation, scale and height and are allowed to merge are greedily combined into
+ * rectangles, each drawn as one stretched copy of the tile whose UVs are carried on across the stretch, so textures repeat
+ * once per tile instead of being smeared. Everything else is copied as is.
+ */
+namespace GridPlacerMeshMerge
+{
+	struct FTile
+	{
+		UStaticMesh* Mesh = nullptr;
+		FTransform Transform;
+		/*The tile may be stretched over a rectangle of equal neighbors*/
+		bool MergeCoplanar = false;
+	};
+
+	/**
+	 * Covers Cells with as few rectangles as the greedy scan finds, row by row: every rectangle grows along X first, then along Y.
+	 * Rectangles are half open like FIntRect.
+	 */
+	void FindRectangles(const TSet<FIntPoint>& Cells, TArray<FIntRect>& OutRectangles);
+
+	/**
+	 * Merges Tiles into a new static mesh asset at PackageName, vertices relative to Pivot.
+	 * Returns null if no tile had source geometry. OutNumPieces receives how many copies of tiles the mesh is made of.
+	 */
+	UStaticMesh* BuildMergedMesh(TArrayView<const FTile> Tiles, const FGridPlacerFrame& Frame, const FTransform& Pivot, const FString& PackageName, int32& OutNumPieces);
+}
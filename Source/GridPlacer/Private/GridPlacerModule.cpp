@@ -2,6 +2,7 @@
 
 #include "GridPlacerModule.h"
 #include "GridPlacerEditorModeCommands.h"
+#include "GridPlacerStats.h"
 
 #define LOCTEXT_NAMESPACE "GridPlacerModule"
 
@@ -10,6 +11,7 @@ void FGridPlacerModule::StartupModule()
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 
 	FGridPlacerEditorModeCommands::Register();
+	GridPlacerStats::Startup();
 
 	FPropertyEditorModule& PropertyModule = FModuleManager::LoadModuleChecked<FPropertyEditorModule>("PropertyEditor");
 	PropertyModule.RegisterCustomPropertyTypeLayout(
@@ -25,6 +27,7 @@ void FGridPlacerModule::ShutdownModule()
 	FPropertyEditorModule& PropertyModule = FModuleManager::LoadModuleChecked<FPropertyEditorModule>("PropertyEditor");
 	PropertyModule.UnregisterCustomPropertyTypeLayout(FName("ObjectPalette"));
 
+	GridPlacerStats::Shutdown();
 	FGridPlacerEditorModeCommands::Unregister();
 }
 
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerStats.h"
+#include "Containers/Ticker.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+DEFINE_STAT(STAT_GridPlacer_Render);
+DEFINE_STAT(STAT_GridPlacer_UpdateGridSpace);
+DEFINE_STAT(STAT_GridPlacer_UpdatePlacementPoint);
+DEFINE_STAT(STAT_GridPlacer_SnapPlacementPointToGrid);
+DEFINE_STAT(STAT_GridPlacer_SpawnPaletteObject);
+DEFINE_STAT(STAT_GridPlacer_RealizePreview);
+DEFINE_STAT(STAT_GridPlacer_PaletteRebuild);
+DEFINE_STAT(STAT_GridPlacer_PlaceBatch);
+DEFINE_STAT(STAT_GridPlacer_RemoveBatch);
+DEFINE_STAT(STAT_GridPlacer_ReplaceBatch);
+DEFINE_STAT(STAT_GridPlacer_ProjectToSurface);
+DEFINE_STAT(STAT_GridPlacer_PathPreview);
+DEFINE_STAT(STAT_GridPlacer_CopyRegion);
+DEFINE_STAT(STAT_GridPlacer_SpawnQueue);
+DEFINE_STAT(STAT_GridPlacer_Consolidate);
+DEFINE_STAT(STAT_GridPlacer_MergeChunks);
+DEFINE_STAT(STAT_GridPlacer_HiddenCells);
+DEFINE_STAT(STAT_GridPlacer_SocketSnap);
+DEFINE_STAT(STAT_GridPlacer_Generate);
+DEFINE_STAT(STAT_GridPlacer_ImportImage);
+DEFINE_STAT(STAT_GridPlacer_ReplayJournal);
+
+DEFINE_STAT(STAT_GridPlacer_Spawns);
+DEFINE_STAT(STAT_GridPlacer_SpawnsPerSecond);
+DEFINE_STAT(STAT_GridPlacer_Traces);
+DEFINE_STAT(STAT_GridPlacer_PreviewUpdates);
+
+LLM_DEFINE_TAG(GridPlacer);
+
+TRACE_DECLARE_INT_COUNTER(GridPlacer_TracesPerFrame, TEXT("GridPlacer/Traces Per Frame"));
+TRACE_DECLARE_INT_COUNTER(GridPlacer_PreviewUpdatesPerFrame, TEXT("GridPlacer/Preview Updates Per Frame"));
+TRACE_DECLARE_FLOAT_COUNTER(GridPlacer_SpawnsPerSecond, TEXT("GridPlacer/Spawns Per Second"));
+
+namespace GridPlacerStats
+{
+	namespace
+	{
+		//Everything here is only touched from the game thread
+		int32 FrameTraces = 0;
+		int32 FramePreviewUpdates = 0;
+		int32 WindowSpawns = 0;
+		double WindowStart = 0.0;
+		double SpawnsPerSecond = 0.0;
+		FTSTicker::FDelegateHandle TickerHandle;
+
+		bool Tick(float DeltaTime)
+		{
+			TRACE_COUNTER_SET(GridPlacer_TracesPerFrame, FrameTraces);
+			TRACE_COUNTER_SET(GridPlacer_PreviewUpdatesPerFrame, FramePreviewUpdates);
+			FrameTraces = 0;
+			FramePreviewUpdates = 0;
+
+			const double Now = FPlatformTime::Seconds();
+			if(Now - WindowStart >= 1.0)
+			{
+				SpawnsPerSecond = WindowSpawns / (Now - WindowStart);
+				TRACE_COUNTER_SET(GridPlacer_SpawnsPerSecond, SpawnsPerSecond);
+				WindowSpawns = 0;
+				WindowStart = Now;
+			}
+			//Counter stats are cleared every frame
+			SET_FLOAT_STAT(STAT_GridPlacer_SpawnsPerSecond, SpawnsPerSecond);
+			return true;
+		}
+	}
+
+	void RecordSpawns(int32 NumSpawns)
+	{
+		INC_DWORD_STAT_BY(STAT_GridPlacer_Spawns, NumSpawns);
+		WindowSpawns += NumSpawns;
+	}
+
+	void RecordTrace(int32 NumTraces)
+	{
+		INC_DWORD_STAT_BY(STAT_GridPlacer_Traces, NumTraces);
+		FrameTraces += NumTraces;
+	}
+
+	void RecordPreviewUpdate()
+	{
+		INC_DWORD_STAT(STAT_GridPlacer_PreviewUpdates);
+		++FramePreviewUpdates;
+	}
+
+	void Startup()
+	{
+		WindowStart = FPlatformTime::Seconds();
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Tick));
+	}
+
+	void Shutdown()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+}
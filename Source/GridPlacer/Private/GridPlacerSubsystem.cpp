@@ -0,0 +1,1395 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerSubsystem.h"
+#include "GridPlacerChanges.h"
+#include "GridPlacerStats.h"
+#include "GridPlacerCellData.h"
+
+#include "Editor.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/ITransaction.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/ObjectSaveContext.h"
+
+#define LOCTEXT_NAMESPACE "GridPlacerSubsystem"
+
+const FName UGridPlacerSubsystem::PlacedActorTag = FName("GridPlacer");
+const FName UGridPlacerSubsystem::InstanceHostTag = FName("GridPlacerInstances");
+const FName UGridPlacerSubsystem::ConsolidatedComponentTag = FName("GridPlacerConsolidated");
+
+namespace
+{
+	void SetActorCustomData(AActor* Actor, TArrayView<const float> CustomData)
+	{
+		if(CustomData.Num() == 0)
+			return;
+		//Defaults are what gets saved with the level, the runtime values start out as a copy of them
+		Actor->ForEachComponent<UPrimitiveComponent>(false, [CustomData](UPrimitiveComponent* Component)
+		{
+			for(int32 DataIndex = 0; DataIndex < CustomData.Num(); ++DataIndex)
+				if(!FMath::IsNaN(CustomData[DataIndex]))
+					Component->SetDefaultCustomPrimitiveDataFloat(DataIndex, CustomData[DataIndex]);
+		});
+	}
+}
+
+void UGridPlacerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if(GEngine)
+	{
+		LevelActorAddedHandle = GEngine->OnLevelActorAdded().AddUObject(this, &UGridPlacerSubsystem::OnLevelActorAdded);
+		LevelActorDeletedHandle = GEngine->OnLevelActorDeleted().AddUObject(this, &UGridPlacerSubsystem::OnLevelActorDeleted);
+		ActorMovedHandle = GEngine->OnActorMoved().AddUObject(this, &UGridPlacerSubsystem::OnActorMoved);
+	}
+	if(GEditor)
+		GEditor->RegisterForUndo(this);
+	PostSaveWorldHandle = FEditorDelegates::PostSaveWorldWithContext.AddUObject(this, &UGridPlacerSubsystem::OnPostSaveWorld);
+}
+
+void UGridPlacerSubsystem::Deinitialize()
+{
+	//The world is going away together with everything a queued batch placed, there is nothing left to roll back
+	SpawnJobs.Reset();
+	FTSTicker::GetCoreTicker().RemoveTicker(SpawnTickerHandle);
+	SpawnTickerHandle.Reset();
+	if(TSharedPtr<SNotificationItem> Notification = SpawnNotification.Pin())
+		Notification->ExpireAndFadeout();
+
+	StopJournal();
+	FEditorDelegates::PostSaveWorldWithContext.Remove(PostSaveWorldHandle);
+
+	if(GEditor)
+		GEditor->UnregisterForUndo(this);
+	if(GEngine)
+	{
+		GEngine->OnLevelActorAdded().Remove(LevelActorAddedHandle);
+		GEngine->OnLevelActorDeleted().Remove(LevelActorDeletedHandle);
+		GEngine->OnActorMoved().Remove(ActorMovedHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+bool UGridPlacerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Editor;
+}
+
+TArray<uint32> UGridPlacerSubsystem::PlaceBatch(TArrayView<const FGridPlacerSpawnRequest> Requests, const FText& Description)
+{
+	GRIDPLACER_SCOPE(PlaceBatch);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	TArray<uint32> NewIds;
+	if(Requests.Num() == 0)
+		return NewIds;
+	EnsureRegistry();
+	NewIds.Reserve(Requests.Num());
+
+	TUniquePtr<FGridPlacerPlacementChange> Change = MakeUnique<FGridPlacerPlacementChange>(FGridPlacerPlacementChange::EKind::Added);
+	{
+		//Keep the spawns themselves out of the transaction, the change is all that's needed to undo them
+		TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+		SpawnRequests(Requests, *Change, NewIds);
+	}
+	if(Change->Num() > 0)
+		StoreChange(MoveTemp(Change), Description);
+	return NewIds;
+}
+
+void UGridPlacerSubsystem::SpawnRequests(TArrayView<const FGridPlacerSpawnRequest> Requests, FGridPlacerPlacementChange& Change, TArray<uint32>& OutIds)
+{
+	const int32 NumIdsBefore = OutIds.Num();
+	//Instances of the same mesh go into their component with a single AddInstances call
+	TMap<UInstancedStaticMeshComponent*, TArray<int32>> InstanceRequests;
+	for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		const FGridPlacerSpawnRequest& Request = Requests[RequestIndex];
+		if(UInstancedStaticMeshComponent* Component = Request.AsInstance ? GetRequestComponent(Request) : nullptr)
+		{
+			InstanceRequests.FindOrAdd(Component).Add(RequestIndex);
+			continue;
+		}
+		if(const uint32 Id = SpawnItem(Request))
+		{
+			Change.AddRecord(Id, Request);
+			OutIds.Add(Id);
+		}
+	}
+	TArray<FTransform> Transforms;
+	for(const TPair<UInstancedStaticMeshComponent*, TArray<int32>>& Pending : InstanceRequests)
+	{
+		UInstancedStaticMeshComponent* Component = Pending.Key;
+		Transforms.Reset(Pending.Value.Num());
+		for(const int32 RequestIndex : Pending.Value)
+			Transforms.Add(Requests[RequestIndex].Transform);
+		const int32 FirstIndex = Component->GetInstanceCount();
+		Component->AddInstances(Transforms, false, true);
+		bool HasCustomData = false;
+		for(int32 i = 0; i < Pending.Value.Num(); ++i)
+		{
+			const FGridPlacerSpawnRequest& Request = Requests[Pending.Value[i]];
+			//Custom data goes first, so whoever listens to OnItemAdded sees the final values
+			if(Request.CustomData.Num() > 0)
+			{
+				SetInstanceCustomData(Component, FirstIndex + i, Request.CustomData);
+				HasCustomData = true;
+			}
+			const uint32 Id = RegisterInstance(Component, FirstIndex + i, 0);
+			Change.AddRecord(Id, Request);
+			OutIds.Add(Id);
+		}
+		if(HasCustomData)
+			Component->MarkRenderStateDirty();
+		Component->MarkPackageDirty();
+	}
+	GridPlacerStats::RecordSpawns(OutIds.Num() - NumIdsBefore);
+}
+
+void UGridPlacerSubsystem::PlaceBatchTimeSliced(TArray<FGridPlacerSpawnRequest>&& Requests, const FText& Description, const FVector& PriorityLocation, float BudgetMs)
+{
+	if(Requests.Num() == 0)
+		return;
+	EnsureRegistry();
+	LLM_SCOPE_BYTAG(GridPlacer);
+
+	FSpawnJob& Job = AddSpawnJob(Description, BudgetMs);
+	Job.Requests = MoveTemp(Requests);
+	//Whatever the user is looking at shows up first
+	Job.Requests.Sort([&PriorityLocation](const FGridPlacerSpawnRequest& A, const FGridPlacerSpawnRequest& B)
+	{
+		return FVector::DistSquared(A.Transform.GetLocation(), PriorityLocation) < FVector::DistSquared(B.Transform.GetLocation(), PriorityLocation);
+	});
+	Job.Ids.Reserve(Job.Requests.Num());
+	TSet<UObject*> Assets;
+	for(const FGridPlacerSpawnRequest& Request : Job.Requests)
+		Assets.Add(Request.Asset);
+	Job.Assets = Assets.Array();
+	UpdateSpawnNotification();
+}
+
+void UGridPlacerSubsystem::PlaceStreamTimeSliced(TUniqueFunction<bool(TArray<FGridPlacerSpawnRequest>&)>&& Refill, TArrayView<UObject* const> Sources, const FText& Description, float BudgetMs)
+{
+	if(!Refill)
+		return;
+	EnsureRegistry();
+	LLM_SCOPE_BYTAG(GridPlacer);
+
+	//The first requests are asked for on the first tick, like all later ones
+	FSpawnJob& Job = AddSpawnJob(Description, BudgetMs);
+	Job.Refill = MoveTemp(Refill);
+	for(UObject* Source : Sources)
+		Job.Sources.Add(Source);
+	UpdateSpawnNotification();
+}
+
+UGridPlacerSubsystem::FSpawnJob& UGridPlacerSubsystem::AddSpawnJob(const FText& Description, float BudgetMs)
+{
+	FSpawnJob& Job = SpawnJobs.AddDefaulted_GetRef();
+	Job.BudgetMs = FMath::Max(BudgetMs, 1.0f);
+	Job.Description = Description;
+	Job.Change = MakeUnique<FGridPlacerPlacementChange>(FGridPlacerPlacementChange::EKind::Added);
+
+	if(!SpawnTickerHandle.IsValid())
+		SpawnTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UGridPlacerSubsystem::TickSpawnQueue));
+	if(!SpawnNotification.IsValid())
+	{
+		FNotificationInfo Info(Description);
+		Info.bFireAndForget = false;
+		Info.bUseThrobber = true;
+		Info.ExpireDuration = 2.0f;
+		Info.ButtonDetails.Add(FNotificationButtonInfo(LOCTEXT("CancelQueuedPlacements", "Cancel"), LOCTEXT("CancelQueuedPlacementsTooltip", "Stop placing and remove everything placed so far"),
+			FSimpleDelegate::CreateUObject(this, &UGridPlacerSubsystem::CancelQueuedPlacements), SNotificationItem::CS_Pending));
+		SpawnNotification = FSlateNotificationManager::Get().AddNotification(Info);
+		if(TSharedPtr<SNotificationItem> Notification = SpawnNotification.Pin())
+			Notification->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+	return Job;
+}
+
+bool UGridPlacerSubsystem::TickSpawnQueue(float DeltaTime)
+{
+	GRIDPLACER_SCOPE(SpawnQueue);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	if(SpawnJobs.Num() > 0)
+	{
+		FSpawnJob& Job = SpawnJobs[0];
+		//Slices are small enough to stay close to the budget and big enough for instances to be added in bulk
+		constexpr int32 SliceSize = 256;
+		const double EndTime = FPlatformTime::Seconds() + Job.BudgetMs / 1000.0;
+		{
+			TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+			do
+			{
+				if(Job.NumProcessed >= Job.Requests.Num())
+				{
+					Job.NumRefilled += Job.Requests.Num();
+					Job.Requests.Reset();
+					Job.NumProcessed = 0;
+					if(!Job.Refill(Job.Requests))
+						Job.Refill = nullptr;
+					TSet<UObject*> Assets;
+					for(const FGridPlacerSpawnRequest& Request : Job.Requests)
+						Assets.Add(Request.Asset);
+					Job.Assets = Assets.Array();
+					continue;
+				}
+				const int32 NumInSlice = FMath::Min(SliceSize, Job.Requests.Num() - Job.NumProcessed);
+				SpawnRequests(MakeArrayView(Job.Requests).Slice(Job.NumProcessed, NumInSlice), *Job.Change, Job.Ids);
+				Job.NumProcessed += NumInSlice;
+			}
+			while((Job.NumProcessed < Job.Requests.Num() || Job.Refill) && FPlatformTime::Seconds() < EndTime);
+		}
+		if(Job.NumProcessed >= Job.Requests.Num() && !Job.Refill)
+		{
+			if(Job.Change->Num() > 0)
+				StoreChange(MoveTemp(Job.Change), Job.Description);
+			SpawnJobs.RemoveAt(0);
+		}
+	}
+	UpdateSpawnNotification();
+	if(SpawnJobs.Num() > 0)
+		return true;
+	SpawnTickerHandle.Reset();
+	return false;
+}
+
+void UGridPlacerSubsystem::CancelQueuedPlacements()
+{
+	if(SpawnJobs.Num() == 0)
+		return;
+	GRIDPLACER_SCOPE(RemoveBatch);
+	int32 NumRemoved = 0;
+	{
+		TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+		//Nothing of a cancelled batch made it into the undo history yet, so removing it leaves no trace
+		for(const FSpawnJob& Job : SpawnJobs)
+			for(const uint32 Id : Job.Ids)
+				NumRemoved += RemoveItem(Id) ? 1 : 0;
+	}
+	SpawnJobs.Reset();
+	FTSTicker::GetCoreTicker().RemoveTicker(SpawnTickerHandle);
+	SpawnTickerHandle.Reset();
+	if(TSharedPtr<SNotificationItem> Notification = SpawnNotification.Pin())
+	{
+		Notification->SetText(FText::Format(LOCTEXT("QueuedPlacementsCancelled", "Cancelled, removed {0} objects again"), NumRemoved));
+		Notification->SetCompletionState(SNotificationItem::CS_Fail);
+		Notification->ExpireAndFadeout();
+	}
+	SpawnNotification.Reset();
+}
+
+void UGridPlacerSubsystem::UpdateSpawnNotification()
+{
+	TSharedPtr<SNotificationItem> Notification = SpawnNotification.Pin();
+	if(!Notification)
+		return;
+	if(SpawnJobs.Num() == 0)
+	{
+		Notification->SetText(LOCTEXT("QueuedPlacementsDone", "Placed all queued objects"));
+		Notification->SetCompletionState(SNotificationItem::CS_Success);
+		Notification->ExpireAndFadeout();
+		SpawnNotification.Reset();
+		return;
+	}
+	int32 NumProcessed = 0;
+	int32 NumTotal = 0;
+	bool Streaming = false;
+	for(const FSpawnJob& Job : SpawnJobs)
+	{
+		NumProcessed += Job.NumRefilled + Job.NumProcessed;
+		NumTotal += Job.NumRefilled + Job.Requests.Num();
+		Streaming |= static_cast<bool>(Job.Refill);
+	}
+	//Streamed jobs don't know how much is still to come
+	if(Streaming || NumTotal == 0)
+		Notification->SetText(FText::Format(LOCTEXT("QueuedPlacementsStreaming", "{0}: {1} placed"), SpawnJobs[0].Description, NumProcessed));
+	else
+		Notification->SetText(FText::Format(LOCTEXT("QueuedPlacementsProgress", "{0}: {1} / {2} ({3}%)"),
+			SpawnJobs[0].Description, NumProcessed, NumTotal, FMath::FloorToInt32(100.0 * NumProcessed / NumTotal)));
+}
+
+void UGridPlacerSubsystem::StartJournal(const FGridPlacerFrame& Frame)
+{
+	JournalFrame = Frame;
+	if(Journal.IsOpen())
+		return;
+	//Whatever was placed before is part of the level already, building the registry now keeps it out of the journal
+	EnsureRegistry();
+	Journal.Open(GetJournalFilename());
+	JournalItemAddedHandle = OnItemAdded.AddUObject(this, &UGridPlacerSubsystem::OnJournalItemAdded);
+	JournalItemRemovedHandle = OnItemRemoved.AddUObject(this, &UGridPlacerSubsystem::OnJournalItemRemoved);
+	JournalTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UGridPlacerSubsystem::TickJournal), FGridPlacerJournal::FlushInterval);
+}
+
+void UGridPlacerSubsystem::StopJournal()
+{
+	if(!Journal.IsOpen())
+		return;
+	Journal.Close();
+	OnItemAdded.Remove(JournalItemAddedHandle);
+	OnItemRemoved.Remove(JournalItemRemovedHandle);
+	FTSTicker::GetCoreTicker().RemoveTicker(JournalTickerHandle);
+	JournalTickerHandle.Reset();
+}
+
+FString UGridPlacerSubsystem::GetJournalDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("GridPlacer") / TEXT("Journals");
+}
+
+FString UGridPlacerSubsystem::GetJournalFilename() const
+{
+	//The start of the session sorts the journals of a level from oldest to newest, the process id tells sessions started at once apart
+	static const FString Session = FString::Printf(TEXT("%s_%u"), *FDateTime::Now().ToString(), FPlatformProcess::GetCurrentProcessId());
+	return GetJournalDirectory() / FString::Printf(TEXT("%s_%s.gpjournal"), *GetWorld()->GetMapName(), *Session);
+}
+
+TArray<FString> UGridPlacerSubsystem::FindUnsavedJournals() const
+{
+	const UWorld* World = GetWorld();
+	TArray<FString> Journals;
+	IFileManager::Get().FindFiles(Journals, *(GetJournalDirectory() / (World->GetMapName() + TEXT("_*.gpjournal"))), true, false);
+	Journals.Sort();
+	//Journals older than the map file only hold what the save already has
+	FString MapFilename;
+	const FDateTime SavedTime = FPackageName::TryConvertLongPackageNameToFilename(World->GetPackage()->GetName(), MapFilename, FPackageName::GetMapPackageExtension())
+		? IFileManager::Get().GetTimeStamp(*MapFilename)
+		: FDateTime::MinValue();
+	TArray<FString> Unsaved;
+	for(const FString& Journal : Journals)
+	{
+		const FString JournalFilename = GetJournalDirectory() / Journal;
+		if(IFileManager::Get().GetTimeStamp(*JournalFilename) > SavedTime)
+			Unsaved.Add(JournalFilename);
+	}
+	return Unsaved;
+}
+
+bool UGridPlacerSubsystem::TickJournal(float DeltaTime)
+{
+	Journal.Tick();
+	return true;
+}
+
+void UGridPlacerSubsystem::OnJournalItemAdded(const FGridPlacerPlacedItem& Item)
+{
+	Journal.RecordPlace(Item.Id, Item.Asset.Get(), JournalFrame.WorldToCell(Item.Transform.GetLocation()), Item.Transform, Item.IsInstance(), GetItemCustomData(Item));
+}
+
+void UGridPlacerSubsystem::OnJournalItemRemoved(const FGridPlacerPlacedItem& Item)
+{
+	Journal.RecordErase(Item.Id, Item.Asset.Get(), Item.Transform, Item.IsInstance());
+}
+
+void UGridPlacerSubsystem::OnPostSaveWorld(UWorld* World, FObjectPostSaveContext Context)
+{
+	if(World == GetWorld() && Context.SaveSucceeded())
+		Journal.RecordSave();
+}
+
+void UGridPlacerSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+	UGridPlacerSubsystem* This = CastChecked<UGridPlacerSubsystem>(InThis);
+	for(FSpawnJob& Job : This->SpawnJobs)
+	{
+		Collector.AddReferencedObjects(Job.Assets);
+		Collector.AddReferencedObjects(Job.Sources);
+	}
+}
+
+void UGridPlacerSubsystem::RemoveBatch(TArrayView<const uint32> Ids, const FText& Description)
+{
+	GRIDPLACER_SCOPE(RemoveBatch);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	TUniquePtr<FGridPlacerPlacementChange> Change = MakeUnique<FGridPlacerPlacementChange>(FGridPlacerPlacementChange::EKind::Removed);
+	{
+		TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+		for(const uint32 Id : Ids)
+		{
+			FGridPlacerSpawnRequest RemovedRequest;
+			if(RemoveItem(Id, &RemovedRequest))
+				Change->AddRecord(Id, RemovedRequest);
+		}
+	}
+	if(Change->Num() > 0)
+		StoreChange(MoveTemp(Change), Description);
+}
+
+int32 UGridPlacerSubsystem::ReplaceBatch(TArrayView<const FGridPlacerReplaceRequest> Requests, const FText& Description)
+{
+	GRIDPLACER_SCOPE(ReplaceBatch);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	TArray<FGridPlacerReplaceRequest> Previous;
+	{
+		TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+		ReplaceItems(Requests, &Previous);
+	}
+	if(Previous.Num() == 0)
+		return 0;
+
+	TUniquePtr<FGridPlacerReplaceChange> Change = MakeUnique<FGridPlacerReplaceChange>();
+	for(const FGridPlacerReplaceRequest& Replaced : Previous)
+		if(const FGridPlacerPlacedItem* Item = Items.Find(Replaced.Id))
+			Change->AddRecord(Replaced.Id, Replaced.Asset, Item->Asset.Get());
+	const int32 NumReplaced = Change->Num();
+	StoreChange(MoveTemp(Change), Description);
+	return NumReplaced;
+}
+
+void UGridPlacerSubsystem::StoreChange(TUniquePtr<FCommandChange> Change, const FText& Description)
+{
+	if(!GEditor)
+		return;
+	//Nested calls (e.g. a replace that removes and places) end up in the outermost transaction
+	GEditor->BeginTransaction(Description);
+	if(GUndo)
+		GUndo->StoreUndo(GetWorld()->PersistentLevel, MoveTemp(Change));
+	GEditor->EndTransaction();
+}
+
+uint32 UGridPlacerSubsystem::SpawnItem(const FGridPlacerSpawnRequest& Request, uint32 ForcedId)
+{
+	EnsureRegistry();
+
+	UWorld* World = GetWorld();
+	if(!World || !Request.Asset)
+		return 0;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.OverrideLevel = World->GetCurrentLevel();
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	if(UStaticMesh* StaticMesh = Cast<UStaticMesh>(Request.Asset))
+	{
+		if(Request.AsInstance)
+		{
+			UInstancedStaticMeshComponent* Component = GetRequestComponent(Request);
+			if(!Component)
+				return 0;
+			const int32 InstanceIndex = Component->AddInstance(Request.Transform, true);
+			if(Request.CustomData.Num() > 0)
+			{
+				SetInstanceCustomData(Component, InstanceIndex, Request.CustomData);
+				Component->MarkRenderStateDirty();
+			}
+			Component->MarkPackageDirty();
+			return RegisterInstance(Component, InstanceIndex, ForcedId);
+		}
+		SpawnParams.Name = MakeUniqueObjectName(SpawnParams.OverrideLevel, AStaticMeshActor::StaticClass(), StaticMesh->GetFName());
+		AStaticMeshActor* SpawnedActor = nullptr;
+		{
+			TGuardValue<bool> MutatingGuard(IsMutating, true);
+			SpawnedActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Request.Transform, SpawnParams);
+		}
+		if(!SpawnedActor)
+			return 0;
+		SpawnedActor->GetStaticMeshComponent()->SetStaticMesh(StaticMesh);
+		SpawnedActor->GetStaticMeshComponent()->SetCanEverAffectNavigation(false);
+		SetActorCustomData(SpawnedActor, Request.CustomData);
+		SpawnedActor->Tags.AddUnique(PlacedActorTag);
+		SpawnedActor->MarkPackageDirty();
+		return RegisterActor(SpawnedActor, StaticMesh, ForcedId);
+	}
+	if(UClass* ActorClass = Cast<UClass>(Request.Asset))
+	{
+		if(!ActorClass->IsChildOf(AActor::StaticClass()))
+			return 0;
+		SpawnParams.Name = MakeUniqueObjectName(SpawnParams.OverrideLevel, ActorClass, ActorClass->GetFName());
+		AActor* SpawnedActor = nullptr;
+		{
+			//Classes that carry the tag themselves would otherwise be registered by OnLevelActorAdded as well
+			TGuardValue<bool> MutatingGuard(IsMutating, true);
+			SpawnedActor = World->SpawnActor<AActor>(ActorClass, Request.Transform, SpawnParams);
+		}
+		if(!SpawnedActor)
+			return 0;
+		SetActorCustomData(SpawnedActor, Request.CustomData);
+		SpawnedActor->Tags.AddUnique(PlacedActorTag);
+		SpawnedActor->MarkPackageDirty();
+		return RegisterActor(SpawnedActor, ActorClass, ForcedId);
+	}
+	return 0;
+}
+
+bool UGridPlacerSubsystem::RemoveItem(uint32 Id, FGridPlacerSpawnRequest* OutRequest)
+{
+	EnsureRegistry();
+
+	FGridPlacerPlacedItem* Item = Items.Find(Id);
+	if(!Item)
+		return false;
+
+	if(OutRequest)
+	{
+		OutRequest->Asset = Item->Asset.Get();
+		OutRequest->Transform = Item->Actor.IsValid() ? Item->Actor->GetActorTransform() : Item->Transform;
+		OutRequest->AsInstance = Item->IsInstance();
+		OutRequest->Component = Item->Component;
+		OutRequest->CustomData = GetItemCustomData(*Item);
+	}
+
+	if(Item->IsInstance())
+	{
+		if(UInstancedStaticMeshComponent* Component = Item->Component.Get())
+		{
+			RemoveInstanceAtSwap(Component, Item->InstanceIndex);
+			Component->MarkPackageDirty();
+		}
+	}
+	else if(AActor* Actor = Item->Actor.Get())
+	{
+		TGuardValue<bool> MutatingGuard(IsMutating, true);
+		Actor->MarkPackageDirty();
+		GetWorld()->EditorDestroyActor(Actor, true);
+	}
+	UnregisterItem(Id);
+	return true;
+}
+
+int32 UGridPlacerSubsystem::ReplaceItems(TArrayView<const FGridPlacerReplaceRequest> Requests, TArray<FGridPlacerReplaceRequest>* OutPrevious)
+{
+	EnsureRegistry();
+
+	int32 NumReplaced = 0;
+	//Instances switching meshes are collected per target component and added in one go at the end
+	TMap<UInstancedStaticMeshComponent*, TArray<FPendingInstance>> PendingInstances;
+	for(const FGridPlacerReplaceRequest& Request : Requests)
+	{
+		FGridPlacerPlacedItem* Item = Items.Find(Request.Id);
+		if(!Item || !Item->IsValid() || !Request.Asset || Item->Asset.Get() == Request.Asset)
+			continue;
+		UObject* PreviousAsset = Item->Asset.Get();
+		UStaticMesh* NewMesh = Cast<UStaticMesh>(Request.Asset);
+		AStaticMeshActor* MeshActor = Cast<AStaticMeshActor>(Item->Actor.Get());
+		if(Item->IsInstance() && NewMesh)
+		{
+			//Move the instance over to the component of the new mesh, no actor is involved at all
+			UInstancedStaticMeshComponent* Target = FindOrCreateInstanceComponent(NewMesh);
+			if(!Target)
+				continue;
+			FPendingInstance Pending{Request.Id, Item->Transform, GetItemCustomData(*Item)};
+			UInstancedStaticMeshComponent* Source = Item->Component.Get();
+			RemoveInstanceAtSwap(Source, Item->InstanceIndex);
+			Source->MarkPackageDirty();
+			UnregisterItem(Request.Id);
+			PendingInstances.FindOrAdd(Target).Add(MoveTemp(Pending));
+		}
+		else if(NewMesh && MeshActor && MeshActor->GetClass() == AStaticMeshActor::StaticClass())
+		{
+			//Plain static mesh actors keep their actor and only get a different mesh
+			UnregisterItem(Request.Id);
+			MeshActor->GetStaticMeshComponent()->SetStaticMesh(NewMesh);
+			MeshActor->MarkPackageDirty();
+			RegisterActor(MeshActor, NewMesh, Request.Id);
+		}
+		else
+		{
+			//Actor classes can only be swapped by spawning the new class in place
+			FGridPlacerSpawnRequest SpawnRequest;
+			if(!RemoveItem(Request.Id, &SpawnRequest))
+				continue;
+			SpawnRequest.Asset = Request.Asset;
+			SpawnRequest.AsInstance = SpawnRequest.AsInstance && NewMesh != nullptr;
+			SpawnItem(SpawnRequest, Request.Id);
+		}
+		if(OutPrevious)
+			OutPrevious->Add({Request.Id, PreviousAsset});
+		++NumReplaced;
+	}
+
+	for(const TPair<UInstancedStaticMeshComponent*, TArray<FPendingInstance>>& Pending : PendingInstances)
+		AddInstancesWithIds(Pending.Key, Pending.Value);
+	return NumReplaced;
+}
+
+namespace
+{
+	void AddConsolidateStats(FGridPlacerConsolidateStats& Stats, UStaticMeshComponent* Component)
+	{
+		++Stats.NumComponents;
+		if(const UStaticMesh* Mesh = Component->GetStaticMesh())
+			Stats.NumDrawCalls += Mesh->GetNumSections(0);
+		Stats.MemoryBytes += Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+}
+
+int32 UGridPlacerSubsystem::ConsolidateActors(TArrayView<UStaticMesh* const> Meshes, const FGridPlacerFrame& Frame, const FGridPlacerCellBox& Region, int32 ChunkSize,
+	const FText& Description, FGridPlacerConsolidateStats& OutBefore, FGridPlacerConsolidateStats& OutAfter)
+{
+	GRIDPLACER_SCOPE(Consolidate);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	EnsureRegistry();
+	OutBefore = FGridPlacerConsolidateStats();
+	OutAfter = FGridPlacerConsolidateStats();
+	ChunkSize = FMath::Max(ChunkSize, 1);
+	const TSet<UStaticMesh*> MeshSet(Meshes);
+	//Instances live on the host in the current level, content of other levels stays where it is
+	ULevel* Level = GetWorld()->GetCurrentLevel();
+
+	TArray<FGridPlacerConsolidateRequest> Requests;
+	TSet<UInstancedStaticMeshComponent*> ExistingComponents;
+	for(TActorIterator<AStaticMeshActor> It(GetWorld()); It; ++It)
+	{
+		AStaticMeshActor* Actor = *It;
+		UStaticMeshComponent* MeshComponent = Actor->GetStaticMeshComponent();
+		UStaticMesh* Mesh = MeshComponent ? MeshComponent->GetStaticMesh() : nullptr;
+		//Subclasses may carry logic and hierarchies would lose their parent, only plain leaf actors are safe to flatten
+		if(!Mesh || !MeshSet.Contains(Mesh) || Actor->GetClass() != AStaticMeshActor::StaticClass() || Actor->GetLevel() != Level
+			|| Actor->GetAttachParentActor() || MeshComponent->GetNumChildrenComponents() > 0 || Actor->GetComponents().Num() > 1)
+			continue;
+		const FTransform Transform = Actor->GetActorTransform();
+		const FIntVector Cell = Frame.WorldToCell(Transform.GetLocation());
+		if(Region.IsValid() && !Region.Intersects(FGridPlacerCellBox(Cell, Cell)))
+			continue;
+
+		uint32 Id = ActorIds.FindRef(Actor);
+		if(!Id)
+		{
+			//Placed before GridPlacer tracked its actors or by hand, from now on it is GridPlacer's
+			Actor->Tags.AddUnique(PlacedActorTag);
+			Id = RegisterActor(Actor, Mesh, 0);
+		}
+		FGridPlacerConsolidateRequest& Request = Requests.AddDefaulted_GetRef();
+		Request.Id = Id;
+		Request.Mesh = Mesh;
+		for(UMaterialInterface* Material : MeshComponent->OverrideMaterials)
+			Request.Materials.Add(Material);
+		while(Request.Materials.Num() > 0 && !Request.Materials.Last())
+			Request.Materials.Pop(false);
+		Request.Transform = Transform;
+		Request.CustomData = GetItemCustomData(Items[Id]);
+		Request.Chunk = FIntPoint(FMath::FloorToInt32(Cell.X / static_cast<double>(ChunkSize)), FMath::FloorToInt32(Cell.Y / static_cast<double>(ChunkSize)));
+
+		++OutBefore.NumActors;
+		OutBefore.MemoryBytes += Actor->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		AddConsolidateStats(OutBefore, MeshComponent);
+		if(UInstancedStaticMeshComponent* Existing = FindConsolidatedComponent(Mesh, Request.Materials, Request.Chunk, false))
+			ExistingComponents.Add(Existing);
+	}
+	if(Requests.Num() == 0)
+		return 0;
+	//Components from an earlier consolidation already cost something before this one
+	for(UInstancedStaticMeshComponent* Existing : ExistingComponents)
+		AddConsolidateStats(OutBefore, Existing);
+
+	//The actors are destroyed through the transaction and come back as they were on undo, the change only moves the ids into instances
+	if(GEditor)
+		GEditor->BeginTransaction(Description);
+	ConsolidateItems(Requests);
+
+	TSet<UInstancedStaticMeshComponent*> Components;
+	TUniquePtr<FGridPlacerConsolidateChange> Change = MakeUnique<FGridPlacerConsolidateChange>();
+	for(const FGridPlacerConsolidateRequest& Request : Requests)
+	{
+		const FGridPlacerPlacedItem* Item = Items.Find(Request.Id);
+		if(!Item || !Item->IsInstance())
+			continue;
+		Components.Add(Item->Component.Get());
+		Change->AddRecord(Request);
+	}
+	for(UInstancedStaticMeshComponent* Component : Components)
+		AddConsolidateStats(OutAfter, Component);
+	const int32 NumConsolidated = Change->Num();
+	if(NumConsolidated > 0)
+		StoreChange(MoveTemp(Change), Description);
+	if(GEditor)
+		GEditor->EndTransaction();
+	return NumConsolidated;
+}
+
+int32 UGridPlacerSubsystem::ConsolidateItems(TArrayView<const FGridPlacerConsolidateRequest> Requests)
+{
+	EnsureRegistry();
+
+	int32 NumConsolidated = 0;
+	TMap<UInstancedStaticMeshComponent*, TArray<FPendingInstance>> PendingInstances;
+	for(const FGridPlacerConsolidateRequest& Request : Requests)
+	{
+		const FGridPlacerPlacedItem* Item = Items.Find(Request.Id);
+		if(!Item || Item->IsInstance())
+			continue;
+		UInstancedStaticMeshComponent* Component;
+		{
+			TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+			Component = FindConsolidatedComponent(Request.Mesh, Request.Materials, Request.Chunk, true);
+		}
+		if(!Component)
+			continue;
+		//A redo has destroyed the actor already, only the registry still points to it
+		const TWeakObjectPtr<AActor> Actor = Item->Actor;
+		if(Actor.IsValid())
+		{
+			TGuardValue<bool> MutatingGuard(IsMutating, true);
+			Actor->MarkPackageDirty();
+			GetWorld()->EditorDestroyActor(Actor.Get(), true);
+		}
+		//The actor keeps its id when undo brings it back
+		DeletedActorIds.Add(Actor, Request.Id);
+		UnregisterItem(Request.Id);
+		PendingInstances.FindOrAdd(Component).Add({Request.Id, Request.Transform, Request.CustomData});
+		++NumConsolidated;
+	}
+	TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+	for(const TPair<UInstancedStaticMeshComponent*, TArray<FPendingInstance>>& Pending : PendingInstances)
+		AddInstancesWithIds(Pending.Key, Pending.Value);
+	return NumConsolidated;
+}
+
+int32 UGridPlacerSubsystem::ExpandItems(TArrayView<const FGridPlacerConsolidateRequest> Requests)
+{
+	EnsureRegistry();
+
+	int32 NumExpanded = 0;
+	//Instances were appended in request order, removing them back to front only ever pops the last one
+	for(int32 RequestIndex = Requests.Num() - 1; RequestIndex >= 0; --RequestIndex)
+	{
+		const FGridPlacerPlacedItem* Item = Items.Find(Requests[RequestIndex].Id);
+		if(Item && Item->IsInstance() && RemoveItem(Requests[RequestIndex].Id))
+			++NumExpanded;
+	}
+	return NumExpanded;
+}
+
+void UGridPlacerSubsystem::SetItemsHidden(TArrayView<const uint32> Ids, bool Hidden, int32 CustomDataIndex)
+{
+	EnsureRegistry();
+	const float Value = Hidden ? 1.0f : 0.0f;
+	TSet<UInstancedStaticMeshComponent*> DirtyComponents;
+	for(const uint32 Id : Ids)
+	{
+		const FGridPlacerPlacedItem* Item = Items.Find(Id);
+		if(!Item || !Item->IsValid())
+			continue;
+		if(Item->IsInstance())
+		{
+			UInstancedStaticMeshComponent* Component = Item->Component.Get();
+			//Instances without custom data are visible already, only grow it when something has to be hidden
+			if(Component->NumCustomDataFloats <= CustomDataIndex)
+			{
+				if(!Hidden)
+					continue;
+				EnsureCustomDataFloats(Component, CustomDataIndex + 1);
+			}
+			float& Current = Component->PerInstanceSMCustomData[Item->InstanceIndex * Component->NumCustomDataFloats + CustomDataIndex];
+			if(Current == Value)
+				continue;
+			//Written directly, SetCustomDataValue would rebuild the render state for every single instance
+			Current = Value;
+			DirtyComponents.Add(Component);
+		}
+		else if(Item->Actor->IsHidden() != Hidden)
+		{
+			Item->Actor->SetActorHiddenInGame(Hidden);
+			Item->Actor->SetActorEnableCollision(!Hidden);
+			Item->Actor->MarkPackageDirty();
+		}
+	}
+	for(UInstancedStaticMeshComponent* Component : DirtyComponents)
+	{
+		Component->MarkRenderStateDirty();
+		Component->MarkPackageDirty();
+	}
+}
+
+const FGridPlacerPlacedItem* UGridPlacerSubsystem::FindItem(uint32 Id)
+{
+	EnsureRegistry();
+	return Items.Find(Id);
+}
+
+uint32 UGridPlacerSubsystem::FindItemId(AActor* Actor)
+{
+	EnsureRegistry();
+	return ActorIds.FindRef(Actor);
+}
+
+uint32 UGridPlacerSubsystem::FindItemId(UInstancedStaticMeshComponent* Component, int32 InstanceIndex)
+{
+	EnsureRegistry();
+	if(const TArray<uint32>* Ids = InstanceIds.Find(Component))
+		if(Ids->IsValidIndex(InstanceIndex))
+			return (*Ids)[InstanceIndex];
+	return 0;
+}
+
+const TMap<uint32, FGridPlacerPlacedItem>& UGridPlacerSubsystem::GetItems()
+{
+	EnsureRegistry();
+	return Items;
+}
+
+void UGridPlacerSubsystem::QueryItems(const FBox& WorldBounds, TArray<uint32>& OutIds)
+{
+	EnsureRegistry();
+	SpatialIndex.Query(WorldBounds, OutIds);
+}
+
+FBox UGridPlacerSubsystem::GetAssetBounds(UObject* Asset)
+{
+	if(!Asset)
+		return FBox(ForceInit);
+	if(const FBox* Cached = AssetBounds.Find(Asset))
+		return *Cached;
+	FBox Bounds(ForceInit);
+	if(UStaticMesh* StaticMesh = Cast<UStaticMesh>(Asset))
+		Bounds = StaticMesh->GetBoundingBox();
+	else if(UClass* ActorClass = Cast<UClass>(Asset))
+		if(ActorClass->IsChildOf(AActor::StaticClass()))
+			Bounds = AActor::GetActorClassDefaultComponentsLocalBoundingBox(ActorClass);
+	AssetBounds.Add(Asset, Bounds);
+	return Bounds;
+}
+
+FBox UGridPlacerSubsystem::GetItemBounds(const FGridPlacerPlacedItem& Item)
+{
+	const FBox LocalBounds = GetAssetBounds(Item.Asset.Get());
+	if(!LocalBounds.IsValid)
+		return FBox(Item.Transform.GetLocation(), Item.Transform.GetLocation());
+	return LocalBounds.TransformBy(Item.Transform);
+}
+
+int32 UGridPlacerSubsystem::BakeCellData(const FGridPlacerFrame& Frame, UGridPlacerCellData* Target, TArray<FName>* OutDroppedTags)
+{
+	if(!Target)
+		return 0;
+	EnsureRegistry();
+	LLM_SCOPE_BYTAG(GridPlacer);
+
+	//Sorted so baking the same level twice produces the same palette and tag order
+	TArray<uint32> Ids;
+	Items.GetKeys(Ids);
+	Ids.Sort();
+
+	TArray<TSoftObjectPtr<UObject>> Palette;
+	TMap<UObject*, uint16> PaletteIds;
+	TArray<FName> Tags;
+	TMap<FIntPoint, FGridPlacerCellChunk> Chunks;
+	int32 NumCells = 0;
+	for(const uint32 Id : Ids)
+	{
+		const FGridPlacerPlacedItem& Item = Items[Id];
+		UObject* Asset = Item.Asset.Get();
+		if(!Item.IsValid() || !Asset)
+			continue;
+
+		uint16* PaletteId = PaletteIds.Find(Asset);
+		if(!PaletteId)
+		{
+			if(Palette.Num() >= FGridPlacerCellChunk::InvalidPaletteId)
+				continue;
+			PaletteId = &PaletteIds.Add(Asset, Palette.Num());
+			Palette.Add(Asset);
+		}
+
+		uint32 TagMask = 0;
+		auto AddTags = [&](const TArray<FName>& ItemTags)
+		{
+			for(const FName& Tag : ItemTags)
+			{
+				//The plugin's own bookkeeping tags say nothing about the cell
+				if(Tag == PlacedActorTag || Tag == InstanceHostTag || Tag == ConsolidatedComponentTag)
+					continue;
+				const int32 TagIndex = Tags.AddUnique(Tag);
+				//Masks are 32 bits wide, everything past that can't be represented
+				if(TagIndex < 32)
+					TagMask |= 1u << TagIndex;
+			}
+		};
+		bool Blocking = false;
+		if(Item.IsInstance())
+		{
+			Blocking = Item.Component->GetCollisionEnabled() != ECollisionEnabled::NoCollision;
+			//Instances carry the tags of their component and of the actor owning it
+			AddTags(Item.Component->ComponentTags);
+			if(const AActor* Owner = Item.Component->GetOwner())
+				AddTags(Owner->Tags);
+		}
+		else
+		{
+			Blocking = Item.Actor->GetActorEnableCollision();
+			AddTags(Item.Actor->Tags);
+		}
+
+		const FBox LocalBounds = GetAssetBounds(Asset);
+		const FTransform ObjectToGrid = Item.Transform.GetRelativeTransform(Frame.GridToWorld);
+		const FBox GridBounds = LocalBounds.IsValid
+			? LocalBounds.TransformBy(ObjectToGrid)
+			: FBox(ObjectToGrid.GetLocation(), ObjectToGrid.GetLocation());
+		const FGridPlacerCellBox Cells = Frame.GetCellBox(GridBounds);
+		const float Top = GridBounds.Max.Z;
+		const uint8 ItemFlags = static_cast<uint8>(EGridPlacerCellFlags::Occupied) | (Blocking ? static_cast<uint8>(EGridPlacerCellFlags::Blocking) : 0);
+
+		for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+		{
+			for(int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+			{
+				const FIntPoint Cell(X, Y);
+				const FIntPoint ChunkCoord = FGridPlacerCellChunk::GetChunkCoord(Cell);
+				FGridPlacerCellChunk* Chunk = Chunks.Find(ChunkCoord);
+				if(!Chunk)
+				{
+					Chunk = &Chunks.Add(ChunkCoord);
+					Chunk->Init();
+				}
+				const int32 LocalIndex = FGridPlacerCellChunk::GetLocalIndex(Cell);
+				uint8& Flags = Chunk->Flags[LocalIndex];
+				if(Flags & static_cast<uint8>(EGridPlacerCellFlags::Occupied))
+				{
+					Flags |= static_cast<uint8>(EGridPlacerCellFlags::Stacked);
+					if(Top <= Chunk->Heights[LocalIndex])
+					{
+						Flags |= ItemFlags;
+						Chunk->TagMasks[LocalIndex] |= TagMask;
+						continue;
+					}
+				}
+				else
+					++NumCells;
+				Flags |= ItemFlags;
+				Chunk->TagMasks[LocalIndex] |= TagMask;
+				Chunk->PaletteIds[LocalIndex] = *PaletteId;
+				Chunk->Heights[LocalIndex] = Top;
+			}
+		}
+	}
+
+	if(OutDroppedTags)
+		OutDroppedTags->Reset();
+	if(Tags.Num() > 32)
+	{
+		if(OutDroppedTags)
+			OutDroppedTags->Append(&Tags[32], Tags.Num() - 32);
+		Tags.SetNum(32);
+	}
+	Target->SetBakedData(Frame, MoveTemp(Palette), MoveTemp(Tags), MoveTemp(Chunks));
+	Target->MarkPackageDirty();
+	return NumCells;
+}
+
+void UGridPlacerSubsystem::EnsureRegistry()
+{
+	if(RegistryBuilt)
+		return;
+	RegistryBuilt = true;
+	LLM_SCOPE_BYTAG(GridPlacer);
+
+	//Only done once per world, everything after this is tracked incrementally
+	for(TActorIterator<AActor> It(GetWorld()); It; ++It)
+		RegisterExistingActor(*It);
+}
+
+void UGridPlacerSubsystem::RegisterExistingActor(AActor* Actor)
+{
+	if(Actor->Tags.Contains(InstanceHostTag))
+	{
+		if(!InstanceHost.IsValid())
+			InstanceHost = Actor;
+		TInlineComponentArray<UInstancedStaticMeshComponent*> Components(Actor);
+		for(UInstancedStaticMeshComponent* Component : Components)
+		{
+			if(InstanceIds.Contains(Component))
+				continue;
+			if(Actor == InstanceHost.Get() && Component->GetStaticMesh() && !Component->ComponentHasTag(ConsolidatedComponentTag))
+				InstanceComponents.Add(Component->GetStaticMesh(), Component);
+			TArray<uint32> PreviousIds;
+			DeletedInstanceIds.RemoveAndCopyValue(Component, PreviousIds);
+			const bool KeepIds = PreviousIds.Num() == Component->GetInstanceCount();
+			for(int32 i = 0; i < Component->GetInstanceCount(); ++i)
+				RegisterInstance(Component, i, KeepIds && !Items.Contains(PreviousIds[i]) ? PreviousIds[i] : 0);
+		}
+	}
+	else if(Actor->Tags.Contains(PlacedActorTag) && !ActorIds.Contains(Actor))
+	{
+		UObject* Asset = Actor->GetClass();
+		if(Actor->GetClass() == AStaticMeshActor::StaticClass())
+			Asset = CastChecked<AStaticMeshActor>(Actor)->GetStaticMeshComponent()->GetStaticMesh();
+		uint32 PreviousId = 0;
+		DeletedActorIds.RemoveAndCopyValue(Actor, PreviousId);
+		RegisterActor(Actor, Asset, Items.Contains(PreviousId) ? 0 : PreviousId);
+	}
+}
+
+void UGridPlacerSubsystem::SyncRegistry()
+{
+	const TSet<TWeakObjectPtr<AActor>> Actors = MoveTemp(UndoActors);
+	const TSet<TWeakObjectPtr<UInstancedStaticMeshComponent>> Components = MoveTemp(UndoComponents);
+	if(!RegistryBuilt)
+		return;
+	//Transactions bring back and delete actors without broadcasting it, so whatever the transaction touched is compared with the level.
+	//GridPlacer's own changes keep the registry up to date themselves and touch no actors here
+	for(const TWeakObjectPtr<UInstancedStaticMeshComponent>& Component : Components)
+	{
+		TArray<uint32> Ids;
+		if(Component.IsValid() || !InstanceIds.RemoveAndCopyValue(Component, Ids))
+			continue;
+		for(const uint32 Id : Ids)
+			UnregisterItem(Id);
+		DeletedInstanceIds.Add(Component, MoveTemp(Ids));
+	}
+	for(const TWeakObjectPtr<AActor>& Actor : Actors)
+	{
+		if(Actor.IsValid())
+			continue;
+		if(const uint32* Id = ActorIds.Find(Actor))
+		{
+			const uint32 StaleId = *Id;
+			DeletedActorIds.Add(Actor, StaleId);
+			UnregisterItem(StaleId);
+		}
+	}
+	if(!InstanceHost.IsValid())
+		InstanceHost.Reset();
+	for(const TWeakObjectPtr<AActor>& Actor : Actors)
+		if(AActor* ExistingActor = Actor.Get())
+			RegisterExistingActor(ExistingActor);
+}
+
+bool UGridPlacerSubsystem::MatchesContext(const FTransactionContext& InContext, const TArray<TPair<UObject*, FTransactionObjectEvent>>& TransactionObjectContexts) const
+{
+	const UWorld* World = GetWorld();
+	for(const TPair<UObject*, FTransactionObjectEvent>& ObjectContext : TransactionObjectContexts)
+	{
+		UObject* Object = ObjectContext.Key;
+		if(!Object || Object->GetTypedOuter<UWorld>() != World)
+			continue;
+		if(UInstancedStaticMeshComponent* Component = Cast<UInstancedStaticMeshComponent>(Object))
+			UndoComponents.Add(Component);
+		if(AActor* Actor = Cast<AActor>(Object))
+			UndoActors.Add(Actor);
+		else if(AActor* Owner = Object->GetTypedOuter<AActor>())
+			UndoActors.Add(Owner);
+	}
+	return UndoActors.Num() > 0 || UndoComponents.Num() > 0;
+}
+
+void UGridPlacerSubsystem::PostUndo(bool bSuccess)
+{
+	SyncRegistry();
+}
+
+void UGridPlacerSubsystem::PostRedo(bool bSuccess)
+{
+	SyncRegistry();
+}
+
+uint32 UGridPlacerSubsystem::RegisterActor(AActor* Actor, UObject* Asset, uint32 ForcedId)
+{
+	const uint32 Id = AllocateId(ForcedId);
+	FGridPlacerPlacedItem& Item = Items.Add(Id);
+	Item.Id = Id;
+	Item.Asset = Asset;
+	Item.Actor = Actor;
+	Item.Transform = Actor->GetActorTransform();
+	ActorIds.Add(Actor, Id);
+	SpatialIndex.Insert(Id, GetItemBounds(Item));
+	OnItemAdded.Broadcast(Item);
+	return Id;
+}
+
+uint32 UGridPlacerSubsystem::RegisterInstance(UInstancedStaticMeshComponent* Component, int32 InstanceIndex, uint32 ForcedId)
+{
+	TArray<uint32>& Ids = InstanceIds.FindOrAdd(Component);
+	//Instances are only ever appended, the new one is always the last
+	check(InstanceIndex == Ids.Num());
+	const uint32 Id = AllocateId(ForcedId);
+	Ids.Add(Id);
+	FGridPlacerPlacedItem& Item = Items.Add(Id);
+	Item.Id = Id;
+	Item.Asset = Component->GetStaticMesh();
+	Item.Component = Component;
+	Item.InstanceIndex = InstanceIndex;
+	Component->GetInstanceTransform(InstanceIndex, Item.Transform, true);
+	SpatialIndex.Insert(Id, GetItemBounds(Item));
+	OnItemAdded.Broadcast(Item);
+	return Id;
+}
+
+void UGridPlacerSubsystem::UnregisterItem(uint32 Id)
+{
+	FGridPlacerPlacedItem Item;
+	if(!Items.RemoveAndCopyValue(Id, Item))
+		return;
+	if(!Item.IsInstance())
+		ActorIds.Remove(Item.Actor);
+	SpatialIndex.Remove(Id);
+	OnItemRemoved.Broadcast(Item);
+}
+
+uint32 UGridPlacerSubsystem::AllocateId(uint32 ForcedId)
+{
+	if(ForcedId != 0)
+	{
+		NextItemId = FMath::Max(NextItemId, ForcedId + 1);
+		return ForcedId;
+	}
+	return NextItemId++;
+}
+
+AActor* UGridPlacerSubsystem::FindOrCreateInstanceHost()
+{
+	if(AActor* Host = InstanceHost.Get())
+		return Host;
+
+	UWorld* World = GetWorld();
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.OverrideLevel = World->GetCurrentLevel();
+	SpawnParams.Name = MakeUniqueObjectName(SpawnParams.OverrideLevel, AActor::StaticClass(), InstanceHostTag);
+	AActor* Host = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+	if(!Host)
+		return nullptr;
+
+	USceneComponent* Root = NewObject<USceneComponent>(Host, FName("Root"), RF_Transactional);
+	Root->SetMobility(EComponentMobility::Static);
+	Host->SetRootComponent(Root);
+	Host->AddInstanceComponent(Root);
+	Root->RegisterComponent();
+	Host->SetActorLabel(InstanceHostTag.ToString());
+	Host->Tags.Add(InstanceHostTag);
+	Host->MarkPackageDirty();
+
+	InstanceHost = Host;
+	return Host;
+}
+
+UInstancedStaticMeshComponent* UGridPlacerSubsystem::FindOrCreateInstanceComponent(UStaticMesh* StaticMesh)
+{
+	if(const TWeakObjectPtr<UInstancedStaticMeshComponent>* Found = InstanceComponents.Find(StaticMesh))
+		if(Found->IsValid())
+			return Found->Get();
+
+	AActor* Host = FindOrCreateInstanceHost();
+	if(!Host)
+		return nullptr;
+
+	const FName ComponentName = MakeUniqueObjectName(Host, UInstancedStaticMeshComponent::StaticClass(), StaticMesh->GetFName());
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(Host, ComponentName, RF_Transactional);
+	Component->SetMobility(EComponentMobility::Static);
+	Component->SetStaticMesh(StaticMesh);
+	Component->SetupAttachment(Host->GetRootComponent());
+	Host->AddInstanceComponent(Component);
+	Component->RegisterComponent();
+
+	InstanceComponents.Add(StaticMesh, Component);
+	return Component;
+}
+
+UInstancedStaticMeshComponent* UGridPlacerSubsystem::GetRequestComponent(const FGridPlacerSpawnRequest& Request)
+{
+	UStaticMesh* StaticMesh = Cast<UStaticMesh>(Request.Asset);
+	if(!StaticMesh)
+		return nullptr;
+	//Undoing the removal of a consolidated instance puts it back into its chunk
+	UInstancedStaticMeshComponent* Component = Request.Component.Get();
+	if(Component && Component->GetStaticMesh() == StaticMesh)
+		return Component;
+	return FindOrCreateInstanceComponent(StaticMesh);
+}
+
+UInstancedStaticMeshComponent* UGridPlacerSubsystem::FindConsolidatedComponent(UStaticMesh* Mesh, TArrayView<UMaterialInterface* const> Materials, const FIntPoint& Chunk, bool Create)
+{
+	AActor* Host = Create ? FindOrCreateInstanceHost() : InstanceHost.Get();
+	if(!Host || !Mesh)
+		return nullptr;
+
+	//Named after what they group so components of a loaded level are found again, the hash tells material sets apart
+	uint32 MaterialHash = 0;
+	for(UMaterialInterface* Material : Materials)
+		MaterialHash = HashCombine(MaterialHash, Material ? GetTypeHash(Material->GetPathName()) : 0);
+	const FString BaseName = FString::Printf(TEXT("%s_%08X_X%dY%d"), *Mesh->GetName(), MaterialHash, Chunk.X, Chunk.Y);
+	FName ComponentName;
+	for(int32 Suffix = 0; ; ++Suffix)
+	{
+		ComponentName = FName(*BaseName, Suffix);
+		UInstancedStaticMeshComponent* Component = FindObjectFast<UInstancedStaticMeshComponent>(Host, ComponentName);
+		if(!Component)
+			break;
+		if(!IsValid(Component) || Component->GetStaticMesh() != Mesh || !Component->ComponentHasTag(ConsolidatedComponentTag))
+			continue;
+		bool MaterialsMatch = true;
+		const int32 NumMaterials = FMath::Max(Materials.Num(), Component->OverrideMaterials.Num());
+		for(int32 MaterialIndex = 0; MaterialIndex < NumMaterials && MaterialsMatch; ++MaterialIndex)
+		{
+			const UMaterialInterface* Wanted = Materials.IsValidIndex(MaterialIndex) ? Materials[MaterialIndex] : nullptr;
+			const UMaterialInterface* Present = Component->OverrideMaterials.IsValidIndex(MaterialIndex) ? Component->OverrideMaterials[MaterialIndex].Get() : nullptr;
+			MaterialsMatch = Wanted == Present;
+		}
+		if(MaterialsMatch)
+			return Component;
+	}
+	if(!Create)
+		return nullptr;
+
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(Host, ComponentName, RF_Transactional);
+	Component->SetMobility(EComponentMobility::Static);
+	Component->SetStaticMesh(Mesh);
+	for(int32 MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex)
+		if(Materials[MaterialIndex])
+			Component->SetMaterial(MaterialIndex, Materials[MaterialIndex]);
+	Component->ComponentTags.Add(ConsolidatedComponentTag);
+	Component->SetupAttachment(Host->GetRootComponent());
+	Host->AddInstanceComponent(Component);
+	Component->RegisterComponent();
+	Host->MarkPackageDirty();
+	return Component;
+}
+
+void UGridPlacerSubsystem::AddInstancesWithIds(UInstancedStaticMeshComponent* Component, TArrayView<const FPendingInstance> Instances)
+{
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Instances.Num());
+	for(const FPendingInstance& Instance : Instances)
+		Transforms.Add(Instance.Transform);
+	const int32 FirstIndex = Component->GetInstanceCount();
+	Component->AddInstances(Transforms, false, true);
+	bool HasCustomData = false;
+	for(int32 i = 0; i < Instances.Num(); ++i)
+	{
+		if(Instances[i].CustomData.Num() > 0)
+		{
+			SetInstanceCustomData(Component, FirstIndex + i, Instances[i].CustomData);
+			HasCustomData = true;
+		}
+		RegisterInstance(Component, FirstIndex + i, Instances[i].Id);
+	}
+	if(HasCustomData)
+		Component->MarkRenderStateDirty();
+	Component->MarkPackageDirty();
+}
+
+void UGridPlacerSubsystem::SetInstanceCustomData(UInstancedStaticMeshComponent* Component, int32 InstanceIndex, TArrayView<const float> CustomData)
+{
+	EnsureCustomDataFloats(Component, CustomData.Num());
+	const int32 NumFloats = Component->NumCustomDataFloats;
+	TArray<float, TInlineAllocator<16>> Values(CustomData.GetData(), CustomData.Num());
+	for(int32 DataIndex = 0; DataIndex < Values.Num(); ++DataIndex)
+		if(FMath::IsNaN(Values[DataIndex]))
+			Values[DataIndex] = Component->PerInstanceSMCustomData[InstanceIndex * NumFloats + DataIndex];
+	Component->SetCustomData(InstanceIndex, Values, false);
+}
+
+TArray<float> UGridPlacerSubsystem::GetItemCustomData(const FGridPlacerPlacedItem& Item) const
+{
+	if(Item.IsInstance())
+	{
+		const UInstancedStaticMeshComponent* Component = Item.Component.Get();
+		if(!Component || Component->NumCustomDataFloats == 0)
+			return {};
+		const int32 NumFloats = Component->NumCustomDataFloats;
+		return TArray<float>(&Component->PerInstanceSMCustomData[Item.InstanceIndex * NumFloats], NumFloats);
+	}
+	//Every primitive got the same values, the first one speaks for the whole actor
+	const UPrimitiveComponent* Primitive = Item.Actor.IsValid() ? Item.Actor->FindComponentByClass<UPrimitiveComponent>() : nullptr;
+	return Primitive ? Primitive->GetDefaultCustomPrimitiveData().Data : TArray<float>();
+}
+
+void UGridPlacerSubsystem::RemoveInstanceAtSwap(UInstancedStaticMeshComponent* Component, int32 InstanceIndex)
+{
+	TArray<uint32>* Ids = InstanceIds.Find(Component);
+	const int32 LastIndex = Component->GetInstanceCount() - 1;
+	if(InstanceIndex != LastIndex)
+	{
+		//Move the last instance into the gap so no other index changes and only the last slot has to go
+		FTransform LastTransform;
+		Component->GetInstanceTransform(LastIndex, LastTransform, true);
+		Component->UpdateInstanceTransform(InstanceIndex, LastTransform, true, false, true);
+		const int32 NumCustomData = Component->NumCustomDataFloats;
+		if(NumCustomData > 0)
+		{
+			const TArray<float> LastCustomData(&Component->PerInstanceSMCustomData[LastIndex * NumCustomData], NumCustomData);
+			Component->SetCustomData(InstanceIndex, LastCustomData);
+		}
+		if(Ids && Ids->IsValidIndex(LastIndex))
+		{
+			const uint32 MovedId = (*Ids)[LastIndex];
+			(*Ids)[InstanceIndex] = MovedId;
+			if(FGridPlacerPlacedItem* MovedItem = Items.Find(MovedId))
+				MovedItem->InstanceIndex = InstanceIndex;
+		}
+	}
+	Component->RemoveInstance(LastIndex);
+	if(Ids && Ids->Num() > 0)
+		Ids->Pop(false);
+}
+
+void UGridPlacerSubsystem::EnsureCustomDataFloats(UInstancedStaticMeshComponent* Component, int32 NumFloats)
+{
+	const int32 OldNumFloats = Component->NumCustomDataFloats;
+	if(OldNumFloats >= NumFloats)
+		return;
+	//SetNumCustomDataFloats zeroes everything, so carry the old values over
+	const TArray<float> OldCustomData = Component->PerInstanceSMCustomData;
+	Component->SetNumCustomDataFloats(NumFloats);
+	const int32 NumInstances = Component->GetInstanceCount();
+	for(int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+		for(int32 DataIndex = 0; DataIndex < OldNumFloats; ++DataIndex)
+			Component->PerInstanceSMCustomData[InstanceIndex * NumFloats + DataIndex] = OldCustomData[InstanceIndex * OldNumFloats + DataIndex];
+	Component->MarkRenderStateDirty();
+}
+
+void UGridPlacerSubsystem::OnLevelActorAdded(AActor* Actor)
+{
+	if(IsMutating || !RegistryBuilt)
+		return;
+	//Pasted, duplicated or restored placed content is tracked again
+	RegisterExistingActor(Actor);
+}
+
+void UGridPlacerSubsystem::OnLevelActorDeleted(AActor* Actor)
+{
+	if(IsMutating || !RegistryBuilt)
+		return;
+	//Somebody deleted placed content by hand, forget about it until an undo brings it back
+	if(const uint32 Id = ActorIds.FindRef(Actor))
+	{
+		DeletedActorIds.Add(Actor, Id);
+		UnregisterItem(Id);
+	}
+	else if(Actor->Tags.Contains(InstanceHostTag))
+	{
+		TArray<uint32> HostedIds;
+		for(auto It = InstanceIds.CreateIterator(); It; ++It)
+		{
+			if(!It.Key().IsValid() || It.Key()->GetOwner() != Actor)
+				continue;
+			HostedIds.Append(It.Value());
+			DeletedInstanceIds.Add(It.Key(), MoveTemp(It.Value()));
+			It.RemoveCurrent();
+		}
+		for(const uint32 Id : HostedIds)
+			UnregisterItem(Id);
+		if(Actor == InstanceHost.Get())
+		{
+			InstanceComponents.Empty();
+			InstanceHost.Reset();
+		}
+	}
+}
+
+void UGridPlacerSubsystem::OnActorMoved(AActor* Actor)
+{
+	if(IsMutating || !RegistryBuilt)
+		return;
+	const uint32 Id = ActorIds.FindRef(Actor);
+	FGridPlacerPlacedItem* Item = Id ? Items.Find(Id) : nullptr;
+	if(!Item)
+		return;
+	//Re-announce the item so everything derived from its transform can update
+	OnItemRemoved.Broadcast(*Item);
+	Item->Transform = Actor->GetActorTransform();
+	SpatialIndex.Insert(Id, GetItemBounds(*Item));
+	OnItemAdded.Broadcast(*Item);
+}
+
+#undef LOCTEXT_NAMESPACE
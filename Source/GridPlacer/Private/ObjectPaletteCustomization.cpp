@@ -11,15 +11,21 @@
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/Layout/SBox.h"
 #include "Widgets/Input/SComboBox.h"
+#include "Widgets/Input/SSpinBox.h"
+#include "Widgets/Input/SEditableTextBox.h"
+#include "Widgets/Input/SComboButton.h"
 #include "DetailWidgetRow.h"
 #include "Editor.h"
 #include "PropertyHandle.h"
 #include "SlateBasics.h"
 #include "IDetailChildrenBuilder.h"
 #include "IPropertyUtilities.h"
+#include "IDetailsView.h"
+#include "PropertyEditorModule.h"
 #include "SAssetDropTarget.h"
 #include "Editor/UnrealEd/Public/AssetThumbnail.h"
 #include "Tools/PlacementTool.h"
+#include "GridPlacerStats.h"
 
 void ObjectPaletteCustomization::CustomizeHeader(TSharedRef<IPropertyHandle> StructPropertyHandle, FDetailWidgetRow& HeaderRow, IPropertyTypeCustomizationUtils& StructCustomizationUtils)
 {
@@ -35,6 +41,8 @@ void ObjectPaletteCustomization::CustomizeHeader(TSharedRef<IPropertyHandle> Str
 
 void ObjectPaletteCustomization::CustomizeChildren(TSharedRef<IPropertyHandle> StructPropertyHandle, IDetailChildrenBuilder& StructBuilder, IPropertyTypeCustomizationUtils& StructCustomizationUtils)
 {
+	GRIDPLACER_SCOPE(PaletteRebuild);
+	LLM_SCOPE_BYTAG(GridPlacer);
 	FObjectPalette* ObjectPalette = GetData();
 	
 	StructBuilder.AddCustomRow(FText::FromString("Palette Control"))
@@ -90,7 +98,7 @@ void ObjectPaletteCustomization::CustomizeChildren(TSharedRef<IPropertyHandle> S
 				SNew(STextBlock)
 				.Justification(ETextJustify::Center)
 				.ColorAndOpacity(FSlateColor(FLinearColor(1.0f, 1.0f, 1.0f, 0.5f)))
-				.Text(FText::FromString("Drop Assets Here\nStatic Mesh or Actor Blueprint"))
+				.Text(FText::FromString("Drop Assets Here\nStatic Mesh, Actor Blueprint or Autotile Set"))
 			]
 			+ SScrollBox::Slot()
 			[
@@ -143,6 +151,16 @@ void ObjectPaletteCustomization::CustomizeChildren(TSharedRef<IPropertyHandle> S
 						]
 						+ SOverlay::Slot()
 						.VAlign(EVerticalAlignment::VAlign_Top)
+						.HAlign(EHorizontalAlignment::HAlign_Center)
+						[
+							SNew(SCheckBox)
+							.Visibility(PaletteObject->ObjectType == EPaletteObjectType::StaticMesh ? EVisibility::Visible : EVisibility::Collapsed)
+							.ToolTipText(FText::FromString("Merge Coplanar: merged mesh baking may stretch one copy over a rectangle of equal neighbors"))
+							.IsChecked_Lambda([PaletteObject] { return PaletteObject->MergeCoplanar ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+							.OnCheckStateChanged_Lambda([PaletteObject](ECheckBoxState State) { PaletteObject->MergeCoplanar = State == ECheckBoxState::Checked; })
+						]
+						+ SOverlay::Slot()
+						.VAlign(EVerticalAlignment::VAlign_Top)
 						.HAlign(EHorizontalAlignment::HAlign_Right)
 						[
 							SNew(SButton)
@@ -155,6 +173,76 @@ void ObjectPaletteCustomization::CustomizeChildren(TSharedRef<IPropertyHandle> S
 								return FReply::Handled();
 							})
 						]
+						+ SOverlay::Slot()
+						.VAlign(EVerticalAlignment::VAlign_Center)
+						.HAlign(EHorizontalAlignment::HAlign_Center)
+						[
+							SNew(STextBlock)
+							.Visibility(PaletteObject->ObjectType == EPaletteObjectType::Stamp ? EVisibility::HitTestInvisible : EVisibility::Collapsed)
+							.Text(FText::FromString(FString::Printf(TEXT("Stamp\n%d objects"), PaletteObject->StampPieces.Num())))
+							.Justification(ETextJustify::Center)
+						]
+						+ SOverlay::Slot()
+						.VAlign(EVerticalAlignment::VAlign_Center)
+						.HAlign(EHorizontalAlignment::HAlign_Fill)
+						[
+							SNew(SEditableTextBox)
+							.Visibility(PaletteObject->ObjectType == EPaletteObjectType::StaticMesh || PaletteObject->ObjectType == EPaletteObjectType::ActorClass ? EVisibility::Visible : EVisibility::Collapsed)
+							.ToolTipText(FText::FromString("Generate Edges: labels of the +X, +Y, -X and -Y edges separated by commas. Generated tiles only touch along edges with the same label"))
+							.HintText(FText::FromString("Edges"))
+							.Text_Lambda([PaletteObject]
+							{
+								TArray<FString> Labels;
+								bool HasLabel = false;
+								for(const FName& Label : PaletteObject->GenerateEdges)
+								{
+									Labels.Add(Label.IsNone() ? FString() : Label.ToString());
+									HasLabel |= !Label.IsNone();
+								}
+								return HasLabel ? FText::FromString(FString::Join(Labels, TEXT(","))) : FText::GetEmpty();
+							})
+							.OnTextCommitted_Lambda([PaletteObject](const FText& Text, ETextCommit::Type)
+							{
+								TArray<FString> Labels;
+								Text.ToString().ParseIntoArray(Labels, TEXT(","), false);
+								for(int32 Edge = 0; Edge < UE_ARRAY_COUNT(PaletteObject->GenerateEdges); ++Edge)
+									PaletteObject->GenerateEdges[Edge] = Labels.IsValidIndex(Edge) ? FName(*Labels[Edge].TrimStartAndEnd()) : NAME_None;
+							})
+						]
+						+ SOverlay::Slot()
+						.VAlign(EVerticalAlignment::VAlign_Bottom)
+						.HAlign(EHorizontalAlignment::HAlign_Fill)
+						.Padding(FMargin(0.0f, 0.0f, 20.0f, 0.0f))
+						[
+							SNew(SSpinBox<float>)
+							.ToolTipText(FText::FromString("Scatter Spacing: minimum distance to other objects when scattering, 0 derives it from the bounds"))
+							.MinValue(0.0f)
+							.MaxSliderValue(2000.0f)
+							.Value_Lambda([PaletteObject] { return PaletteObject->ScatterSpacing; })
+							.OnValueChanged_Lambda([PaletteObject](float Value) { PaletteObject->ScatterSpacing = Value; })
+						]
+						+ SOverlay::Slot()
+						.VAlign(EVerticalAlignment::VAlign_Bottom)
+						.HAlign(EHorizontalAlignment::HAlign_Right)
+						[
+							SNew(SComboButton)
+							.Visibility(PaletteObject->ObjectType == EPaletteObjectType::Stamp ? EVisibility::Collapsed : EVisibility::Visible)
+							.ToolTipText(FText::FromString("Variation: tint, wear and atlas index of the objects placed from this entry"))
+							.HasDownArrow(false)
+							.ContentPadding(0.0f)
+							.ButtonContent()
+							[
+								SNew(STextBlock).Text(FText::FromString("V"))
+							]
+							.OnGetMenuContent_Lambda([PaletteObject]() -> TSharedRef<SWidget>
+							{
+								return SNew(SBox)
+									.WidthOverride(320.0f)
+									[
+										MakeVariationDetailsView(PaletteObject)
+									];
+							})
+						]
 					];
 				}
 			}
@@ -194,6 +282,14 @@ void ObjectPaletteCustomization::OnAssetsDropped(const FDragDropEvent& DragDropE
 			Ref->Add(NewPaletteObject);
 			PropertyHandle->NotifyPostChange(EPropertyChangeType::ArrayAdd);
 		}
+		else if(UGridPlacerAutotileSet* AutotileSet = Cast<UGridPlacerAutotileSet>(It.GetAsset())){
+			UPaletteObject* NewPaletteObject = NewObject<UPaletteObject>();
+			NewPaletteObject->AutotileSet = AutotileSet;
+			NewPaletteObject->ObjectType = EPaletteObjectType::Autotile;
+			NewPaletteObject->Asset = It.GetAsset();
+			Ref->Add(NewPaletteObject);
+			PropertyHandle->NotifyPostChange(EPropertyChangeType::ArrayAdd);
+		}
 	}
 }
 
@@ -212,4 +308,21 @@ FObjectPalette* ObjectPaletteCustomization::GetData()
 	PropertyHandle->GetOuterObjects(objects);
 
 	return (FObjectPalette*)PropertyHandle->GetValueBaseAddress((uint8*)objects[0]);
-}
\ No newline at end of file
+}
+
+TSharedRef<SWidget> ObjectPaletteCustomization::MakeVariationDetailsView(UPaletteObject* PaletteObject)
+{
+	FPropertyEditorModule& PropertyEditor = FModuleManager::LoadModuleChecked<FPropertyEditorModule>("PropertyEditor");
+	FDetailsViewArgs DetailsViewArgs;
+	DetailsViewArgs.bAllowSearch = false;
+	DetailsViewArgs.NameAreaSettings = FDetailsViewArgs::HideNameArea;
+	TSharedRef<IDetailsView> DetailsView = PropertyEditor.CreateDetailView(DetailsViewArgs);
+	DetailsView->SetIsPropertyVisibleDelegate(FIsPropertyVisible::CreateLambda([](const FPropertyAndParent& PropertyAndParent)
+	{
+		const FName VariationName = GET_MEMBER_NAME_CHECKED(UPaletteObject, Variation);
+		return PropertyAndParent.Property.GetFName() == VariationName
+			|| PropertyAndParent.ParentProperties.ContainsByPredicate([VariationName](const FProperty* Parent) { return Parent->GetFName() == VariationName; });
+	}));
+	DetailsView->SetObject(PaletteObject);
+	return DetailsView;
+}
@@ -65,6 +65,11 @@ bool UPlacementToolInputBehavior::IsPressed(const FInputDeviceState& Input)
 				PlacementTool->CycleRotationAxis();
 				return true;
 			}
+			if(Input.Keyboard.ActiveKey.Button == EKeys::R)
+			{
+				PlacementTool->ToggleEraseMode();
+				return true;
+			}
 		}
 	}
 	else if(Input.IsFromDevice(EInputDevices::Mouse))
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerJournal.h"
+
+#include "Engine/StaticMesh.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	FString MakeJournalFilename(const TCHAR* Name)
+	{
+		const FString Filename = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("GridPlacer"), Name);
+		IFileManager::Get().Delete(*Filename, false, true, true);
+		return Filename;
+	}
+
+	bool ContainsEntry(const TArray<FGridPlacerJournal::FEntry>& Entries, const UObject* Asset, const FTransform& Transform)
+	{
+		return Entries.ContainsByPredicate([&](const FGridPlacerJournal::FEntry& Entry)
+		{
+			return Entry.Asset == FSoftObjectPath(Asset) && Entry.Transform.Equals(Transform, 0.01);
+		});
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlacerJournalEraseEarlierSectionTest, "GridPlacer.Journal.EraseEarlierSection", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGridPlacerJournalEraseEarlierSectionTest::RunTest(const FString& Parameters)
+{
+	const UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if(!TestNotNull(TEXT("Cube mesh"), Mesh))
+		return false;
+	const FString Filename = MakeJournalFilename(TEXT("EraseEarlierSection.gpj"));
+	const FTransform Kept(FVector(50.0, 50.0, 0.0));
+	const FTransform ErasedLater(FVector(150.0, 50.0, 0.0));
+	const FTransform Saved(FVector(250.0, 50.0, 0.0));
+	const FTransform Replaced(FVector(350.0, 50.0, 0.0));
+	const FTransform Replacement(FRotator(0.0f, 90.0f, 0.0f), FVector(350.0, 50.0, 0.0));
+
+	{
+		//First section, e.g. the level before it was reloaded
+		FGridPlacerJournal Journal;
+		Journal.Open(Filename);
+		Journal.RecordPlace(1, Mesh, FIntVector(0, 0, 0), Kept, true, {});
+		Journal.RecordPlace(2, Mesh, FIntVector(1, 0, 0), ErasedLater, true, {});
+		Journal.Close();
+
+		//Ids start over in the second section, 1 now is an item saved in the level and 2 one that only a replace touches
+		Journal.Open(Filename);
+		Journal.RecordErase(7, Mesh, ErasedLater, true);
+		Journal.RecordErase(1, Mesh, Saved, false);
+		Journal.RecordErase(2, Mesh, Replaced, true);
+		Journal.RecordPlace(2, Mesh, FIntVector(3, 0, 0), Replacement, true, {});
+		Journal.Close();
+	}
+
+	TArray<FGridPlacerJournal::FEntry> Entries;
+	TArray<FGridPlacerJournal::FEntry> Erased;
+	int32 NumRecords = 0;
+	if(!TestTrue(TEXT("Journal is readable"), FGridPlacerJournal::Read(Filename, Entries, Erased, NumRecords)))
+		return false;
+	TestEqual(TEXT("Alive entries"), Entries.Num(), 2);
+	TestTrue(TEXT("Item of the earlier section is kept"), ContainsEntry(Entries, Mesh, Kept));
+	TestFalse(TEXT("Item of the earlier section erased later is not replayed"), ContainsEntry(Entries, Mesh, ErasedLater));
+	TestTrue(TEXT("Replacement is replayed"), ContainsEntry(Entries, Mesh, Replacement));
+	TestEqual(TEXT("Erased entries"), Erased.Num(), 2);
+	TestTrue(TEXT("Erase of a saved item is replayed"), ContainsEntry(Erased, Mesh, Saved));
+	TestTrue(TEXT("Replace of a saved item erases it"), ContainsEntry(Erased, Mesh, Replaced));
+
+	//Saving makes all of it part of the level
+	{
+		FGridPlacerJournal Journal;
+		Journal.Open(Filename);
+		Journal.RecordPlace(1, Mesh, FIntVector(4, 0, 0), FTransform(FVector(450.0, 50.0, 0.0)), true, {});
+		Journal.RecordSave();
+		Journal.Close();
+	}
+	Entries.Reset();
+	Erased.Reset();
+	TestTrue(TEXT("Journal is readable after a save"), FGridPlacerJournal::Read(Filename, Entries, Erased, NumRecords));
+	TestEqual(TEXT("Alive entries after a save"), Entries.Num(), 0);
+	TestEqual(TEXT("Erased entries after a save"), Erased.Num(), 0);
+
+	IFileManager::Get().Delete(*Filename, false, true, true);
+	return true;
+}
+
+#endif
@@ -0,0 +1,444 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerSubsystem.h"
+#include "Tools/PlacementTool.h"
+
+#include "Editor.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Performance regression tests of the placement pipeline, run headless with
+ *
+ * UnrealEditor <Project> -nullrhi -unattended -ExecCmds="Automation RunTests GridPlacer.Perf; Quit" [-GridPlacerPerfIterations=N] [-updatebaseline]
+ *
+ * Every test drives UPlacementTool the same way the viewport does and compares p50/p99 latency and game thread allocations
+ * per iteration against its baseline in Config/DefaultGridPlacer.ini. A test fails if it regressed by more than RegressionThreshold
+ * or has no baseline at all, -updatebaseline records the measured values instead.
+ */
+class FGridPlacerPerfHarness
+{
+public:
+	explicit FGridPlacerPerfHarness(FAutomationTestBase& InTest);
+	~FGridPlacerPerfHarness();
+
+	bool RunPreviewSweep();
+	bool RunClickPlace(bool AsInstances);
+	bool RunPaletteToggle();
+	bool RunPalettePick();
+	bool RunLocalTraceSweep();
+
+private:
+	struct FResult
+	{
+		double P50Ms = 0.0;
+		double P99Ms = 0.0;
+		int64 P50Allocations = 0;
+		int64 P99Allocations = 0;
+	};
+
+	/** Runs Iteration NumIterations times, collects the latency and allocation count of every run and compares them with the baseline of Name */
+	bool Measure(const FString& Name, TFunctionRef<void(int32)> Iteration);
+	bool CompareWithBaseline(const FString& Name, const FResult& Result);
+
+	void BuildTestLevel(int32 Extent);
+	UPlacementTool* CreateTool(int32 NumPaletteObjects);
+
+	FString GetBaselineFilename() const;
+
+	FAutomationTestBase& Test;
+	UWorld* World = nullptr;
+	UStaticMesh* Mesh = nullptr;
+	UPlacementTool* Tool = nullptr;
+	int32 NumIterations = 2000;
+	bool UpdateBaseline = false;
+};
+
+namespace
+{
+	const TCHAR* BaselineSection = TEXT("GridPlacer.Benchmark");
+	const FVector TestLevelOrigin(100000.0, 0.0, 0.0);
+	constexpr int32 TestLevelExtent = 64;
+	constexpr double TestLevelSpacing = 200.0;
+	constexpr int32 NumLargePaletteObjects = 5000;
+
+	/**
+	 * Forwards everything to the real allocator and counts the allocations the game thread makes while it is installed.
+	 * Task and render threads keep allocating on their own schedule, counting them would make the numbers depend on the machine.
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner) {}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if(Count > 0)
+				CountAllocation();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if(Count > 0)
+				CountAllocation();
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual const TCHAR* GetDescriptiveName() override { return TEXT("GridPlacerCountingMalloc"); }
+
+		FMalloc* const Inner;
+		/*Only ever written and read by the game thread*/
+		int64 NumGameThreadAllocations = 0;
+
+	private:
+		void CountAllocation()
+		{
+			if(IsInGameThread())
+				++NumGameThreadAllocations;
+		}
+	};
+
+	FCountingMalloc* InstallCountingMalloc()
+	{
+		//Never deleted, another thread might still be inside it after it has been uninstalled
+		static FCountingMalloc* CountingMalloc = new FCountingMalloc(GMalloc);
+		GMalloc = CountingMalloc;
+		return CountingMalloc;
+	}
+
+	void UninstallCountingMalloc(FCountingMalloc* CountingMalloc)
+	{
+		GMalloc = CountingMalloc->Inner;
+	}
+
+	/** A cursor ray looking straight down onto the given grid position */
+	FInputDeviceRay MakeDownRay(const FVector& Position)
+	{
+		return FInputDeviceRay(FRay(FVector(Position.X, Position.Y, Position.Z + 2000.0), -FVector::UpVector, true));
+	}
+
+	template<typename T>
+	T GetPercentile(const TArray<T>& Sorted, double Percentile)
+	{
+		return Sorted[FMath::Min(Sorted.Num() - 1, FMath::FloorToInt32(Sorted.Num() * Percentile))];
+	}
+}
+
+FGridPlacerPerfHarness::FGridPlacerPerfHarness(FAutomationTestBase& InTest)
+	: Test(InTest)
+{
+	FParse::Value(FCommandLine::Get(), TEXT("GridPlacerPerfIterations="), NumIterations);
+	NumIterations = FMath::Max(NumIterations, 100);
+	UpdateBaseline = FParse::Param(FCommandLine::Get(), TEXT("updatebaseline"));
+
+	Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if(!GEditor || !Mesh)
+		return;
+	World = UWorld::CreateWorld(EWorldType::Editor, false, FName("GridPlacerPerf"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+	WorldContext.SetCurrentWorld(World);
+}
+
+FGridPlacerPerfHarness::~FGridPlacerPerfHarness()
+{
+	if(Tool)
+	{
+		Tool->Shutdown(EToolShutdownType::Completed);
+		Tool->RemoveFromRoot();
+	}
+	if(!World)
+		return;
+	//Undo steps of the placements point into the world that is about to go away
+	GEditor->ResetTransaction(FText::FromString(TEXT("GridPlacer performance test")));
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
+
+bool FGridPlacerPerfHarness::RunPreviewSweep()
+{
+	//Hovering: grid space, placement point, snapping and preview
+	if(!CreateTool(1))
+		return false;
+	FRandomStream Random(1337);
+	return Measure(TEXT("PreviewSweep"), [&](int32 Iteration)
+	{
+		Tool->OnBeginSequencePreview(MakeDownRay(FVector(Random.FRandRange(-5000.0f, 5000.0f), Random.FRandRange(-5000.0f, 5000.0f), 0.0)));
+	});
+}
+
+bool FGridPlacerPerfHarness::RunClickPlace(bool AsInstances)
+{
+	//Clicking: one placement with occupancy check and undo record per click, on cells that are all free
+	if(!CreateTool(1))
+		return false;
+	const int32 PlacementExtent = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumIterations * 2)));
+	Tool->Properties->PlaceAsInstances = AsInstances;
+	return Measure(AsInstances ? TEXT("ClickPlaceInstances") : TEXT("ClickPlaceActors"), [&](int32 Iteration)
+	{
+		const FInputDeviceRay Ray = MakeDownRay(FVector((Iteration % PlacementExtent + 0.5) * 100.0, (Iteration / PlacementExtent + 0.5) * 100.0, 0.0));
+		Tool->OnBeginSequencePreview(Ray);
+		Tool->OnBeginClickSequence(Ray);
+	});
+}
+
+bool FGridPlacerPerfHarness::RunPaletteToggle()
+{
+	if(!CreateTool(NumLargePaletteObjects))
+		return false;
+	FObjectPalette& Palette = Tool->Properties->ObjectPalette;
+	FRandomStream Random(1337);
+	return Measure(TEXT("PaletteToggle"), [&](int32 Iteration)
+	{
+		UPaletteObject* PaletteObject = Palette.ObjectsInPalette[Random.RandRange(0, NumLargePaletteObjects - 1)];
+		PaletteObject->SetIsActiveInPalette(!PaletteObject->IsActiveInPalette);
+		Palette.NotifyActivePaletteChanged();
+	});
+}
+
+bool FGridPlacerPerfHarness::RunPalettePick()
+{
+	if(!CreateTool(NumLargePaletteObjects))
+		return false;
+	return Measure(TEXT("PalettePick"), [&](int32 Iteration)
+	{
+		Tool->PickNextObjectFromPalette();
+	});
+}
+
+bool FGridPlacerPerfHarness::RunLocalTraceSweep()
+{
+	//Local grid space: a trace per cursor update against a level full of rotated boxes
+	if(!CreateTool(1))
+		return false;
+	BuildTestLevel(TestLevelExtent);
+	Tool->Properties->GridSpaceMode = EGridSpaceMode::Local;
+	const float LevelSize = TestLevelExtent * TestLevelSpacing;
+	FRandomStream Random(1337);
+	return Measure(TEXT("LocalTraceSweep"), [&](int32 Iteration)
+	{
+		Tool->OnBeginSequencePreview(MakeDownRay(TestLevelOrigin + FVector(Random.FRandRange(0.0f, LevelSize), Random.FRandRange(0.0f, LevelSize), 0.0)));
+	});
+}
+
+bool FGridPlacerPerfHarness::Measure(const FString& Name, TFunctionRef<void(int32)> Iteration)
+{
+	//Warm up lazily built registries and caches, past the range the measured iterations use
+	for(int32 i = 0; i < 16; ++i)
+		Iteration(NumIterations + i);
+
+	TArray<double> Times;
+	TArray<int64> Allocations;
+	Times.Reserve(NumIterations);
+	Allocations.Reserve(NumIterations);
+
+	FCountingMalloc* CountingMalloc = InstallCountingMalloc();
+	for(int32 i = 0; i < NumIterations; ++i)
+	{
+		const int64 AllocationsBefore = CountingMalloc->NumGameThreadAllocations;
+		const uint64 CyclesBefore = FPlatformTime::Cycles64();
+		Iteration(i);
+		const uint64 CyclesAfter = FPlatformTime::Cycles64();
+		Times.Add(FPlatformTime::ToMilliseconds64(CyclesAfter - CyclesBefore));
+		Allocations.Add(CountingMalloc->NumGameThreadAllocations - AllocationsBefore);
+	}
+	UninstallCountingMalloc(CountingMalloc);
+
+	Times.Sort();
+	Allocations.Sort();
+	FResult Result;
+	Result.P50Ms = GetPercentile(Times, 0.5);
+	Result.P99Ms = GetPercentile(Times, 0.99);
+	Result.P50Allocations = GetPercentile(Allocations, 0.5);
+	Result.P99Allocations = GetPercentile(Allocations, 0.99);
+	Test.AddInfo(FString::Printf(TEXT("%-20s p50 %8.4f ms  p99 %8.4f ms  allocations p50 %5lld  p99 %5lld"),
+		*Name, Result.P50Ms, Result.P99Ms, Result.P50Allocations, Result.P99Allocations));
+	return CompareWithBaseline(Name, Result);
+}
+
+bool FGridPlacerPerfHarness::CompareWithBaseline(const FString& Name, const FResult& Result)
+{
+	const FString Filename = GetBaselineFilename();
+	FConfigFile File;
+	File.Read(Filename);
+	//Name,P50Ms,P99Ms,P50Allocations
+	TArray<FString> Entries;
+	File.GetArray(BaselineSection, TEXT("Baselines"), Entries);
+	const int32 EntryIndex = Entries.IndexOfByPredicate([&Name](const FString& Entry)
+	{
+		FString EntryName;
+		return Entry.Split(TEXT(","), &EntryName, nullptr) && EntryName.TrimStartAndEnd() == Name;
+	});
+
+	if(UpdateBaseline)
+	{
+		const FString Entry = FString::Printf(TEXT("%s,%.4f,%.4f,%lld"), *Name, Result.P50Ms, Result.P99Ms, Result.P50Allocations);
+		if(EntryIndex != INDEX_NONE)
+			Entries[EntryIndex] = Entry;
+		else
+			Entries.Add(Entry);
+		File.SetArray(BaselineSection, TEXT("Baselines"), Entries);
+		File.Dirty = true;
+		if(!File.Write(Filename))
+		{
+			Test.AddError(FString::Printf(TEXT("Failed to write the baseline of %s to %s"), *Name, *Filename));
+			return false;
+		}
+		Test.AddInfo(FString::Printf(TEXT("Wrote the baseline of %s to %s"), *Name, *Filename));
+		return true;
+	}
+
+	TArray<FString> Fields;
+	if(EntryIndex == INDEX_NONE || Entries[EntryIndex].ParseIntoArray(Fields, TEXT(",")) != 4)
+	{
+		//A benchmark without a baseline can't regress, which would let new benchmarks pass silently forever
+		Test.AddError(FString::Printf(TEXT("%s has no baseline in %s, record one with -updatebaseline"), *Name, *Filename));
+		return false;
+	}
+	FString ThresholdString;
+	const double Threshold = File.GetString(BaselineSection, TEXT("RegressionThreshold"), ThresholdString) ? FCString::Atod(*ThresholdString) : 0.2;
+	const double BaselineP50Ms = FCString::Atod(*Fields[1]);
+	const double BaselineP99Ms = FCString::Atod(*Fields[2]);
+	const int64 BaselineP50Allocations = FCString::Atoi64(*Fields[3]);
+	const double Limit = 1.0 + Threshold;
+	if(Result.P50Ms > BaselineP50Ms * Limit || Result.P99Ms > BaselineP99Ms * Limit || Result.P50Allocations > FMath::CeilToInt64(BaselineP50Allocations * Limit))
+	{
+		Test.AddError(FString::Printf(TEXT("%s regressed: p50 %.4f ms (baseline %.4f), p99 %.4f ms (baseline %.4f), allocations %lld (baseline %lld)"),
+			*Name, Result.P50Ms, BaselineP50Ms, Result.P99Ms, BaselineP99Ms, Result.P50Allocations, BaselineP50Allocations));
+		return false;
+	}
+	return true;
+}
+
+void FGridPlacerPerfHarness::BuildTestLevel(int32 Extent)
+{
+	FRandomStream Random(42);
+	for(int32 X = 0; X < Extent; ++X)
+	{
+		for(int32 Y = 0; Y < Extent; ++Y)
+		{
+			const FTransform Transform(FRotator(0.0f, Random.FRandRange(0.0f, 360.0f), 0.0f),
+				TestLevelOrigin + FVector(X * TestLevelSpacing, Y * TestLevelSpacing, Random.FRandRange(0.0f, 200.0f)));
+			AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform);
+			Actor->GetStaticMeshComponent()->SetStaticMesh(Mesh);
+		}
+	}
+}
+
+UPlacementTool* FGridPlacerPerfHarness::CreateTool(int32 NumPaletteObjects)
+{
+	if(!World)
+	{
+		Test.AddError(TEXT("GridPlacer performance tests need the editor and the engine's basic shapes"));
+		return nullptr;
+	}
+	Tool = NewObject<UPlacementTool>(GetTransientPackage());
+	Tool->AddToRoot();
+	Tool->SetWorld(World);
+	//Known settings instead of whatever the last editor session left behind, and the user's saved settings and journal stay untouched.
+	//There is no tool manager, so nothing the tool reports through it may be turned on either
+	Tool->UseSavedSettings = false;
+	Tool->Setup();
+
+	UPlacementToolProperties* Properties = Tool->Properties;
+	Properties->ToolMode = EPlacementToolMode::Place;
+	Properties->GridSpaceMode = EGridSpaceMode::Global;
+	Properties->GridOrigin = FVector::ZeroVector;
+	Properties->GridRotation = FRotator::ZeroRotator;
+	Properties->GridSize = FVector2D(100.0f, 100.0f);
+	Properties->GridLayerHeight = 100.0f;
+	Properties->SnappingMode = ESnappingMode::Center;
+	Properties->PreventOverlaps = true;
+	Properties->PlaceAsInstances = false;
+	Properties->PalettePickingMode = EPalettePickingMode::Random;
+	Properties->CurrentPlacementHeightOffset = 0.0f;
+	Properties->CurrentPlacementRotation = FRotator::ZeroRotator;
+	Properties->CurrentPlacementScale = 1.0f;
+	Properties->RandomizeHeightOffset = false;
+	Properties->RandomizeRotation = false;
+	Properties->RandomizeScale = false;
+	Properties->HiddenCellMode = EHiddenCellMode::Off;
+	Properties->SnapToSockets = false;
+	Properties->DropToSurface = false;
+	Properties->AutoStack = false;
+	Properties->ApplyVariation = false;
+	Tool->JournalActions->RecordJournal = false;
+
+	for(int32 i = 0; i < NumPaletteObjects; ++i)
+	{
+		UPaletteObject* PaletteObject = NewObject<UPaletteObject>(Tool);
+		PaletteObject->StaticMesh = Mesh;
+		PaletteObject->ObjectType = EPaletteObjectType::StaticMesh;
+		PaletteObject->Asset = Mesh;
+		PaletteObject->SetIsActiveInPalette(true);
+		Properties->ObjectPalette.ObjectsInPalette.Add(PaletteObject);
+	}
+	Properties->ObjectPalette.NotifyActivePaletteChanged();
+	return Tool;
+}
+
+FString FGridPlacerPerfHarness::GetBaselineFilename() const
+{
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("GridPlacer"));
+	return Plugin.IsValid() ? FPaths::Combine(Plugin->GetBaseDir(), TEXT("Config"), TEXT("DefaultGridPlacer.ini")) : FString();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlacerPerfPreviewSweepTest, "GridPlacer.Perf.PreviewSweep", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGridPlacerPerfPreviewSweepTest::RunTest(const FString& Parameters)
+{
+	return FGridPlacerPerfHarness(*this).RunPreviewSweep();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlacerPerfClickPlaceActorsTest, "GridPlacer.Perf.ClickPlaceActors", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGridPlacerPerfClickPlaceActorsTest::RunTest(const FString& Parameters)
+{
+	return FGridPlacerPerfHarness(*this).RunClickPlace(false);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlacerPerfClickPlaceInstancesTest, "GridPlacer.Perf.ClickPlaceInstances", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGridPlacerPerfClickPlaceInstancesTest::RunTest(const FString& Parameters)
+{
+	return FGridPlacerPerfHarness(*this).RunClickPlace(true);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlacerPerfPaletteToggleTest, "GridPlacer.Perf.PaletteToggle", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGridPlacerPerfPaletteToggleTest::RunTest(const FString& Parameters)
+{
+	return FGridPlacerPerfHarness(*this).RunPaletteToggle();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlacerPerfPalettePickTest, "GridPlacer.Perf.PalettePick", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGridPlacerPerfPalettePickTest::RunTest(const FString& Parameters)
+{
+	return FGridPlacerPerfHarness(*this).RunPalettePick();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlacerPerfLocalTraceSweepTest, "GridPlacer.Perf.LocalTraceSweep", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGridPlacerPerfLocalTraceSweepTest::RunTest(const FString& Parameters)
+{
+	return FGridPlacerPerfHarness(*this).RunLocalTraceSweep();
+}
+
+#endif
@@ -4,10 +4,15 @@
 #include "PlacementTool.h"
 #include "InteractiveToolManager.h"
 #include "ToolBuilderUtil.h"
+#include "BaseBehaviors/ClickDragBehavior.h"
+#include "BaseBehaviors/MouseHoverBehavior.h"
 
 // for raycast into World
 #include "CollisionQueryParams.h"
 #include "PlacementToolInputBehavior.h"
+#include "GridPlacerSubsystem.h"
+#include "GridPlacerStats.h"
+#include "GridPlacerGridMathConversions.h"
 #include "Engine/World.h"
 
 #include "SceneManagement.h"
@@ -15,10 +20,20 @@
 
 #include "Engine/StaticMeshActor.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Editor.h"
+#include "Engine/Selection.h"
+#include "Misc/ITransaction.h"
+#include "Async/ParallelFor.h"
+#include "Components/SplineComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMeshSocket.h"
 
 // localization namespace
 #define LOCTEXT_NAMESPACE "UGridPlacerPlacementTool"
 
+static_assert(static_cast<uint8>(ESnappingMode::None) == static_cast<uint8>(GridPlacerMath::ESnapMode::None), "ESnappingMode and GridPlacerMath::ESnapMode have to match");
+static_assert(static_cast<uint8>(EGridSpaceMode::Custom) == static_cast<uint8>(GridPlacerMath::EOffsetSpace::Custom), "EGridSpaceMode and GridPlacerMath::EOffsetSpace have to match");
+
 #pragma region Tool
 void UPlacementTool::SetWorld(UWorld* World)
 {
@@ -31,14 +46,47 @@ void UPlacementTool::Setup()
 	UInteractiveTool::Setup();
 
 	// add default button input behaviors for devices
-	UMultiClickSequenceInputBehavior* MouseBehavior = NewObject<UMultiClickSequenceInputBehavior>();
+	UClickDragInputBehavior* MouseBehavior = NewObject<UClickDragInputBehavior>(this);
 	MouseBehavior->Initialize(this);
-	//MouseBehavior->Modifiers.RegisterModifier(IgnoreSnappingModifier, FInputDeviceState::IsShiftKeyDown);
 	AddInputBehavior(MouseBehavior);
 
+	UMouseHoverBehavior* HoverBehavior = NewObject<UMouseHoverBehavior>(this);
+	HoverBehavior->Initialize(this);
+	AddInputBehavior(HoverBehavior);
+
 	// Create the property set and register it with the Tool
 	Properties = NewObject<UPlacementToolProperties>(this, "Parameters");
 	AddToolPropertySource(Properties);
+	ReplaceActions = NewObject<UPlacementToolReplaceActions>(this, "Replace");
+	ReplaceActions->Initialize(this);
+	AddToolPropertySource(ReplaceActions);
+	SplineActions = NewObject<UPlacementToolSplineActions>(this, "Spline");
+	SplineActions->Initialize(this);
+	AddToolPropertySource(SplineActions);
+	StampActions = NewObject<UPlacementToolStampActions>(this, "Stamp");
+	StampActions->Initialize(this);
+	AddToolPropertySource(StampActions);
+	BakeActions = NewObject<UPlacementToolBakeActions>(this, "Bake");
+	BakeActions->Initialize(this);
+	AddToolPropertySource(BakeActions);
+	ConsolidateActions = NewObject<UPlacementToolConsolidateActions>(this, "Consolidate");
+	ConsolidateActions->Initialize(this);
+	AddToolPropertySource(ConsolidateActions);
+	MergeActions = NewObject<UPlacementToolMergeActions>(this, "Merge");
+	MergeActions->Initialize(this);
+	AddToolPropertySource(MergeActions);
+	HiddenCellActions = NewObject<UPlacementToolHiddenCellActions>(this, "HiddenCells");
+	HiddenCellActions->Initialize(this);
+	AddToolPropertySource(HiddenCellActions);
+	GenerateActions = NewObject<UPlacementToolGenerateActions>(this, "Generate");
+	GenerateActions->Initialize(this);
+	AddToolPropertySource(GenerateActions);
+	ImportActions = NewObject<UPlacementToolImportActions>(this, "Import");
+	ImportActions->Initialize(this);
+	AddToolPropertySource(ImportActions);
+	JournalActions = NewObject<UPlacementToolJournalActions>(this, "Journal");
+	JournalActions->Initialize(this);
+	AddToolPropertySource(JournalActions);
 
 	Properties->ObjectPalette.OnActivePaletteChanged.BindUFunction(this, FName("OnActivePaletteChanged"));
 	
@@ -46,11 +94,34 @@ void UPlacementTool::Setup()
 	PlacementToolBehavior->Initialize(this);
 	AddInputBehavior(PlacementToolBehavior.Get());
 
-	Properties->RestoreProperties(this);
+	if(UGridPlacerSubsystem* Subsystem = GetSubsystem())
+	{
+		ItemAddedHandle = Subsystem->OnItemAdded.AddUObject(this, &UPlacementTool::OnPlacedItemAdded);
+		ItemRemovedHandle = Subsystem->OnItemRemoved.AddUObject(this, &UPlacementTool::OnPlacedItemRemoved);
+	}
+
+	if(UseSavedSettings)
+	{
+		Properties->RestoreProperties(this);
+		BakeActions->RestoreProperties(this);
+		ConsolidateActions->RestoreProperties(this);
+		MergeActions->RestoreProperties(this);
+		GenerateActions->RestoreProperties(this);
+		ImportActions->RestoreProperties(this);
+		JournalActions->RestoreProperties(this);
+	}
+	PathSeed = FMath::Rand();
+	RebuildAutotileMeshes();
+	UpdateModePropertySets();
+	//Hidden cells are only kept up to date while the occupancy is
+	if(Properties->HiddenCellMode != EHiddenCellMode::Off)
+		EnsureOccupancy();
+	UpdateJournal();
 }
 
 void UPlacementTool::Render(IToolsContextRenderAPI* RenderAPI)
 {
+	GRIDPLACER_SCOPE(Render);
 	FPrimitiveDrawInterface* PDI = RenderAPI->GetPrimitiveDrawInterface();
 
 	//Grid
@@ -68,6 +139,91 @@ void UPlacementTool::Render(IToolsContextRenderAPI* RenderAPI)
 		FLinearColor::Yellow, SDPG_Foreground, 2.0f);
 	PDI->DrawPoint(GridToWorldSpace(SnappedPlacementPoint) + HeightOffsetVector,
 		FLinearColor::Yellow, 20.0f, SDPG_Foreground);
+	//Footprint of the previewed object
+	if(Properties->ToolMode == EPlacementToolMode::Place && Properties->PreventOverlaps && PreviewActor && PreviewFootprint.IsValid())
+	{
+		const FGridPlacerFrame Frame = GetGridFrame();
+		DrawWireBox(PDI, Frame.GridToWorld.ToMatrixWithScale(), Frame.GetCellBounds(PreviewFootprint),
+			PreviewBlocked ? FLinearColor::Red : FLinearColor::Green, SDPG_Foreground, 2.0f);
+	}
+	//Scatter brush, drawn at the current height offset
+	if(Properties->ToolMode == EPlacementToolMode::Scatter)
+	{
+		const FGridPlacerFrame Frame = GetGridFrame();
+		const FBox2D Region = GetScatterRegion();
+		const float Height = Properties->CurrentPlacementHeightOffset;
+		DrawWireBox(PDI, Frame.GridToWorld.ToMatrixWithScale(), FBox(FVector(Region.Min, Height), FVector(Region.Max, Height)), FLinearColor::Green, SDPG_Foreground, 2.0f);
+	}
+	//Erase and replace brush
+	else if(Properties->ToolMode == EPlacementToolMode::Erase || Properties->ToolMode == EPlacementToolMode::Replace)
+	{
+		const FGridPlacerFrame Frame = GetGridFrame();
+		FGridPlacerCellBox BrushCells = GetBrushCells();
+		//Drawing every layer would just fill the screen, show the current one
+		if(Properties->BrushAffectsAllLayers)
+			BrushCells.Min.Z = BrushCells.Max.Z = FMath::FloorToInt32(Properties->CurrentPlacementHeightOffset / Properties->GridLayerHeight);
+		DrawWireBox(PDI, Frame.GridToWorld.ToMatrixWithScale(), Frame.GetCellBounds(BrushCells),
+			Properties->ToolMode == EPlacementToolMode::Erase ? FLinearColor::Red : FLinearColor::Yellow, SDPG_Foreground, 2.0f);
+	}
+	//Actor classes of the previewed stamp, its meshes are part of the preview actor
+	if(Properties->ToolMode == EPlacementToolMode::Place && PreviewActor && PreviewPaletteObject && PreviewPaletteObject->ObjectType == EPaletteObjectType::Stamp)
+	{
+		if(UGridPlacerSubsystem* Subsystem = GetSubsystem())
+		{
+			for(const FGridPlacerStampPiece& Piece : PreviewPaletteObject->StampPieces)
+			{
+				if(Cast<UStaticMesh>(Piece.Asset))
+					continue;
+				const FBox Bounds = Subsystem->GetAssetBounds(Piece.Asset);
+				if(Bounds.IsValid)
+					DrawWireBox(PDI, (Piece.RelativeTransform * PreviewActor->GetActorTransform()).ToMatrixWithScale(), Bounds, FLinearColor::Green, SDPG_Foreground, 1.0f);
+			}
+		}
+	}
+	//Rectangle to copy, drawn on the current layer
+	if(Properties->ToolMode == EPlacementToolMode::Copy)
+	{
+		const FGridPlacerFrame Frame = GetGridFrame();
+		FGridPlacerCellBox CopyCells = GetCopyCells();
+		CopyCells.Min.Z = CopyCells.Max.Z = FMath::FloorToInt32(Properties->CurrentPlacementHeightOffset / Properties->GridLayerHeight);
+		DrawWireBox(PDI, Frame.GridToWorld.ToMatrixWithScale(), Frame.GetCellBounds(CopyCells), FLinearColor(0.0f, 1.0f, 1.0f), SDPG_Foreground, 2.0f);
+	}
+	//Outline of the pasted cells and the actor classes in them, the meshes are part of the paste preview
+	if(Properties->ToolMode == EPlacementToolMode::Paste && !RegionBuffer.IsEmpty())
+	{
+		const FTransform PasteTransform = GetPasteTransform();
+		const FIntPoint Pivot = RegionBuffer.GetPivotCell();
+		const FVector2D CellSize = Properties->GridSize;
+		const FBox Outline(FVector((RegionBuffer.Cells.Min.X - Pivot.X) * CellSize.X, (RegionBuffer.Cells.Min.Y - Pivot.Y) * CellSize.Y, 0.0),
+			FVector((RegionBuffer.Cells.Max.X + 1 - Pivot.X) * CellSize.X, (RegionBuffer.Cells.Max.Y + 1 - Pivot.Y) * CellSize.Y, 0.0));
+		DrawWireBox(PDI, PasteTransform.ToMatrixWithScale(), Outline, FLinearColor(0.0f, 1.0f, 1.0f), SDPG_Foreground, 2.0f);
+		if(UGridPlacerSubsystem* Subsystem = GetSubsystem())
+		{
+			for(const FGridPlacerRegionPiece& Piece : RegionBuffer.Pieces)
+			{
+				UObject* Asset = RegionBuffer.Assets[Piece.AssetIndex];
+				if(Cast<UStaticMesh>(Asset))
+					continue;
+				const FBox Bounds = Subsystem->GetAssetBounds(Asset);
+				if(Bounds.IsValid)
+					DrawWireBox(PDI, (Piece.GridTransform * PasteTransform).ToMatrixWithScale(), Bounds, FLinearColor::Green, SDPG_Foreground, 1.0f);
+			}
+		}
+	}
+	//Start of the line, the instanced preview covers the meshes of the line, actor classes are drawn as their bounds
+	if(Properties->ToolMode == EPlacementToolMode::Line && HasLineStart)
+		PDI->DrawPoint(GridToWorldSpace(LineStart) + HeightOffsetVector, FLinearColor(0.0f, 1.0f, 1.0f), 20.0f, SDPG_Foreground);
+	if(UGridPlacerSubsystem* Subsystem = GetSubsystem())
+	{
+		for(const FGridPlacerSpawnRequest& Request : PathRequests)
+		{
+			if(Cast<UStaticMesh>(Request.Asset))
+				continue;
+			const FBox Bounds = Subsystem->GetAssetBounds(Request.Asset);
+			if(Bounds.IsValid)
+				DrawWireBox(PDI, Request.Transform.ToMatrixWithScale(), Bounds, FLinearColor::Green, SDPG_Foreground, 1.0f);
+		}
+	}
 }
 
 void UPlacementTool::DrawGrid(IToolsContextRenderAPI* RenderAPI)
@@ -176,15 +332,24 @@ void UPlacementTool::DrawRotationAxis(IToolsContextRenderAPI* RenderAPI)
 	}
 }
 
+UGridPlacerSubsystem* UPlacementTool::GetSubsystem() const
+{
+	return TargetWorld ? TargetWorld->GetSubsystem<UGridPlacerSubsystem>() : nullptr;
+}
+
 AActor* UPlacementTool::SpawnPaletteObject(UPaletteObject* PaletteObject, const FName& Name)
 {
+	GRIDPLACER_SCOPE(SpawnPaletteObject);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	//Previews come and go all the time, even in the middle of a stroke, they never belong in the undo history
+	TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
 	FActorSpawnParameters PreviewSpawnParams;
 	PreviewSpawnParams.Name = MakeUniqueObjectName(nullptr, AActor::StaticClass(), Name);
 	PreviewSpawnParams.bTemporaryEditorActor = true;
-	if(PaletteObject->ObjectType == EPaletteObjectType::StaticMesh)
+	if(PaletteObject->ObjectType == EPaletteObjectType::StaticMesh || PaletteObject->ObjectType == EPaletteObjectType::Autotile)
 	{
 		AStaticMeshActor* Preview = TargetWorld->SpawnActor<AStaticMeshActor>(PreviewSpawnParams);
-		Preview->GetStaticMeshComponent()->SetStaticMesh(PaletteObject->StaticMesh);
+		Preview->GetStaticMeshComponent()->SetStaticMesh(Cast<UStaticMesh>(PaletteObject->GetPlacedAsset()));
 		Preview->GetStaticMeshComponent()->SetCanEverAffectNavigation(false);
 		return Preview;
 	}
@@ -192,11 +357,56 @@ AActor* UPlacementTool::SpawnPaletteObject(UPaletteObject* PaletteObject, const
 	{
 		return TargetWorld->SpawnActor(PaletteObject->ActorClass, 0, 0, PreviewSpawnParams);
 	}
+	if(PaletteObject->ObjectType == EPaletteObjectType::Stamp)
+	{
+		//Pieces sit below the actor root, so moving the preview moves the whole stamp
+		AActor* Preview = SpawnPreviewHost(Name);
+		TMap<UStaticMesh*, UInstancedStaticMeshComponent*> Components;
+		for(const FGridPlacerStampPiece& Piece : PaletteObject->StampPieces)
+		{
+			if(UStaticMesh* StaticMesh = Cast<UStaticMesh>(Piece.Asset))
+			{
+				UInstancedStaticMeshComponent*& Component = Components.FindOrAdd(StaticMesh);
+				if(!Component)
+					Component = AddPreviewComponent(Preview, StaticMesh);
+				Component->AddInstance(Piece.RelativeTransform);
+			}
+		}
+		return Preview;
+	}
 	return nullptr;
 }
 
+AActor* UPlacementTool::SpawnPreviewHost(const FName& Name)
+{
+	TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = MakeUniqueObjectName(nullptr, AActor::StaticClass(), Name);
+	SpawnParams.bTemporaryEditorActor = true;
+	AActor* Host = TargetWorld->SpawnActor<AActor>(SpawnParams);
+	USceneComponent* Root = NewObject<USceneComponent>(Host, TEXT("Root"));
+	Host->SetRootComponent(Root);
+	Root->RegisterComponent();
+	return Host;
+}
+
+UInstancedStaticMeshComponent* UPlacementTool::AddPreviewComponent(AActor* Host, UStaticMesh* StaticMesh)
+{
+	//Previews must not be hit by the traces that position them
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(Host);
+	Component->SetStaticMesh(StaticMesh);
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Component->SetCanEverAffectNavigation(false);
+	Component->SetupAttachment(Host->GetRootComponent());
+	Component->RegisterComponent();
+	return Component;
+}
+
 void UPlacementTool::SpawnPreviewActor(UPaletteObject* PaletteObject)
 {
+	//Keep the current preview when the same object got picked again
+	if(PreviewActor && PaletteObject == PreviewPaletteObject)
+		return;
 	DestroyPreviewActor();
 
 	PreviewPaletteObject = PaletteObject;
@@ -208,337 +418,1781 @@ void UPlacementTool::DestroyPreviewActor()
 {
 	if(PreviewActor)
 	{
+		TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
 		TargetWorld->DestroyActor(PreviewActor);
+		PreviewActor = nullptr;
 		PreviewPaletteObject = nullptr;
 	}
 }
 
-void UPlacementTool::RealizePreview()
+EBulkPlacementResult UPlacementTool::RealizePreview()
 {
+	GRIDPLACER_SCOPE(RealizePreview);
+	LLM_SCOPE_BYTAG(GridPlacer);
 	if(!PreviewActor || !PreviewPaletteObject)
-		return;
+		return EBulkPlacementResult::None;
 
-	if(GEditor) GEditor->BeginTransaction(FText::FromString("Place Object"));
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return EBulkPlacementResult::None;
 
-	FName SpawnedObjectName;
-	if(PreviewPaletteObject->ObjectType == EPaletteObjectType::StaticMesh)
-		SpawnedObjectName = FName(PreviewPaletteObject->StaticMesh->GetName());
-	else if(PreviewPaletteObject->ObjectType == EPaletteObjectType::ActorClass)
-		SpawnedObjectName = FName(PreviewPaletteObject->ActorClass->GetClass()->GetName());
-	AActor* SpawnedObject = SpawnPaletteObject(PreviewPaletteObject, SpawnedObjectName);
-	SpawnedObject->SetActorLocation(PreviewActor->GetActorLocation());
-	SpawnedObject->SetActorRotation(PreviewActor->GetActorRotation());
-	SpawnedObject->SetActorScale3D(PreviewActor->GetActorScale3D());
+	if(PreviewPaletteObject->ObjectType == EPaletteObjectType::Autotile)
+		return PreviewPaletteObject->AutotileSet && PlaceAutotileCell(PreviewPaletteObject->AutotileSet, PreviewActor->GetActorTransform())
+			? EBulkPlacementResult::Placed : EBulkPlacementResult::None;
+	if(PreviewPaletteObject->ObjectType == EPaletteObjectType::Stamp)
+		return PlaceStamp(PreviewPaletteObject, PreviewActor->GetActorTransform());
 
-	if(GEditor) GEditor->EndTransaction();
+	FGridPlacerSpawnRequest Request;
+	Request.Asset = PreviewPaletteObject->GetPlacedAsset();
+	Request.Transform = PreviewActor->GetActorTransform();
+	Request.AsInstance = Properties->PlaceAsInstances && PreviewPaletteObject->ObjectType == EPaletteObjectType::StaticMesh;
+	FRandomStream Stream(FMath::Rand());
+	Request.CustomData = GetPlacementVariation(PreviewPaletteObject, Stream);
+
+	return Subsystem->PlaceBatch(MakeArrayView(&Request, 1), LOCTEXT("PlaceObject", "Place Object")).Num() > 0 ? EBulkPlacementResult::Placed : EBulkPlacementResult::None;
 }
 
-void UPlacementTool::OnPropertyModified(UObject* PropertySet, FProperty* Property)
+EBulkPlacementResult UPlacementTool::PlaceStamp(const UPaletteObject* Stamp, const FTransform& StampTransform)
 {
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || Stamp->StampPieces.Num() == 0)
+		return EBulkPlacementResult::None;
+	//All pieces share the variation of the stamp, rolled once per placement
+	FRandomStream Stream(FMath::Rand());
+	const TArray<float> Variation = GetPlacementVariation(Stamp, Stream);
+	TArray<FGridPlacerSpawnRequest> Requests;
+	Requests.Reserve(Stamp->StampPieces.Num());
+	for(const FGridPlacerStampPiece& Piece : Stamp->StampPieces)
+	{
+		if(!Piece.Asset)
+			continue;
+		FGridPlacerSpawnRequest& Request = Requests.AddDefaulted_GetRef();
+		Request.Asset = Piece.Asset;
+		Request.Transform = Piece.RelativeTransform * StampTransform;
+		Request.AsInstance = Properties->PlaceAsInstances && Cast<UStaticMesh>(Piece.Asset);
+		//The variation only overrides the floats it writes, the rest keeps what was captured
+		Request.CustomData = Piece.CustomData;
+		for(int32 i = 0; i < Variation.Num(); ++i)
+		{
+			if(i >= Request.CustomData.Num())
+				Request.CustomData.Add(Variation[i]);
+			else if(!FMath::IsNaN(Variation[i]))
+				Request.CustomData[i] = Variation[i];
+		}
+	}
+	return PlaceBulk(MoveTemp(Requests), LOCTEXT("PlaceStamp", "Place Stamp"));
 }
 
-void UPlacementTool::Shutdown(EToolShutdownType ShutdownType){
-	Super::Shutdown(ShutdownType);
-	
-	DestroyPreviewActor();
+EBulkPlacementResult UPlacementTool::PlaceBulk(TArray<FGridPlacerSpawnRequest>&& Requests, const FText& Description, TArray<uint32>* OutIds)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || Requests.Num() == 0)
+		return EBulkPlacementResult::None;
+	if(Requests.Num() <= Properties->QueuedPlacementThreshold)
+	{
+		TArray<uint32> NewIds = Subsystem->PlaceBatch(Requests, Description);
+		const EBulkPlacementResult Result = NewIds.Num() > 0 ? EBulkPlacementResult::Placed : EBulkPlacementResult::None;
+		if(OutIds)
+			OutIds->Append(MoveTemp(NewIds));
+		return Result;
+	}
 
-	Properties->SaveProperties(this);
+	FViewCameraState CameraState;
+	GetToolManager()->GetContextQueriesAPI()->GetCurrentViewState(CameraState);
+	Subsystem->PlaceBatchTimeSliced(MoveTemp(Requests), Description, CameraState.Position, Properties->QueuedPlacementBudgetMs);
+	return EBulkPlacementResult::Queued;
 }
 
-void UPlacementTool::ChangeHeightOffset(EPlacementParameterChangeMode ChangeMode)
+void UPlacementTool::CaptureStamp()
 {
-	switch(ChangeMode)
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || !GEditor)
+		return;
+
+	//Placed objects are captured as what GridPlacer placed, anything else as its mesh or class. Transforms are in world space until the pivot is known
+	TArray<FGridPlacerStampPiece> Pieces;
+	for(FSelectionIterator It(*GEditor->GetSelectedActors()); It; ++It)
 	{
-		case IncreaseMajor: Properties->CurrentPlacementHeightOffset += Properties->HeightOffsetMajorIncrement; break;
-		case DecreaseMajor: Properties->CurrentPlacementHeightOffset -= Properties->HeightOffsetMajorIncrement; break;
-		case IncreaseMinor: Properties->CurrentPlacementHeightOffset += Properties->HeightOffsetMinorIncrement; break;
-		case DecreaseMinor: Properties->CurrentPlacementHeightOffset -= Properties->HeightOffsetMinorIncrement; break;
+		AActor* Actor = Cast<AActor>(*It);
+		if(!Actor || Actor == PreviewActor || Actor == PathPreviewActor)
+			continue;
+		if(const uint32 Id = Subsystem->FindItemId(Actor))
+		{
+			const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+			Pieces.Add({Item->Asset.Get(), Item->Transform, Subsystem->GetItemCustomData(*Item)});
+		}
+		else if(Actor->Tags.Contains(UGridPlacerSubsystem::InstanceHostTag))
+		{
+			for(const TPair<uint32, FGridPlacerPlacedItem>& Pair : Subsystem->GetItems())
+				if(Pair.Value.IsInstance() && Pair.Value.Component.IsValid() && Pair.Value.Component->GetOwner() == Actor)
+					Pieces.Add({Pair.Value.Asset.Get(), Pair.Value.Transform, Subsystem->GetItemCustomData(Pair.Value)});
+		}
+		else if(const AStaticMeshActor* MeshActor = Cast<AStaticMeshActor>(Actor))
+		{
+			if(UStaticMesh* StaticMesh = MeshActor->GetStaticMeshComponent()->GetStaticMesh())
+				Pieces.Add({StaticMesh, Actor->GetActorTransform(), MeshActor->GetStaticMeshComponent()->GetDefaultCustomPrimitiveData().Data});
+		}
+		else
+		{
+			const UPrimitiveComponent* Primitive = Actor->FindComponentByClass<UPrimitiveComponent>();
+			Pieces.Add({Actor->GetClass(), Actor->GetActorTransform(), Primitive ? Primitive->GetDefaultCustomPrimitiveData().Data : TArray<float>()});
+		}
 	}
+	Pieces.RemoveAll([](const FGridPlacerStampPiece& Piece) { return !Piece.Asset; });
+	if(Pieces.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("StampNoSelection", "Select the actors to capture as a stamp first"), EToolMessageLevel::UserWarning);
+		return;
+	}
+
+	//The pivot snaps like the cursor would, below the center of the selection and on the lowest layer it touches
+	const FTransform WorldToGrid = GetGridFrame().GridToWorld.Inverse();
+	FBox GridBounds(ForceInit);
+	for(const FGridPlacerStampPiece& Piece : Pieces)
+	{
+		const FBox AssetBounds = Subsystem->GetAssetBounds(Piece.Asset);
+		GridBounds += WorldToGridSpace(Piece.RelativeTransform.GetLocation());
+		if(AssetBounds.IsValid)
+			GridBounds += AssetBounds.TransformBy(Piece.RelativeTransform).TransformBy(WorldToGrid);
+	}
+	FVector Pivot = GridPlacerMath::ToFVector(GridPlacerMath::Snap(GridPlacerMath::ToGridVector(GridBounds.GetCenter()),
+		Properties->GridSize.X, Properties->GridSize.Y, static_cast<GridPlacerMath::ESnapMode>(Properties->SnappingMode)));
+	Pivot.Z = FMath::FloorToDouble(GridBounds.Min.Z / Properties->GridLayerHeight) * Properties->GridLayerHeight;
+	const FTransform PivotToWorld(Properties->GridRotation, GridToWorldSpace(Pivot));
+
+	UPaletteObject* Stamp = NewObject<UPaletteObject>();
+	Stamp->ObjectType = EPaletteObjectType::Stamp;
+	Stamp->StampPieces.Reserve(Pieces.Num());
+	for(const FGridPlacerStampPiece& Piece : Pieces)
+	{
+		const FTransform RelativeTransform = Piece.RelativeTransform.GetRelativeTransform(PivotToWorld);
+		Stamp->StampPieces.Add({Piece.Asset, RelativeTransform, Piece.CustomData});
+		const FBox AssetBounds = Subsystem->GetAssetBounds(Piece.Asset);
+		Stamp->StampBounds += AssetBounds.IsValid ? AssetBounds.TransformBy(RelativeTransform) : FBox(RelativeTransform.GetLocation(), RelativeTransform.GetLocation());
+		//The palette shows the first mesh of the stamp
+		if(!Stamp->Asset && Cast<UStaticMesh>(Piece.Asset))
+			Stamp->Asset = Piece.Asset;
+	}
+	Stamp->SetIsActiveInPalette(true);
+	Properties->ObjectPalette.ObjectsInPalette.Add(Stamp);
+	Properties->ObjectPalette.NotifyActivePaletteChanged();
+	NotifyOfPropertyChangeByTool(Properties);
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("StampCaptured", "Captured a stamp of {0} objects"), Pieces.Num()), EToolMessageLevel::UserNotification);
 }
 
-void UPlacementTool::RandomizeHeightOffset()
+FIntPoint UPlacementTool::GetHoveredCell() const
+{
+	//CurrentGridCell holds the grid space corner of the hovered cell
+	return FIntPoint(FMath::RoundToInt32(CurrentGridCell.X / Properties->GridSize.X), FMath::RoundToInt32(CurrentGridCell.Y / Properties->GridSize.Y));
+}
+
+FGridPlacerCellBox UPlacementTool::GetBrushCells() const
 {
-	if(FMath::Abs(Properties->HeightOffsetRandomizationDivisions) > 0)
+	const FIntPoint HoveredCell = GetHoveredCell();
+	const FIntVector Center(HoveredCell.X, HoveredCell.Y, FMath::FloorToInt32(Properties->CurrentPlacementHeightOffset / Properties->GridLayerHeight));
+	const int32 Size = FMath::Max(Properties->BrushSize, 1);
+	FGridPlacerCellBox Cells(Center - FIntVector((Size - 1) / 2, (Size - 1) / 2, 0), Center + FIntVector(Size / 2, Size / 2, 0));
+	if(Properties->BrushAffectsAllLayers)
 	{
-		Properties->CurrentPlacementHeightOffset = Properties->RandomHeightOffsetRange.Min + (Properties->RandomHeightOffsetRange.Size() / Properties->HeightOffsetRandomizationDivisions) * FMath::RandRange(0, FMath::Abs(Properties->HeightOffsetRandomizationDivisions));
+		Cells.Min.Z = -MaxBrushLayers;
+		Cells.Max.Z = MaxBrushLayers;
 	}
-	else
-		Properties->CurrentPlacementHeightOffset = FMath::RandRange(Properties->RandomHeightOffsetRange.Min, Properties->RandomHeightOffsetRange.Max);
+	return Cells;
 }
 
-void UPlacementTool::CycleRotationAxis()
+FGridPlacerCellBox UPlacementTool::GetCopyCells() const
 {
-	Properties->CurrentRotationAxis = static_cast<ERotationAxis>((static_cast<uint8>(Properties->CurrentRotationAxis) + 1) % 3);
+	const FIntPoint HoveredCell = GetHoveredCell();
+	const FIntPoint Start = HasCopyStart ? CopyStart : HoveredCell;
+	return FGridPlacerCellBox(FIntVector(FMath::Min(Start.X, HoveredCell.X), FMath::Min(Start.Y, HoveredCell.Y), -MaxBrushLayers),
+		FIntVector(FMath::Max(Start.X, HoveredCell.X), FMath::Max(Start.Y, HoveredCell.Y), MaxBrushLayers));
 }
 
-void UPlacementTool::ChangeRotationOffset(EPlacementParameterChangeMode ChangeMode)
+int32 UPlacementTool::CopyRegion(const FGridPlacerCellBox& Cells)
 {
-	float CurrentRotationOnAxis = 0.0f;
-	switch(Properties->CurrentRotationAxis)
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return 0;
+	GRIDPLACER_SCOPE(CopyRegion);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	const FGridPlacerFrame Frame = GetGridFrame();
+	TArray<uint32> Candidates;
+	Subsystem->QueryItems(Frame.GetCellBounds(Cells).TransformBy(Frame.GridToWorld), Candidates);
+	//Pasting recreates objects in the order they were placed
+	Candidates.Sort();
+
+	DestroyPastePreview();
+	RegionBuffer.Reset();
+	RegionBuffer.Cells = Cells;
+	const FIntPoint Pivot = RegionBuffer.GetPivotCell();
+	const FTransform PivotToWorld(Properties->GridRotation, GridToWorldSpace(FVector(Pivot.X * Properties->GridSize.X, Pivot.Y * Properties->GridSize.Y, 0.0)));
+	TMap<UObject*, int32> AssetIndices;
+	for(const uint32 Id : Candidates)
 	{
-		case ERotationAxis::X: CurrentRotationOnAxis = Properties->CurrentPlacementRotation.Roll; break;
-		case ERotationAxis::Y: CurrentRotationOnAxis = Properties->CurrentPlacementRotation.Pitch; break;
-		case ERotationAxis::Z: CurrentRotationOnAxis = Properties->CurrentPlacementRotation.Yaw; break;
+		const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+		if(!Item || !Item->IsValid() || !Item->Asset.IsValid())
+			continue;
+		//Objects belong to the cell their pivot is in, so neighboring regions never both copy the same object
+		const FIntVector Cell = Frame.WorldToCell(Item->Transform.GetLocation());
+		if(Cell.X < Cells.Min.X || Cell.X > Cells.Max.X || Cell.Y < Cells.Min.Y || Cell.Y > Cells.Max.Y)
+			continue;
+		UObject* Asset = Item->Asset.Get();
+		const int32* AssetIndex = AssetIndices.Find(Asset);
+		if(!AssetIndex)
+			AssetIndex = &AssetIndices.Add(Asset, RegionBuffer.Assets.Add(Asset));
+		RegionBuffer.Pieces.Add({*AssetIndex, Item->Transform.GetRelativeTransform(PivotToWorld), Item->IsInstance(), Subsystem->GetItemCustomData(*Item)});
 	}
-	switch(ChangeMode)
+	RegionBuffer.Pieces.Shrink();
+	return RegionBuffer.Pieces.Num();
+}
+
+FTransform UPlacementTool::GetPasteTransform() const
+{
+	//Only quarter turns keep the cells on the grid
+	const int32 QuarterTurns = FMath::RoundToInt32(Properties->CurrentPlacementRotation.Yaw / 90.0f) & 3;
+	const FQuat Rotation = Properties->GridRotation.Quaternion() * FQuat(FVector::UpVector, FMath::DegreesToRadians(90.0f * QuarterTurns));
+	return FTransform(Rotation, GridToWorldSpace(CurrentGridCell) + GetHeightOffsetVector());
+}
+
+void UPlacementTool::UpdatePastePreview()
+{
+	if(Properties->ToolMode != EPlacementToolMode::Paste || RegionBuffer.IsEmpty())
 	{
-		case IncreaseMajor: CurrentRotationOnAxis += Properties->PlacementRotationMajorIncrement; break;
-		case DecreaseMajor: CurrentRotationOnAxis -= Properties->PlacementRotationMajorIncrement; break;
-		case IncreaseMinor: CurrentRotationOnAxis += Properties->PlacementRotationMinorIncrement; break;
-		case DecreaseMinor: CurrentRotationOnAxis -= Properties->PlacementRotationMinorIncrement; break;
+		DestroyPastePreview();
+		return;
 	}
-	if(CurrentRotationOnAxis >= 360.0f)
-		CurrentRotationOnAxis -= 360.0f;
-	else if(CurrentRotationOnAxis < 0.0f)
-		CurrentRotationOnAxis += 360.0f;
-	switch(Properties->CurrentRotationAxis)
+	if(!PastePreviewActor)
 	{
-		case ERotationAxis::X: Properties->CurrentPlacementRotation.Roll = CurrentRotationOnAxis; break;
-		case ERotationAxis::Y: Properties->CurrentPlacementRotation.Pitch = CurrentRotationOnAxis; break;
-		case ERotationAxis::Z: Properties->CurrentPlacementRotation.Yaw = CurrentRotationOnAxis; break;
+		LLM_SCOPE_BYTAG(GridPlacer);
+		PastePreviewActor = SpawnPreviewHost(FName("GridPlacerPastePreview"));
+		TArray<TArray<FTransform>> AssetTransforms;
+		AssetTransforms.SetNum(RegionBuffer.Assets.Num());
+		for(const FGridPlacerRegionPiece& Piece : RegionBuffer.Pieces)
+			AssetTransforms[Piece.AssetIndex].Add(Piece.GridTransform);
+		for(int32 AssetIndex = 0; AssetIndex < RegionBuffer.Assets.Num(); ++AssetIndex)
+			if(UStaticMesh* StaticMesh = Cast<UStaticMesh>(RegionBuffer.Assets[AssetIndex]))
+				AddPreviewComponent(PastePreviewActor, StaticMesh)->AddInstances(AssetTransforms[AssetIndex], false);
 	}
+	PastePreviewActor->SetActorTransform(GetPasteTransform());
 }
 
-void UPlacementTool::RandomizeRotation()
+void UPlacementTool::DestroyPastePreview()
 {
-	float RandomRotation = 0.0f;
-	if(FMath::Abs(Properties->RotationRandomizationDivisions) > 0)
+	if(PastePreviewActor)
 	{
-		RandomRotation = Properties->RandomRotationRange.Min + (Properties->RandomRotationRange.Size() / Properties->RotationRandomizationDivisions) * FMath::RandRange(0, FMath::Abs(Properties->RotationRandomizationDivisions) - 1);
+		TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+		TargetWorld->DestroyActor(PastePreviewActor);
+		PastePreviewActor = nullptr;
 	}
-	else
-		RandomRotation = FMath::RandRange(Properties->RandomRotationRange.Min, Properties->RandomRotationRange.Max);
-	switch(Properties->CurrentRotationAxis)
+}
+
+EBulkPlacementResult UPlacementTool::PasteRegion()
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || RegionBuffer.IsEmpty())
+		return EBulkPlacementResult::None;
+	const FTransform PasteTransform = GetPasteTransform();
+	TArray<FGridPlacerSpawnRequest> Requests;
+	Requests.Reserve(RegionBuffer.Pieces.Num());
+	for(const FGridPlacerRegionPiece& Piece : RegionBuffer.Pieces)
 	{
-		case ERotationAxis::X: Properties->CurrentPlacementRotation.Roll = RandomRotation; break;
-		case ERotationAxis::Y: Properties->CurrentPlacementRotation.Pitch = RandomRotation; break;
-		case ERotationAxis::Z: Properties->CurrentPlacementRotation.Yaw = RandomRotation; break;
+		FGridPlacerSpawnRequest& Request = Requests.AddDefaulted_GetRef();
+		Request.Asset = RegionBuffer.Assets[Piece.AssetIndex];
+		Request.Transform = Piece.GridTransform * PasteTransform;
+		Request.AsInstance = Piece.AsInstance;
+		Request.CustomData = Piece.CustomData;
 	}
+	RemoveBlockedRequests(Requests);
+	return PlaceBulk(MoveTemp(Requests), LOCTEXT("PasteRegion", "Paste Region"));
 }
 
-void UPlacementTool::RandomizeScale()
+void UPlacementTool::CollectBrushItems(TArray<uint32>& OutIds)
 {
-	Properties->CurrentPlacementScale = FMath::RandRange(Properties->RandomScaleRange.Min, Properties->RandomScaleRange.Max);
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return;
+	const FGridPlacerFrame Frame = GetGridFrame();
+	const FGridPlacerCellBox BrushCells = GetBrushCells();
+
+	//Only items close to the brush are looked at, no matter how much has been placed in the level
+	TArray<uint32> Candidates;
+	Subsystem->QueryItems(Frame.GetCellBounds(BrushCells).TransformBy(Frame.GridToWorld), Candidates);
+	for(const uint32 Id : Candidates)
+	{
+		const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+		if(!Item || !Item->IsValid())
+			continue;
+		if(Frame.GetFootprint(Subsystem->GetAssetBounds(Item->Asset.Get()), Item->Transform).Intersects(BrushCells))
+			OutIds.Add(Id);
+	}
 }
 
-void UPlacementTool::OnActivePaletteChanged()
+bool UPlacementTool::EraseBrush()
 {
-	UPaletteObject* NextChosenObject = PickNextObjectFromPalette();
-	if(NextChosenObject)
-		SpawnPreviewActor(NextChosenObject);
-	else
-		DestroyPreviewActor();
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return false;
+	EnsureOccupancy();
+
+	TArray<uint32> Removals;
+	CollectBrushItems(Removals);
+	TArray<TPair<FIntVector, UGridPlacerAutotileSet*>> ErasedAutotileCells;
+	for(const uint32 Id : Removals)
+	{
+		const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+		const FIntVector Cell = GetAutotileCell(Item->Transform.GetLocation());
+		const FAutotileCell* AutotileCell = AutotileCells.Find(Cell);
+		if(AutotileCell && AutotileCell->ItemId == Id)
+		{
+			ErasedAutotileCells.Emplace(Cell, AutotileCell->Set);
+			AutotileCells.Remove(Cell);
+		}
+	}
+	if(Removals.Num() == 0)
+		return false;
+
+	//Autotiles next to erased ones lost a connection, swap them out in the same batch
+	TArray<FGridPlacerSpawnRequest> Requests;
+	for(const TPair<FIntVector, UGridPlacerAutotileSet*>& Erased : ErasedAutotileCells)
+		CollectAutotileNeighborUpdates(Erased.Key, Erased.Value, Requests, Removals);
+
+	const FText Description = LOCTEXT("EraseObjects", "Erase Objects");
+	if(GEditor) GEditor->BeginTransaction(Description);
+	Subsystem->RemoveBatch(Removals, Description);
+	Subsystem->PlaceBatch(Requests, Description);
+	if(GEditor) GEditor->EndTransaction();
+	return true;
 }
 
-UPaletteObject* UPlacementTool::PickNextObjectFromPalette()
+bool UPlacementTool::ReplaceBrush()
 {
-	auto ActivePaletteObjects = Properties->ObjectPalette.GetActivePaletteObjects();
-	if(ActivePaletteObjects.Num() == 0)
-		return nullptr;
-	switch(Properties->PalettePickingMode)
+	TArray<uint32> BrushIds;
+	CollectBrushItems(BrushIds);
+	//Dragging over the same objects again shouldn't keep rerolling them
+	TArray<uint32> Ids;
+	for(const uint32 Id : BrushIds)
 	{
-	case EPalettePickingMode::Random: return ActivePaletteObjects[FMath::RandRange(0, ActivePaletteObjects.Num() - 1)];
-	case EPalettePickingMode::Cycle:
-		//Make sure the index is in bounds
-		CurrentPaletteCyclingIndex %= ActivePaletteObjects.Num();
-		UPaletteObject* ChosenObject = ActivePaletteObjects[CurrentPaletteCyclingIndex++];
-		//Make sure the incremented index is still in bounds
-		CurrentPaletteCyclingIndex %= ActivePaletteObjects.Num();
-		return ChosenObject;
+		bool AlreadyReplaced = false;
+		StrokeReplacedIds.Add(Id, &AlreadyReplaced);
+		if(!AlreadyReplaced)
+			Ids.Add(Id);
 	}
-	return nullptr;
+	int32 NumSkippedStamps = 0;
+	const bool Replaced = ReplaceItems(Ids, NumSkippedStamps) > 0;
+	if(NumSkippedStamps > 0)
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("ReplaceSkippedStamps", "{0} stamps in the active pool were skipped, stamps can't replace single objects"), NumSkippedStamps), EToolMessageLevel::UserWarning);
+	return Replaced;
 }
 
-void UPlacementTool::UpdateGridSpace(const FRay& WorldRay)
+int32 UPlacementTool::ReplaceItems(TArrayView<const uint32> Ids, int32& OutNumSkippedStamps)
 {
-	FVector TraceStart;
-	FVector TraceEnd;
-	FCollisionQueryParams QueryParams;
-	FHitResult Hit;
-	
-	switch(Properties->GridSpaceMode)
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	TArray<UPaletteObject*> ActivePaletteObjects = Properties->ObjectPalette.GetActivePaletteObjects();
+	OutNumSkippedStamps = ActivePaletteObjects.RemoveAll([](const UPaletteObject* PaletteObject) { return PaletteObject->ObjectType == EPaletteObjectType::Stamp; });
+	if(!Subsystem || ActivePaletteObjects.Num() == 0)
+		return 0;
+
+	TArray<FGridPlacerReplaceRequest> Requests;
+	Requests.Reserve(Ids.Num());
+	for(const uint32 Id : Ids)
 	{
-	case EGridSpaceMode::Global:
-		break;
-	case EGridSpaceMode::Local:
-		TraceStart = WorldRay.Origin;
-		TraceEnd = TraceStart + WorldRay.Direction * 100000;
-		if(PreviewActor)
-			QueryParams.AddIgnoredActor(PreviewActor);
-		if(TargetWorld->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, Properties->LocalGridCollisionChannel, QueryParams)){
-			if(AActor* LocalTarget = Hit.GetActor())
-			{
-				//Origin
-				Properties->GridOrigin = FVector::PointPlaneProject(LocalTarget->GetActorLocation(), Hit.ImpactPoint, Hit.ImpactNormal);
-				//Rotation
-				FVector HitTangent;
-				if(FVector::DotProduct(Hit.ImpactNormal, FVector::UpVector) > 0.9f)
-					HitTangent = FVector::CrossProduct(Hit.ImpactNormal, FVector::RightVector);
-				else
-					HitTangent = FVector::CrossProduct(Hit.ImpactNormal, FVector::UpVector);
-				Hit.ImpactNormal = LocalTarget->GetActorRotation().Quaternion().Inverse() * Hit.ImpactNormal;
-				HitTangent = LocalTarget->GetActorRotation().Quaternion().Inverse() * HitTangent;
-				Properties->GridRotation = UKismetMathLibrary::MakeRotFromXZ(HitTangent, Hit.ImpactNormal);
-				Properties->GridRotation += LocalTarget->GetActorRotation();
-			}
-		}
-		break;
-	case EGridSpaceMode::Custom:
-		if(Properties->CustomGridSpaceTarget)
-		{
-			Properties->GridOrigin = Properties->CustomGridSpaceTarget->GetActorLocation();
-			Properties->GridRotation = Properties->CustomGridSpaceTarget->GetActorRotation();
-		}
-		break;
+		const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+		if(!Item || (Properties->ReplaceOnlyMesh && Item->Asset.Get() != Properties->ReplaceOnlyMesh))
+			continue;
+		if(UObject* Asset = PickNextObjectFromPalette(ActivePaletteObjects)->GetPlacedAsset())
+			Requests.Add({Id, Asset});
 	}
+	return Subsystem->ReplaceBatch(Requests, LOCTEXT("ReplaceObjects", "Replace Objects"));
 }
 
-FVector UPlacementTool::WorldToGridSpace(FVector WorldSpace) const
+FBox2D UPlacementTool::GetScatterRegion() const
 {
-	WorldSpace -= Properties->GridOrigin;
-	WorldSpace = Properties->GridRotation.Quaternion().Inverse() * WorldSpace;
-	return WorldSpace;
+	const FVector2D HalfSize = FVector2D(Properties->GridSize) * FMath::Max(Properties->BrushSize, 1) * 0.5;
+	const FVector2D Center(RawPlacementPoint.X, RawPlacementPoint.Y);
+	return FBox2D(Center - HalfSize, Center + HalfSize);
 }
 
-FVector UPlacementTool::WorldToGridSpaceDirection(FVector WorldSpaceDirection) const
+float UPlacementTool::GetScatterSpacing(UObject* Asset, const UPaletteObject* PaletteObject)
 {
-	WorldSpaceDirection = Properties->GridRotation.Quaternion().Inverse() * WorldSpaceDirection;
-	return WorldSpaceDirection;
+	if(PaletteObject && PaletteObject->ScatterSpacing > 0.0f)
+		return PaletteObject->ScatterSpacing;
+	//Without an explicit spacing objects may just not overlap
+	const FBox Bounds = GetSubsystem()->GetAssetBounds(Asset);
+	const float Extent = Bounds.IsValid ? FMath::Max(Bounds.GetSize().X, Bounds.GetSize().Y) : 0.0f;
+	return Extent > UE_KINDA_SMALL_NUMBER ? Extent : FMath::Min(Properties->GridSize.X, Properties->GridSize.Y);
 }
 
-FVector UPlacementTool::GridToWorldSpace(FVector GridSpace) const
+EBulkPlacementResult UPlacementTool::ScatterBrush()
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return EBulkPlacementResult::None;
+	const TArray<UPaletteObject*> ScatterObjects = GetBulkPaletteObjects();
+	if(ScatterObjects.Num() == 0)
+		return EBulkPlacementResult::None;
+
+	TArray<float> Spacings;
+	TMap<UObject*, float> AssetSpacings;
+	for(const UPaletteObject* PaletteObject : ScatterObjects)
+	{
+		UObject* Asset = PaletteObject->GetPlacedAsset();
+		Spacings.Add(GetScatterSpacing(Asset, PaletteObject));
+		AssetSpacings.Add(Asset, Spacings.Last());
+	}
+	if(!ScatterSamplerValid)
+	{
+		ScatterSampler.Reset(FMath::Min(Spacings));
+		ScatterKnownIds.Reset();
+		ScatterSamplerValid = true;
+	}
+
+	//Everything already placed around the brush keeps its distance too, only looked at once per stroke
+	const FBox2D Region = GetScatterRegion();
+	const double Reach = 2.0 * FMath::Max(Spacings);
+	const FBox GridReach(FVector(Region.Min - FVector2D(Reach), -UE_BIG_NUMBER), FVector(Region.Max + FVector2D(Reach), UE_BIG_NUMBER));
+	TArray<uint32> Nearby;
+	Subsystem->QueryItems(GridReach.TransformBy(GetGridFrame().GridToWorld), Nearby);
+	for(const uint32 Id : Nearby)
+	{
+		bool AlreadyKnown = false;
+		ScatterKnownIds.Add(Id, &AlreadyKnown);
+		const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+		if(AlreadyKnown || !Item)
+			continue;
+		UObject* Asset = Item->Asset.Get();
+		const float* Spacing = AssetSpacings.Find(Asset);
+		const FVector GridLocation = WorldToGridSpace(Item->Transform.GetLocation());
+		ScatterSampler.AddExisting(FVector2D(GridLocation.X, GridLocation.Y), Spacing ? *Spacing : GetScatterSpacing(Asset, nullptr));
+	}
+
+	TArray<FGridPlacerPoissonSampler::FSample> Samples;
+	FRandomStream Stream(FMath::Rand());
+	ScatterSampler.Fill(Region, Properties->ScatterAttempts, Stream, [this, &ScatterObjects, &Spacings](int32& OutTag)
+	{
+		OutTag = ScatterObjects.IndexOfByKey(PickNextObjectFromPalette(ScatterObjects));
+		return static_cast<double>(Spacings[OutTag]);
+	}, Samples);
+	if(Samples.Num() == 0)
+		return EBulkPlacementResult::None;
+
+	TArray<FGridPlacerSpawnRequest> Requests;
+	Requests.Reserve(Samples.Num());
+	for(const FGridPlacerPoissonSampler::FSample& Sample : Samples)
+	{
+		const UPaletteObject* PaletteObject = ScatterObjects[Sample.Tag];
+		FGridPlacerSpawnRequest& Request = Requests.AddDefaulted_GetRef();
+		Request.Asset = PaletteObject->GetPlacedAsset();
+		Request.AsInstance = Properties->PlaceAsInstances && PaletteObject->ObjectType == EPaletteObjectType::StaticMesh;
+		FRotator Rotation;
+		float HeightOffset;
+		float Scale;
+		GetPlacementParameters(Stream, Rotation, HeightOffset, Scale);
+		Request.Transform = GetPlacementTransform(FVector(Sample.Position, 0.0), Rotation, HeightOffset, Scale);
+		Request.CustomData = GetPlacementVariation(PaletteObject, Stream);
+	}
+	ProjectToSurface(Requests);
+	StackRequests(Requests);
+	//Queued objects are already in the sampler, finding them again later only adds a point on top of their sample
+	TArray<uint32> NewIds;
+	const EBulkPlacementResult Result = PlaceBulk(MoveTemp(Requests), LOCTEXT("ScatterObjects", "Scatter Objects"), &NewIds);
+	ScatterKnownIds.Append(NewIds);
+	return Result;
+}
+
+TArray<UPaletteObject*> UPlacementTool::GetBulkPaletteObjects()
 {
-	GridSpace = Properties->GridRotation.Quaternion() * GridSpace;
-	GridSpace += Properties->GridOrigin;
-	return GridSpace;
+	//Autotiles depend on their neighbors on the grid, they can't be placed in bulk
+	TArray<UPaletteObject*> BulkObjects = Properties->ObjectPalette.GetActivePaletteObjects();
+	BulkObjects.RemoveAll([](const UPaletteObject* PaletteObject) { return PaletteObject->ObjectType == EPaletteObjectType::Autotile || !PaletteObject->GetPlacedAsset(); });
+	return BulkObjects;
 }
 
-FVector UPlacementTool::GridToWorldSpaceDirection(FVector GridSpaceDirection) const
+UPaletteObject* UPlacementTool::PickPathObject(const TArray<UPaletteObject*>& PathObjects, int32 PieceIndex, FRandomStream& Stream) const
 {
-	GridSpaceDirection = Properties->GridRotation.Quaternion() * GridSpaceDirection;
-	return GridSpaceDirection;
+	if(Properties->PalettePickingMode == EPalettePickingMode::Cycle)
+		return PathObjects[(CurrentPaletteCyclingIndex + PieceIndex) % PathObjects.Num()];
+	return PathObjects[Stream.RandHelper(PathObjects.Num())];
 }
 
-void UPlacementTool::UpdatePlacementPoint(const FRay& WorldRay)
+FGridPlacerSpawnRequest UPlacementTool::MakePathRequest(const UPaletteObject* PaletteObject, const FTransform& Transform) const
 {
-	//Find Ray-Grid-Intersection
-	FRay GridSpaceRay;
-	GridSpaceRay.Origin = WorldToGridSpace(WorldRay.Origin);
-	GridSpaceRay.Direction = WorldToGridSpaceDirection(WorldRay.Direction);
-	if(GridSpaceRay.Direction.Z == 0.0f)
+	FGridPlacerSpawnRequest Request;
+	Request.Asset = PaletteObject->GetPlacedAsset();
+	Request.Transform = Transform;
+	Request.AsInstance = Properties->PlaceAsInstances && PaletteObject->ObjectType == EPaletteObjectType::StaticMesh;
+	return Request;
+}
+
+/*Upper bound for a single line or spline, a stray click across the level shouldn't place millions of objects*/
+static constexpr int32 MaxPathPieces = 4096;
+
+void UPlacementTool::BuildLinePath(const FVector& Start, const FVector& End, TArray<FGridPlacerSpawnRequest>& OutRequests)
+{
+	const TArray<UPaletteObject*> PathObjects = GetBulkPaletteObjects();
+	if(PathObjects.Num() == 0)
 		return;
-	FVector RayGridIntersection = GridSpaceRay.Origin - GridSpaceRay.Direction * (GridSpaceRay.Origin.Z / GridSpaceRay.Direction.Z);
-	RawPlacementPoint = RayGridIntersection;
-	//Snap RawPlacementPoint to grid
-	SnapPlacementPointToGrid();
-	CurrentGridCell = RawPlacementPoint;
-	CurrentGridCell.X = FMath::Floor(CurrentGridCell.X / Properties->GridSize.X) * Properties->GridSize.X;
-	CurrentGridCell.Y = FMath::Floor(CurrentGridCell.Y / Properties->GridSize.Y) * Properties->GridSize.Y;
+	const FVector2D CellSize = Properties->GridSize;
+	//Start and end are snapped the same way, so the line runs on the lattice through Start
+	int32 DeltaX = FMath::RoundToInt32((End.X - Start.X) / CellSize.X);
+	int32 DeltaY = FMath::RoundToInt32((End.Y - Start.Y) / CellSize.Y);
+	const int32 Steps = FMath::Max(FMath::Abs(DeltaX), FMath::Abs(DeltaY));
+	if(Steps >= MaxPathPieces)
+	{
+		DeltaX = static_cast<int32>(static_cast<int64>(DeltaX) * (MaxPathPieces - 1) / Steps);
+		DeltaY = static_cast<int32>(static_cast<int64>(DeltaY) * (MaxPathPieces - 1) / Steps);
+	}
+	const FQuat Along = Properties->OrientAlongPath && Steps > 0
+		? FQuat(FVector::UpVector, FMath::Atan2(DeltaY * CellSize.Y, DeltaX * CellSize.X))
+		: FQuat::Identity;
+
+	FRandomStream Stream(PathSeed);
+	OutRequests.Reserve(OutRequests.Num() + FMath::Min(Steps, MaxPathPieces - 1) + 1);
+	GridPlacerMath::ForEachLineCell(0, 0, DeltaX, DeltaY, [&](int32 X, int32 Y)
+	{
+		const UPaletteObject* PaletteObject = PickPathObject(PathObjects, OutRequests.Num(), Stream);
+		FRotator Rotation;
+		float HeightOffset;
+		float Scale;
+		GetPlacementParameters(Stream, Rotation, HeightOffset, Scale);
+		const FVector GridPoint = Start + FVector(X * CellSize.X, Y * CellSize.Y, 0.0);
+		FGridPlacerSpawnRequest& Request = OutRequests.Add_GetRef(MakePathRequest(PaletteObject, GetPlacementTransform(GridPoint, (Along * Rotation.Quaternion()).Rotator(), HeightOffset, Scale)));
+		Request.CustomData = GetPlacementVariation(PaletteObject, Stream);
+	});
 }
 
-void UPlacementTool::SnapPlacementPointToGrid()
+void UPlacementTool::BuildSplinePath(const USplineComponent* Spline, TArray<FGridPlacerSpawnRequest>& OutRequests)
 {
-	SnappedPlacementPoint = RawPlacementPoint;
-	FVector CellCenter = SnappedPlacementPoint;
-	TArray<FVector> EdgePositions;
-	int ClosestEdgeIdx = 0;
-	float ClosestEdgeDistance = Properties->GridSize.X + Properties->GridSize.Y;
-	switch(Properties->SnappingMode)
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	const TArray<UPaletteObject*> PathObjects = GetBulkPaletteObjects();
+	if(!Subsystem || PathObjects.Num() == 0)
+		return;
+
+	FRandomStream Stream(PathSeed);
+	const double SplineLength = Spline->GetSplineLength();
+	double Distance = 0.0;
+	while(OutRequests.Num() < MaxPathPieces)
 	{
-		case ESnappingMode::Center:
-			SnappedPlacementPoint.X = (FMath::RoundToFloat(SnappedPlacementPoint.X / Properties->GridSize.X + 0.5f) - 0.5f) * Properties->GridSize.X;
-			SnappedPlacementPoint.Y = (FMath::RoundToFloat(SnappedPlacementPoint.Y / Properties->GridSize.Y + 0.5f) - 0.5f) * Properties->GridSize.Y;
-			break;
-		case ESnappingMode::Edges:
-			CellCenter.X = (FMath::RoundToFloat(SnappedPlacementPoint.X / Properties->GridSize.X + 0.5f) - 0.5f) * Properties->GridSize.X;
-			CellCenter.Y = (FMath::RoundToFloat(SnappedPlacementPoint.Y / Properties->GridSize.Y + 0.5f) - 0.5f) * Properties->GridSize.Y;
-			EdgePositions.Add(CellCenter + FVector::ForwardVector * Properties->GridSize.X * 0.5f);
-			EdgePositions.Add(CellCenter - FVector::ForwardVector * Properties->GridSize.X * 0.5f);
-			EdgePositions.Add(CellCenter + FVector::RightVector * Properties->GridSize.Y * 0.5f);
-			EdgePositions.Add(CellCenter - FVector::RightVector * Properties->GridSize.Y * 0.5f);
-			for (int i = 0; i < 4; ++i)
-			{
-				float CurrentEdgeDistance = FVector::Dist(RawPlacementPoint, EdgePositions[i]);
-				if(CurrentEdgeDistance < ClosestEdgeDistance)
-				{
-					ClosestEdgeDistance = CurrentEdgeDistance;
-					ClosestEdgeIdx = i;
-				}
-			}
-			SnappedPlacementPoint = EdgePositions[ClosestEdgeIdx];
-			break;
-		case ESnappingMode::Corners:
-			SnappedPlacementPoint.X = FMath::RoundToFloat(SnappedPlacementPoint.X / Properties->GridSize.X) * Properties->GridSize.X;
-			SnappedPlacementPoint.Y = FMath::RoundToFloat(SnappedPlacementPoint.Y / Properties->GridSize.Y) * Properties->GridSize.Y;
+		const UPaletteObject* PaletteObject = PickPathObject(PathObjects, OutRequests.Num(), Stream);
+		FRotator Rotation;
+		float HeightOffset;
+		float Scale;
+		GetPlacementParameters(Stream, Rotation, HeightOffset, Scale);
+		//Pieces are laid out by their bounds, so it doesn't matter where their pivot is
+		const FBox Bounds = Subsystem->GetAssetBounds(PaletteObject->GetPlacedAsset());
+		const bool HasLength = Bounds.IsValid && Bounds.GetSize().X > UE_KINDA_SMALL_NUMBER;
+		const double Length = (HasLength ? Bounds.GetSize().X : Properties->GridSize.X) * Scale;
+		const double PivotOffset = HasLength ? -Bounds.Min.X * Scale : Length * 0.5;
+		if(Length < 1.0 || Distance + Length > SplineLength + UE_KINDA_SMALL_NUMBER)
 			break;
-		case ESnappingMode::None: break;
+
+		const double PivotDistance = Distance + PivotOffset;
+		FTransform Transform = GetPlacementTransform(FVector::ZeroVector, Rotation, HeightOffset, Scale);
+		if(Properties->OrientAlongPath)
+			Transform.SetRotation(Spline->GetQuaternionAtDistanceAlongSpline(PivotDistance, ESplineCoordinateSpace::World) * Rotation.Quaternion());
+		Transform.SetLocation(Spline->GetLocationAtDistanceAlongSpline(PivotDistance, ESplineCoordinateSpace::World) + GetHeightOffsetVector(HeightOffset));
+		FGridPlacerSpawnRequest& Request = OutRequests.Add_GetRef(MakePathRequest(PaletteObject, Transform));
+		Request.CustomData = GetPlacementVariation(PaletteObject, Stream);
+		Distance += Length;
 	}
 }
 
-FVector UPlacementTool::GetHeightOffsetVector()
+USplineComponent* UPlacementTool::GetPathSpline() const
+{
+	return Properties->SplineActor ? Properties->SplineActor->FindComponentByClass<USplineComponent>() : nullptr;
+}
+
+void UPlacementTool::UpdatePathPreview()
 {
-	switch(Properties->CurrentHeightOffsetSpace)
+	const bool IsLine = Properties->ToolMode == EPlacementToolMode::Line;
+	if(!IsLine && Properties->ToolMode != EPlacementToolMode::Spline)
 	{
-	case EGridSpaceMode::Global: return FVector::UpVector * Properties->CurrentPlacementHeightOffset;
-	case EGridSpaceMode::Local: return GridToWorldSpaceDirection(FVector::UpVector * Properties->CurrentPlacementHeightOffset);
-	case EGridSpaceMode::Custom:
-		if(Properties->CustomHeightOffsetSpaceTarget)
-			return Properties->CustomHeightOffsetSpaceTarget->GetActorUpVector() * Properties->CurrentPlacementHeightOffset;
-		return FVector::UpVector * Properties->CurrentPlacementHeightOffset;
-	default: return GridToWorldSpaceDirection(FVector::UpVector * Properties->CurrentPlacementHeightOffset);
+		HasLineStart = false;
+		DestroyPathPreview();
+		return;
+	}
+	//Splines only change with the settings, lines also with the hovered point
+	if(!PathPreviewDirty && (!IsLine || PathPreviewEnd.Equals(SnappedPlacementPoint)))
+		return;
+	GRIDPLACER_SCOPE(PathPreview);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	PathPreviewDirty = false;
+	PathPreviewEnd = SnappedPlacementPoint;
+
+	PathRequests.Reset();
+	if(IsLine)
+		BuildLinePath(HasLineStart ? LineStart : SnappedPlacementPoint, SnappedPlacementPoint, PathRequests);
+	else if(const USplineComponent* Spline = GetPathSpline())
+		BuildSplinePath(Spline, PathRequests);
+	ProjectToSurface(PathRequests);
+	StackRequests(PathRequests);
+
+	TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+	if(!PathPreviewActor)
+		PathPreviewActor = SpawnPreviewHost(FName("GridPlacerPathPreview"));
+
+	//The whole run is a handful of instanced draws no matter how long it is
+	TMap<UStaticMesh*, TArray<FTransform>> MeshTransforms;
+	for(const FGridPlacerSpawnRequest& Request : PathRequests)
+		if(UStaticMesh* Mesh = Cast<UStaticMesh>(Request.Asset))
+			MeshTransforms.FindOrAdd(Mesh).Add(Request.Transform);
+	for(const TPair<UStaticMesh*, UInstancedStaticMeshComponent*>& Pair : PathPreviewComponents)
+		if(!MeshTransforms.Contains(Pair.Key))
+			Pair.Value->ClearInstances();
+	for(const TPair<UStaticMesh*, TArray<FTransform>>& Pair : MeshTransforms)
+	{
+		UInstancedStaticMeshComponent*& Component = PathPreviewComponents.FindOrAdd(Pair.Key);
+		if(!Component)
+			Component = AddPreviewComponent(PathPreviewActor, Pair.Key);
+		Component->ClearInstances();
+		Component->AddInstances(Pair.Value, false, true);
 	}
 }
 
-void UPlacementTool::OnBeginSequencePreview(const FInputDeviceRay& ClickPos)
+void UPlacementTool::DestroyPathPreview()
 {
-	UpdateGridSpace(ClickPos.WorldRay);
-	UpdatePlacementPoint(ClickPos.WorldRay);
-	if(PreviewActor){
-		//Set Location
-		PreviewActor->SetActorLocation(GridToWorldSpace(SnappedPlacementPoint) + GetHeightOffsetVector());
-		//Set Rotation
-		switch(Properties->CurrentRotationSpace)
+	PathRequests.Reset();
+	PathPreviewComponents.Reset();
+	PathPreviewDirty = true;
+	if(PathPreviewActor)
+	{
+		TGuardValue<ITransaction*> SuppressTransaction(GUndo, nullptr);
+		TargetWorld->DestroyActor(PathPreviewActor);
+		PathPreviewActor = nullptr;
+	}
+}
+
+void UPlacementTool::RemoveBlockedRequests(TArray<FGridPlacerSpawnRequest>& Requests)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Properties->PreventOverlaps || !Subsystem)
+		return;
+	EnsureOccupancy();
+	const FGridPlacerFrame Frame = GetGridFrame();
+	Requests.RemoveAll([this, Subsystem, &Frame](const FGridPlacerSpawnRequest& Request)
+	{
+		return Occupancy.Overlaps(Frame.GetFootprint(Subsystem->GetAssetBounds(Request.Asset), Request.Transform));
+	});
+}
+
+EBulkPlacementResult UPlacementTool::PlacePath(const FText& Description)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	UpdatePathPreview();
+	if(!Subsystem || PathRequests.Num() == 0)
+		return EBulkPlacementResult::None;
+
+	//Everything is generated up front, pieces landing on occupied cells are dropped from the batch
+	TArray<FGridPlacerSpawnRequest> Requests = PathRequests;
+	RemoveBlockedRequests(Requests);
+	const EBulkPlacementResult Result = PlaceBulk(MoveTemp(Requests), Description);
+
+	//The next path continues the cycle and gets fresh random picks
+	if(const int32 NumPathObjects = GetBulkPaletteObjects().Num())
+		CurrentPaletteCyclingIndex = (CurrentPaletteCyclingIndex + PathRequests.Num()) % NumPathObjects;
+	PathSeed = FMath::Rand();
+	PathPreviewDirty = true;
+	return Result;
+}
+
+void UPlacementTool::PlaceAlongSpline()
+{
+	if(!GetPathSpline())
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("NoSpline", "Pick an actor with a spline component as SplineActor"), EToolMessageLevel::UserWarning);
+		return;
+	}
+	//The spline might have been edited since the preview was built
+	PathPreviewDirty = true;
+	UpdatePathPreview();
+	const int32 NumPieces = PathRequests.Num();
+	const EBulkPlacementResult Result = PlacePath(LOCTEXT("PlaceAlongSpline", "Place Along Spline"));
+	if(Result != EBulkPlacementResult::None)
+		GetToolManager()->DisplayMessage(FText::Format(Result == EBulkPlacementResult::Queued
+			? LOCTEXT("QueuedAlongSpline", "Placing {0} objects along {1} over the next frames")
+			: LOCTEXT("PlacedAlongSpline", "Placed {0} objects along {1}"),
+			NumPieces, FText::FromString(Properties->SplineActor->GetActorLabel())), EToolMessageLevel::UserNotification);
+	UpdatePathPreview();
+}
+
+void UPlacementTool::ProjectToSurface(TArray<FGridPlacerSpawnRequest>& Requests)
+{
+	if(!Properties->DropToSurface || Requests.Num() == 0 || !TargetWorld)
+		return;
+	GRIDPLACER_SCOPE(ProjectToSurface);
+
+	const FVector Up = Properties->GridRotation.Quaternion().GetUpVector();
+	const FVector GridOrigin = Properties->GridOrigin;
+	const double TraceDistance = Properties->SurfaceTraceDistance;
+	const double MinSlopeCos = FMath::Cos(FMath::DegreesToRadians(Properties->MaxSurfaceSlope));
+	const bool AlignToNormal = Properties->AlignToSurfaceNormal;
+	const ECollisionChannel Channel = Properties->SurfaceCollisionChannel;
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GridPlacerDropToSurface), false);
+	if(PreviewActor)
+		QueryParams.AddIgnoredActor(PreviewActor);
+
+	TArray<bool> Rejected;
+	Rejected.SetNumZeroed(Requests.Num());
+	//Traces only read the physics scene and nothing modifies it while the game thread waits here
+	ParallelFor(TEXT("GridPlacer.ProjectToSurface"), Requests.Num(), 64, [&](int32 Index)
+	{
+		FTransform& Transform = Requests[Index].Transform;
+		//Whatever the object was lifted off the grid plane, it is lifted off the surface instead
+		const double Height = FVector::DotProduct(Transform.GetLocation() - GridOrigin, Up);
+		const FVector PlanePoint = Transform.GetLocation() - Up * Height;
+		FHitResult Hit;
+		if(!TargetWorld->LineTraceSingleByChannel(Hit, PlanePoint + Up * TraceDistance, PlanePoint - Up * TraceDistance, Channel, QueryParams))
+			return;
+		if(FVector::DotProduct(Hit.ImpactNormal, Up) < MinSlopeCos)
 		{
-		case EGridSpaceMode::Global:
-			PreviewActor->SetActorRotation(Properties->CurrentPlacementRotation);
-			break;
-		case EGridSpaceMode::Local:
-			PreviewActor->SetActorRotation(Properties->GridRotation);
-			PreviewActor->AddActorLocalRotation(Properties->CurrentPlacementRotation);
-			break;
-		case EGridSpaceMode::Custom:
-			if(Properties->CustomRotationSpaceTarget)
+			Rejected[Index] = true;
+			return;
+		}
+		Transform.SetLocation(Hit.ImpactPoint + Up * Height);
+		if(AlignToNormal)
+			Transform.SetRotation(FQuat::FindBetweenNormals(Up, Hit.ImpactNormal) * Transform.GetRotation());
+	});
+	GridPlacerStats::RecordTrace(Requests.Num());
+
+	int32 NumKept = 0;
+	for(int32 Index = 0; Index < Requests.Num(); ++Index)
+		if(!Rejected[Index])
+			Requests[NumKept++] = Requests[Index];
+	Requests.SetNum(NumKept, false);
+}
+
+void UPlacementTool::ReplaceSelected()
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || !GEditor)
+		return;
+	TArray<uint32> Ids;
+	for(FSelectionIterator It(*GEditor->GetSelectedActors()); It; ++It)
+	{
+		AActor* Actor = Cast<AActor>(*It);
+		if(!Actor)
+			continue;
+		if(const uint32 Id = Subsystem->FindItemId(Actor))
+			Ids.Add(Id);
+		else if(Actor->Tags.Contains(UGridPlacerSubsystem::InstanceHostTag))
+			for(const TPair<uint32, FGridPlacerPlacedItem>& Pair : Subsystem->GetItems())
+				if(Pair.Value.IsInstance() && Pair.Value.Component.IsValid() && Pair.Value.Component->GetOwner() == Actor)
+					Ids.Add(Pair.Key);
+	}
+	int32 NumSkippedStamps = 0;
+	const int32 NumReplaced = ReplaceItems(Ids, NumSkippedStamps);
+	if(NumSkippedStamps > 0)
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("ReplacedSelectedSkippedStamps", "Replaced {0} objects, {1} stamps in the active pool were skipped since stamps can't replace single objects"), NumReplaced, NumSkippedStamps), EToolMessageLevel::UserWarning);
+	else
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("ReplacedSelected", "Replaced {0} objects"), NumReplaced), EToolMessageLevel::UserNotification);
+}
+
+void UPlacementTool::ReplaceAll()
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return;
+	TArray<uint32> Ids;
+	Subsystem->GetItems().GetKeys(Ids);
+	int32 NumSkippedStamps = 0;
+	const int32 NumReplaced = ReplaceItems(Ids, NumSkippedStamps);
+	if(NumSkippedStamps > 0)
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("ReplacedAllSkippedStamps", "Replaced {0} objects, {1} stamps in the active pool were skipped since stamps can't replace single objects"), NumReplaced, NumSkippedStamps), EToolMessageLevel::UserWarning);
+	else
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("ReplacedAll", "Replaced {0} objects"), NumReplaced), EToolMessageLevel::UserNotification);
+}
+
+void UPlacementTool::UpdateModePropertySets()
+{
+	SetToolPropertySourceEnabled(ReplaceActions, Properties->ToolMode == EPlacementToolMode::Replace);
+	SetToolPropertySourceEnabled(SplineActions, Properties->ToolMode == EPlacementToolMode::Spline);
+	//Stamps are placed like any other palette entry
+	SetToolPropertySourceEnabled(StampActions, Properties->ToolMode == EPlacementToolMode::Place);
+	SetToolPropertySourceEnabled(HiddenCellActions, Properties->HiddenCellMode != EHiddenCellMode::Off);
+	SetToolPropertySourceEnabled(BakeActions, Properties->Command == EPlacementToolCommand::Bake);
+	SetToolPropertySourceEnabled(ConsolidateActions, Properties->Command == EPlacementToolCommand::Consolidate);
+	SetToolPropertySourceEnabled(MergeActions, Properties->Command == EPlacementToolCommand::Merge);
+	SetToolPropertySourceEnabled(GenerateActions, Properties->Command == EPlacementToolCommand::Generate);
+	SetToolPropertySourceEnabled(ImportActions, Properties->Command == EPlacementToolCommand::Import);
+	SetToolPropertySourceEnabled(JournalActions, Properties->Command == EPlacementToolCommand::Journal);
+}
+
+void UPlacementTool::OnPropertyModified(UObject* PropertySet, FProperty* Property)
+{
+	UpdateModePropertySets();
+	if(Property && (Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, HiddenCellMode)
+		|| Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, HiddenCustomDataIndex)
+		|| Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, AutoStack)
+		|| Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, SnapToSockets)))
+		OccupancyValid = false;
+	//Grid changes move the hidden cells too
+	if(Properties->HiddenCellMode != EHiddenCellMode::Off || AppliedHiddenCellMode != EHiddenCellMode::Off)
+		EnsureOccupancy();
+	if(Property && VariationOverlapsHiddenCell() && (Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, ApplyVariation)
+		|| Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, VariationCustomDataIndex)
+		|| Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, HiddenCellMode)
+		|| Property->GetFName() == GET_MEMBER_NAME_CHECKED(UPlacementToolProperties, HiddenCustomDataIndex)))
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("VariationOverlapsHidden", "The variation floats {0} to {1} cover the hidden cell float {2}, the variation leaves it out"),
+			Properties->VariationCustomDataIndex, Properties->VariationCustomDataIndex + 4, Properties->HiddenCustomDataIndex), EToolMessageLevel::UserWarning);
+	//Nearly every setting changes what a line or spline would place
+	PathPreviewDirty = true;
+	UpdatePathPreview();
+	UpdateJournal();
+}
+
+void UPlacementTool::Shutdown(EToolShutdownType ShutdownType){
+	Super::Shutdown(ShutdownType);
+	
+	EndStroke();
+	DestroyPreviewActor();
+	DestroyPathPreview();
+	DestroyPastePreview();
+
+	if(UGridPlacerSubsystem* Subsystem = GetSubsystem())
+	{
+		Subsystem->OnItemAdded.Remove(ItemAddedHandle);
+		Subsystem->OnItemRemoved.Remove(ItemRemovedHandle);
+	}
+	//Queued imports read the tool's settings and occupancy, they stop with what they placed so far
+	HasShutDown = true;
+	OccupancyValid = false;
+
+	if(!UseSavedSettings)
+		return;
+	Properties->SaveProperties(this);
+	BakeActions->SaveProperties(this);
+	ConsolidateActions->SaveProperties(this);
+	MergeActions->SaveProperties(this);
+	GenerateActions->SaveProperties(this);
+	ImportActions->SaveProperties(this);
+	JournalActions->SaveProperties(this);
+}
+
+void UPlacementTool::ChangeHeightOffset(EPlacementParameterChangeMode ChangeMode)
+{
+	switch(ChangeMode)
+	{
+		case IncreaseMajor: Properties->CurrentPlacementHeightOffset += Properties->HeightOffsetMajorIncrement; break;
+		case DecreaseMajor: Properties->CurrentPlacementHeightOffset -= Properties->HeightOffsetMajorIncrement; break;
+		case IncreaseMinor: Properties->CurrentPlacementHeightOffset += Properties->HeightOffsetMinorIncrement; break;
+		case DecreaseMinor: Properties->CurrentPlacementHeightOffset -= Properties->HeightOffsetMinorIncrement; break;
+	}
+}
+
+void UPlacementTool::RandomizeHeightOffset()
+{
+	Properties->CurrentPlacementHeightOffset = GetRandomHeightOffset(FMath::FRand());
+}
+
+float UPlacementTool::GetRandomHeightOffset(float Random01) const
+{
+	//Both ends of the height offset range can be picked
+	return GridPlacerMath::GetRandomValue(Properties->RandomHeightOffsetRange.Min, Properties->RandomHeightOffsetRange.Max,
+		Properties->HeightOffsetRandomizationDivisions, true, Random01);
+}
+
+void UPlacementTool::ToggleEraseMode()
+{
+	Properties->ToolMode = Properties->ToolMode == EPlacementToolMode::Erase ? EPlacementToolMode::Place : EPlacementToolMode::Erase;
+	UpdateModePropertySets();
+}
+
+void UPlacementTool::CycleRotationAxis()
+{
+	Properties->CurrentRotationAxis = static_cast<ERotationAxis>((static_cast<uint8>(Properties->CurrentRotationAxis) + 1) % 3);
+}
+
+void UPlacementTool::ChangeRotationOffset(EPlacementParameterChangeMode ChangeMode)
+{
+	float CurrentRotationOnAxis = 0.0f;
+	switch(Properties->CurrentRotationAxis)
+	{
+		case ERotationAxis::X: CurrentRotationOnAxis = Properties->CurrentPlacementRotation.Roll; break;
+		case ERotationAxis::Y: CurrentRotationOnAxis = Properties->CurrentPlacementRotation.Pitch; break;
+		case ERotationAxis::Z: CurrentRotationOnAxis = Properties->CurrentPlacementRotation.Yaw; break;
+	}
+	switch(ChangeMode)
+	{
+		case IncreaseMajor: CurrentRotationOnAxis += Properties->PlacementRotationMajorIncrement; break;
+		case DecreaseMajor: CurrentRotationOnAxis -= Properties->PlacementRotationMajorIncrement; break;
+		case IncreaseMinor: CurrentRotationOnAxis += Properties->PlacementRotationMinorIncrement; break;
+		case DecreaseMinor: CurrentRotationOnAxis -= Properties->PlacementRotationMinorIncrement; break;
+	}
+	if(CurrentRotationOnAxis >= 360.0f)
+		CurrentRotationOnAxis -= 360.0f;
+	else if(CurrentRotationOnAxis < 0.0f)
+		CurrentRotationOnAxis += 360.0f;
+	switch(Properties->CurrentRotationAxis)
+	{
+		case ERotationAxis::X: Properties->CurrentPlacementRotation.Roll = CurrentRotationOnAxis; break;
+		case ERotationAxis::Y: Properties->CurrentPlacementRotation.Pitch = CurrentRotationOnAxis; break;
+		case ERotationAxis::Z: Properties->CurrentPlacementRotation.Yaw = CurrentRotationOnAxis; break;
+	}
+}
+
+void UPlacementTool::RandomizeRotation()
+{
+	Properties->CurrentPlacementRotation = GetRandomRotation(FMath::FRand());
+}
+
+FRotator UPlacementTool::GetRandomRotation(float Random01) const
+{
+	//The end of the rotation range usually is a full turn and would just repeat the start
+	const float RandomRotation = GridPlacerMath::GetRandomValue(Properties->RandomRotationRange.Min, Properties->RandomRotationRange.Max,
+		Properties->RotationRandomizationDivisions, false, Random01);
+	FRotator Rotation = Properties->CurrentPlacementRotation;
+	switch(Properties->CurrentRotationAxis)
+	{
+		case ERotationAxis::X: Rotation.Roll = RandomRotation; break;
+		case ERotationAxis::Y: Rotation.Pitch = RandomRotation; break;
+		case ERotationAxis::Z: Rotation.Yaw = RandomRotation; break;
+	}
+	return Rotation;
+}
+
+void UPlacementTool::RandomizeScale()
+{
+	Properties->CurrentPlacementScale = GetRandomScale(FMath::FRand());
+}
+
+float UPlacementTool::GetRandomScale(float Random01) const
+{
+	return FMath::Lerp(Properties->RandomScaleRange.Min, Properties->RandomScaleRange.Max, Random01);
+}
+
+void UPlacementTool::GetPlacementParameters(FRandomStream& Stream, FRotator& OutRotation, float& OutHeightOffset, float& OutScale) const
+{
+	//Always draw all three so toggling one randomization doesn't reroll the others
+	const float RotationRandom = Stream.GetFraction();
+	const float HeightOffsetRandom = Stream.GetFraction();
+	const float ScaleRandom = Stream.GetFraction();
+	OutRotation = Properties->RandomizeRotation ? GetRandomRotation(RotationRandom) : Properties->CurrentPlacementRotation;
+	OutHeightOffset = Properties->RandomizeHeightOffset ? GetRandomHeightOffset(HeightOffsetRandom) : Properties->CurrentPlacementHeightOffset;
+	OutScale = Properties->RandomizeScale ? GetRandomScale(ScaleRandom) : Properties->CurrentPlacementScale;
+}
+
+FLinearColor FGridPlacerVariation::GetRandomTint(float Random01) const
+{
+	const float Alpha = GridPlacerMath::GetRandomValue(0.0, 1.0, TintRandomizationDivisions, true, Random01);
+	return FMath::Lerp(RandomTintA, RandomTintB, Alpha);
+}
+
+float FGridPlacerVariation::GetRandomWear(float Random01) const
+{
+	return GridPlacerMath::GetRandomValue(RandomWearRange.Min, RandomWearRange.Max, WearRandomizationDivisions, true, Random01);
+}
+
+int32 FGridPlacerVariation::GetRandomAtlasIndex(float Random01) const
+{
+	//One division per index, so every index of the range is equally likely
+	const int32 Min = FMath::Min(RandomAtlasIndexRange.Min, RandomAtlasIndexRange.Max);
+	const int32 Max = FMath::Max(RandomAtlasIndexRange.Min, RandomAtlasIndexRange.Max);
+	return FMath::RoundToInt32(GridPlacerMath::GetRandomValue(Min, Max, Max - Min, true, Random01));
+}
+
+TArray<float> UPlacementTool::MakeVariationCustomData(const FLinearColor& Tint, float Wear, int32 AtlasIndex) const
+{
+	TArray<float> CustomData;
+	if(!Properties->ApplyVariation)
+		return CustomData;
+	const int32 FirstIndex = Properties->VariationCustomDataIndex;
+	CustomData.Init(std::numeric_limits<float>::quiet_NaN(), FirstIndex + 5);
+	CustomData[FirstIndex] = Tint.R;
+	CustomData[FirstIndex + 1] = Tint.G;
+	CustomData[FirstIndex + 2] = Tint.B;
+	CustomData[FirstIndex + 3] = Wear;
+	CustomData[FirstIndex + 4] = static_cast<float>(AtlasIndex);
+	//The hidden cell flag wins, OnPropertyModified warns about the overlap
+	if(VariationOverlapsHiddenCell())
+		CustomData[Properties->HiddenCustomDataIndex] = std::numeric_limits<float>::quiet_NaN();
+	return CustomData;
+}
+
+bool UPlacementTool::VariationOverlapsHiddenCell() const
+{
+	return Properties->ApplyVariation && Properties->HiddenCellMode == EHiddenCellMode::Hide
+		&& Properties->HiddenCustomDataIndex >= Properties->VariationCustomDataIndex && Properties->HiddenCustomDataIndex < Properties->VariationCustomDataIndex + 5;
+}
+
+TArray<float> UPlacementTool::GetPlacementVariation(const UPaletteObject* PaletteObject, FRandomStream& Stream) const
+{
+	//Always draw all three so toggling one randomization doesn't reroll the others
+	const float TintRandom = Stream.GetFraction();
+	const float WearRandom = Stream.GetFraction();
+	const float AtlasIndexRandom = Stream.GetFraction();
+	if(!PaletteObject)
+		return TArray<float>();
+	const FGridPlacerVariation& Variation = PaletteObject->Variation;
+	return MakeVariationCustomData(
+		Variation.RandomizeTint ? Variation.GetRandomTint(TintRandom) : Variation.Tint,
+		Variation.RandomizeWear ? Variation.GetRandomWear(WearRandom) : Variation.Wear,
+		Variation.RandomizeAtlasIndex ? Variation.GetRandomAtlasIndex(AtlasIndexRandom) : Variation.AtlasIndex);
+}
+
+void UPlacementTool::OnActivePaletteChanged()
+{
+	RebuildAutotileMeshes();
+	UPaletteObject* NextChosenObject = PickNextObjectFromPalette();
+	if(NextChosenObject)
+		SpawnPreviewActor(NextChosenObject);
+	else
+		DestroyPreviewActor();
+}
+
+UPaletteObject* UPlacementTool::PickNextObjectFromPalette()
+{
+	return PickNextObjectFromPalette(Properties->ObjectPalette.GetActivePaletteObjects());
+}
+
+UPaletteObject* UPlacementTool::PickNextObjectFromPalette(const TArray<UPaletteObject*>& ActivePaletteObjects)
+{
+	if(ActivePaletteObjects.Num() == 0)
+		return nullptr;
+	switch(Properties->PalettePickingMode)
+	{
+	case EPalettePickingMode::Random: return ActivePaletteObjects[FMath::RandRange(0, ActivePaletteObjects.Num() - 1)];
+	case EPalettePickingMode::Cycle:
+		//Make sure the index is in bounds
+		CurrentPaletteCyclingIndex %= ActivePaletteObjects.Num();
+		UPaletteObject* ChosenObject = ActivePaletteObjects[CurrentPaletteCyclingIndex++];
+		//Make sure the incremented index is still in bounds
+		CurrentPaletteCyclingIndex %= ActivePaletteObjects.Num();
+		return ChosenObject;
+	}
+	return nullptr;
+}
+
+void UPlacementTool::UpdateGridSpace(const FRay& WorldRay)
+{
+	GRIDPLACER_SCOPE(UpdateGridSpace);
+	FVector TraceStart;
+	FVector TraceEnd;
+	FCollisionQueryParams QueryParams;
+	FHitResult Hit;
+	
+	switch(Properties->GridSpaceMode)
+	{
+	case EGridSpaceMode::Global:
+		break;
+	case EGridSpaceMode::Local:
+		TraceStart = WorldRay.Origin;
+		TraceEnd = TraceStart + WorldRay.Direction * 100000;
+		if(PreviewActor)
+			QueryParams.AddIgnoredActor(PreviewActor);
+		GridPlacerStats::RecordTrace();
+		if(TargetWorld->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, Properties->LocalGridCollisionChannel, QueryParams)){
+			if(AActor* LocalTarget = Hit.GetActor())
 			{
-				PreviewActor->SetActorRotation(Properties->CustomRotationSpaceTarget->GetActorRotation());
-				PreviewActor->AddActorLocalRotation(Properties->CurrentPlacementRotation);
+				//Origin
+				Properties->GridOrigin = FVector::PointPlaneProject(LocalTarget->GetActorLocation(), Hit.ImpactPoint, Hit.ImpactNormal);
+				//Rotation
+				FVector HitTangent;
+				if(FVector::DotProduct(Hit.ImpactNormal, FVector::UpVector) > 0.9f)
+					HitTangent = FVector::CrossProduct(Hit.ImpactNormal, FVector::RightVector);
+				else
+					HitTangent = FVector::CrossProduct(Hit.ImpactNormal, FVector::UpVector);
+				Hit.ImpactNormal = LocalTarget->GetActorRotation().Quaternion().Inverse() * Hit.ImpactNormal;
+				HitTangent = LocalTarget->GetActorRotation().Quaternion().Inverse() * HitTangent;
+				Properties->GridRotation = UKismetMathLibrary::MakeRotFromXZ(HitTangent, Hit.ImpactNormal);
+				Properties->GridRotation += LocalTarget->GetActorRotation();
 			}
-			else
+		}
+		break;
+	case EGridSpaceMode::Custom:
+		if(Properties->CustomGridSpaceTarget)
+		{
+			Properties->GridOrigin = Properties->CustomGridSpaceTarget->GetActorLocation();
+			Properties->GridRotation = Properties->CustomGridSpaceTarget->GetActorRotation();
+		}
+		break;
+	}
+}
+
+GridPlacerMath::FGridSpace UPlacementTool::GetGridSpace() const
+{
+	return GridPlacerMath::ToGridSpace(Properties->GridOrigin, Properties->GridRotation);
+}
+
+FVector UPlacementTool::WorldToGridSpace(FVector WorldSpace) const
+{
+	return GridPlacerMath::ToFVector(GetGridSpace().WorldToGrid(GridPlacerMath::ToGridVector(WorldSpace)));
+}
+
+FVector UPlacementTool::WorldToGridSpaceDirection(FVector WorldSpaceDirection) const
+{
+	return GridPlacerMath::ToFVector(GetGridSpace().WorldToGridDirection(GridPlacerMath::ToGridVector(WorldSpaceDirection)));
+}
+
+FVector UPlacementTool::GridToWorldSpace(FVector GridSpace) const
+{
+	return GridPlacerMath::ToFVector(GetGridSpace().GridToWorld(GridPlacerMath::ToGridVector(GridSpace)));
+}
+
+FVector UPlacementTool::GridToWorldSpaceDirection(FVector GridSpaceDirection) const
+{
+	return GridPlacerMath::ToFVector(GetGridSpace().GridToWorldDirection(GridPlacerMath::ToGridVector(GridSpaceDirection)));
+}
+
+void UPlacementTool::UpdatePlacementPoint(const FRay& WorldRay)
+{
+	GRIDPLACER_SCOPE(UpdatePlacementPoint);
+	//Find Ray-Grid-Intersection
+	const GridPlacerMath::FGridSpace Space = GetGridSpace();
+	GridPlacerMath::FGridVector RayGridIntersection;
+	if(!GridPlacerMath::FGridSpace::IntersectPlane(Space.WorldToGrid(GridPlacerMath::ToGridVector(WorldRay.Origin)),
+		Space.WorldToGridDirection(GridPlacerMath::ToGridVector(WorldRay.Direction)), RayGridIntersection))
+		return;
+	RawPlacementPoint = GridPlacerMath::ToFVector(RayGridIntersection);
+	//Snap RawPlacementPoint to grid
+	SnapPlacementPointToGrid();
+	CurrentGridCell = GridPlacerMath::ToFVector(GridPlacerMath::GetCellCorner(RayGridIntersection, Properties->GridSize.X, Properties->GridSize.Y));
+}
+
+void UPlacementTool::SnapPlacementPointToGrid()
+{
+	GRIDPLACER_SCOPE(SnapPlacementPointToGrid);
+	SnappedPlacementPoint = GridPlacerMath::ToFVector(GridPlacerMath::Snap(GridPlacerMath::ToGridVector(RawPlacementPoint),
+		Properties->GridSize.X, Properties->GridSize.Y, static_cast<GridPlacerMath::ESnapMode>(Properties->SnappingMode)));
+}
+
+FVector UPlacementTool::GetHeightOffsetVector() const
+{
+	return GetHeightOffsetVector(Properties->CurrentPlacementHeightOffset);
+}
+
+FVector UPlacementTool::GetHeightOffsetVector(float HeightOffset) const
+{
+	GridPlacerMath::FGridVector CustomUp;
+	if(Properties->CustomHeightOffsetSpaceTarget)
+		CustomUp = GridPlacerMath::ToGridVector(Properties->CustomHeightOffsetSpaceTarget->GetActorUpVector());
+	return GridPlacerMath::ToFVector(GridPlacerMath::GetHeightOffset(HeightOffset,
+		static_cast<GridPlacerMath::EOffsetSpace>(Properties->CurrentHeightOffsetSpace),
+		GridPlacerMath::ToGridRotation(Properties->GridRotation.Quaternion()),
+		Properties->CustomHeightOffsetSpaceTarget ? &CustomUp : nullptr));
+}
+
+FTransform UPlacementTool::GetPlacementTransform(const FVector& GridPoint, const FRotator& PlacementRotation, float HeightOffset, float Scale) const
+{
+	FQuat Rotation = PlacementRotation.Quaternion();
+	switch(Properties->CurrentRotationSpace)
+	{
+	case EGridSpaceMode::Global:
+		break;
+	case EGridSpaceMode::Local:
+		Rotation = Properties->GridRotation.Quaternion() * Rotation;
+		break;
+	case EGridSpaceMode::Custom:
+		if(Properties->CustomRotationSpaceTarget)
+			Rotation = Properties->CustomRotationSpaceTarget->GetActorQuat() * Rotation;
+		break;
+	}
+	FVector Location = GridToWorldSpace(GridPoint) + GetHeightOffsetVector(HeightOffset);
+	//Account for rotation pivot
+	if(Properties->CurrentRotationPivotMode == ERotationPivotMode::Grid)
+		Location = GridToWorldSpace(GridPoint) + Rotation * FVector::UpVector * HeightOffset;
+	return FTransform(Rotation, Location, FVector(Scale));
+}
+
+FGridPlacerFrame UPlacementTool::GetGridFrame() const
+{
+	FGridPlacerFrame Frame;
+	Frame.GridToWorld = FTransform(Properties->GridRotation, Properties->GridOrigin);
+	Frame.CellSize = FVector(Properties->GridSize.X, Properties->GridSize.Y, Properties->GridLayerHeight);
+	return Frame;
+}
+
+void UPlacementTool::EnsureOccupancy()
+{
+	const FGridPlacerFrame Frame = GetGridFrame();
+	if(OccupancyValid && Frame.Equals(OccupancyFrame))
+		return;
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return;
+	LLM_SCOPE_BYTAG(GridPlacer);
+
+	//Everything placed so far has to be re-stamped whenever the grid moves, after that it's kept up to date incrementally
+	const TMap<uint32, FGridPlacerPlacedItem>& Items = Subsystem->GetItems();
+	Occupancy.Reset();
+	AutotileCells.Reset();
+	SolidCells.Reset();
+	SolidBlocks.Reset();
+	SolidBlockCells.Reset();
+	Columns.Reset();
+	SocketIndex.Reset(Frame);
+	OccupancyFrame = Frame;
+	FGridPlacerCellBox SolidBlock;
+	for(const TPair<uint32, FGridPlacerPlacedItem>& Pair : Items)
+	{
+		if(!Pair.Value.IsValid())
+			continue;
+		Occupancy.Add(Frame.GetFootprint(Subsystem->GetAssetBounds(Pair.Value.Asset.Get()), Pair.Value.Transform));
+		if(UGridPlacerAutotileSet* const* Set = AutotileMeshes.Find(Cast<UStaticMesh>(Pair.Value.Asset.Get())))
+			AutotileCells.Add(GetAutotileCell(Pair.Value.Transform.GetLocation()), {Pair.Key, *Set});
+		AddSolidBlock(Pair.Value, SolidBlock);
+		AddColumnItem(Pair.Value);
+		AddItemSockets(Pair.Value);
+	}
+	OccupancyValid = true;
+	RefreshHiddenBlocks();
+}
+
+void UPlacementTool::OnPlacedItemAdded(const FGridPlacerPlacedItem& Item)
+{
+	if(!OccupancyValid)
+		return;
+	Occupancy.Add(OccupancyFrame.GetFootprint(GetSubsystem()->GetAssetBounds(Item.Asset.Get()), Item.Transform));
+	if(UGridPlacerAutotileSet* const* Set = AutotileMeshes.Find(Cast<UStaticMesh>(Item.Asset.Get())))
+		AutotileCells.Add(GetAutotileCell(Item.Transform.GetLocation()), {Item.Id, *Set});
+	FGridPlacerCellBox SolidBlock;
+	if(AddSolidBlock(Item, SolidBlock))
+		UpdateHiddenBlocks(SolidBlock);
+	AddColumnItem(Item);
+	AddItemSockets(Item);
+}
+
+void UPlacementTool::OnPlacedItemRemoved(const FGridPlacerPlacedItem& Item)
+{
+	if(!OccupancyValid)
+		return;
+	Occupancy.Remove(OccupancyFrame.GetFootprint(GetSubsystem()->GetAssetBounds(Item.Asset.Get()), Item.Transform));
+	const FIntVector Cell = GetAutotileCell(Item.Transform.GetLocation());
+	if(const FAutotileCell* AutotileCell = AutotileCells.Find(Cell))
+		if(AutotileCell->ItemId == Item.Id)
+			AutotileCells.Remove(Cell);
+	RemoveSolidBlock(Item);
+	RemoveColumnItem(Item);
+	SocketIndex.Remove(Item.Id);
+}
+
+FGridPlacerCellBox UPlacementTool::GetGridFootprint(const FBox& LocalBounds, const FTransform& ObjectToWorld, FBox& OutGridBounds) const
+{
+	const FTransform ObjectToGrid = ObjectToWorld.GetRelativeTransform(OccupancyFrame.GridToWorld);
+	OutGridBounds = LocalBounds.IsValid ? LocalBounds.TransformBy(ObjectToGrid) : FBox(ObjectToGrid.GetLocation(), ObjectToGrid.GetLocation());
+	return OccupancyFrame.GetCellBox(OutGridBounds);
+}
+
+void UPlacementTool::AddColumnItem(const FGridPlacerPlacedItem& Item)
+{
+	if(!Properties->AutoStack || !Item.IsValid())
+		return;
+	FBox GridBounds;
+	const FGridPlacerCellBox Cells = GetGridFootprint(GetSubsystem()->GetAssetBounds(Item.Asset.Get()), Item.Transform, GridBounds);
+	const float Top = GridBounds.Max.Z;
+	for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+	{
+		for(int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+		{
+			FColumn& Column = Columns.FindOrAdd(FIntPoint(X, Y));
+			Column.Tops.Emplace(Item.Id, Top);
+			Column.Top = FMath::Max(Column.Top, Top);
+		}
+	}
+}
+
+void UPlacementTool::RemoveColumnItem(const FGridPlacerPlacedItem& Item)
+{
+	if(!Properties->AutoStack || Columns.Num() == 0)
+		return;
+	FBox GridBounds;
+	const FGridPlacerCellBox Cells = GetGridFootprint(GetSubsystem()->GetAssetBounds(Item.Asset.Get()), Item.Transform, GridBounds);
+	for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+	{
+		for(int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+		{
+			FColumn* Column = Columns.Find(FIntPoint(X, Y));
+			if(!Column || Column->Tops.RemoveAllSwap([&Item](const TPair<uint32, float>& Entry) { return Entry.Key == Item.Id; }) == 0)
+				continue;
+			if(Column->Tops.Num() == 0)
 			{
-				PreviewActor->SetActorRotation(Properties->CurrentPlacementRotation);
+				Columns.Remove(FIntPoint(X, Y));
+				continue;
 			}
-			break;
+			//Columns only hold the handful of objects stacked in them, so the next highest is found right away
+			Column->Top = -UE_BIG_NUMBER;
+			for(const TPair<uint32, float>& Entry : Column->Tops)
+				Column->Top = FMath::Max(Column->Top, Entry.Value);
 		}
-		//Account for rotation pivot
-		switch(Properties->CurrentRotationPivotMode)
+	}
+}
+
+FTransform UPlacementTool::StackOnColumns(const FBox& LocalBounds, const FTransform& ObjectToWorld)
+{
+	FBox GridBounds;
+	const FGridPlacerCellBox Cells = GetGridFootprint(LocalBounds, ObjectToWorld, GridBounds);
+	float Top = -UE_BIG_NUMBER;
+	for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+		for(int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+			if(const FColumn* Column = Columns.Find(FIntPoint(X, Y)))
+				Top = FMath::Max(Top, Column->Top);
+	//Objects that already are above the stack, e.g. through their height offset, stay where they are
+	if(Top <= GridBounds.Min.Z)
+		return ObjectToWorld;
+	FTransform Stacked = ObjectToWorld;
+	Stacked.AddToTranslation(OccupancyFrame.GridToWorld.GetRotation().GetUpVector() * (Top - GridBounds.Min.Z));
+	return Stacked;
+}
+
+namespace
+{
+	void GetMeshSockets(const UStaticMesh* Mesh, const FTransform& ObjectToWorld, TArray<FGridPlacerSocketIndex::FSocket>& OutSockets)
+	{
+		for(const UStaticMeshSocket* Socket : Mesh->Sockets)
+			if(Socket)
+				OutSockets.Add({0, FTransform(Socket->RelativeRotation, Socket->RelativeLocation, Socket->RelativeScale) * ObjectToWorld, FName(*Socket->Tag)});
+	}
+}
+
+void UPlacementTool::AddItemSockets(const FGridPlacerPlacedItem& Item)
+{
+	const UStaticMesh* Mesh = Cast<UStaticMesh>(Item.Asset.Get());
+	if(!Properties->SnapToSockets || !Mesh || Mesh->Sockets.Num() == 0 || !Item.IsValid())
+		return;
+	TArray<FGridPlacerSocketIndex::FSocket> Sockets;
+	GetMeshSockets(Mesh, Item.Transform, Sockets);
+	SocketIndex.Add(Item.Id, Sockets);
+}
+
+void UPlacementTool::SnapPreviewToSockets()
+{
+	const UStaticMesh* Mesh = PreviewPaletteObject && PreviewPaletteObject->ObjectType == EPaletteObjectType::StaticMesh ? PreviewPaletteObject->StaticMesh : nullptr;
+	if(!Properties->SnapToSockets || !PreviewActor || !Mesh || Mesh->Sockets.Num() == 0 || !GetSubsystem())
+		return;
+	GRIDPLACER_SCOPE(SocketSnap);
+	EnsureOccupancy();
+
+	const FTransform PreviewTransform = PreviewActor->GetActorTransform();
+	TArray<FGridPlacerSocketIndex::FSocket> PreviewSockets;
+	GetMeshSockets(Mesh, PreviewTransform, PreviewSockets);
+	const FGridPlacerSocketIndex::FSocket* Target = nullptr;
+	int32 SnappedSocket = INDEX_NONE;
+	double ClosestDistanceSquared = UE_BIG_NUMBER;
+	for(int32 SocketIndexInMesh = 0; SocketIndexInMesh < PreviewSockets.Num(); ++SocketIndexInMesh)
+	{
+		const FGridPlacerSocketIndex::FSocket& Socket = PreviewSockets[SocketIndexInMesh];
+		const FGridPlacerSocketIndex::FSocket* Candidate = SocketIndex.FindClosest(Socket.Transform.GetLocation(), Socket.Tag, Properties->SocketSnapDistance);
+		if(!Candidate)
+			continue;
+		const double DistanceSquared = FVector::DistSquared(Candidate->Transform.GetLocation(), Socket.Transform.GetLocation());
+		if(DistanceSquared < ClosestDistanceSquared)
 		{
-			case ERotationPivotMode::ObjectPivot:
-				break;
-		case ERotationPivotMode::Grid:
-				PreviewActor->SetActorLocation(GridToWorldSpace(SnappedPlacementPoint) + PreviewActor->GetActorRotation().Quaternion() * FVector::UpVector * Properties->CurrentPlacementHeightOffset);
-				break;
+			Target = Candidate;
+			SnappedSocket = SocketIndexInMesh;
+			ClosestDistanceSquared = DistanceSquared;
 		}
-		//Set Scale
-		PreviewActor->SetActorScale3D(FVector::OneVector * Properties->CurrentPlacementScale);
 	}
+	if(!Target)
+		return;
+
+	FTransform Snapped = PreviewTransform;
+	if(Properties->AlignToSockets)
+	{
+		//Connected sockets face each other, so the preview's socket ends up turned half way around the target's up axis
+		const UStaticMeshSocket* Socket = Mesh->Sockets[SnappedSocket];
+		const FQuat SocketRotation = Target->Transform.GetRotation() * FQuat(FVector::UpVector, UE_PI);
+		Snapped.SetRotation(SocketRotation * Socket->RelativeRotation.Quaternion().Inverse());
+		Snapped.SetLocation(Target->Transform.GetLocation() - Snapped.GetRotation().RotateVector(PreviewTransform.GetScale3D() * Socket->RelativeLocation));
+	}
+	else
+		Snapped.AddToTranslation(Target->Transform.GetLocation() - PreviewSockets[SnappedSocket].Transform.GetLocation());
+	PreviewActor->SetActorTransform(Snapped);
+}
+
+void UPlacementTool::StackRequests(TArray<FGridPlacerSpawnRequest>& Requests)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Properties->AutoStack || !Subsystem || Requests.Num() == 0)
+		return;
+	EnsureOccupancy();
+	for(FGridPlacerSpawnRequest& Request : Requests)
+		Request.Transform = StackOnColumns(Subsystem->GetAssetBounds(Request.Asset), Request.Transform);
+}
+
+bool UPlacementTool::AddSolidBlock(const FGridPlacerPlacedItem& Item, FGridPlacerCellBox& OutCells)
+{
+	if(Properties->HiddenCellMode == EHiddenCellMode::Off || !Item.IsValid() || !Cast<UStaticMesh>(Item.Asset.Get()))
+		return false;
+	const FBox LocalBounds = GetSubsystem()->GetAssetBounds(Item.Asset.Get());
+	if(!LocalBounds.IsValid)
+		return false;
+	const FBox GridBounds = LocalBounds.TransformBy(Item.Transform.GetRelativeTransform(OccupancyFrame.GridToWorld));
+	OutCells = OccupancyFrame.GetCellBox(GridBounds);
+	//Anything that leaves a gap in its cells, like a floor tile or a pillar, can be looked past
+	const FBox CellBounds = OccupancyFrame.GetCellBounds(OutCells);
+	const FVector Tolerance = OccupancyFrame.CellSize * 0.02;
+	if(!(GridBounds.Min - CellBounds.Min).GetAbs().ComponentwiseAllLessOrEqual(Tolerance) || !(GridBounds.Max - CellBounds.Max).GetAbs().ComponentwiseAllLessOrEqual(Tolerance))
+		return false;
+	SolidCells.Add(OutCells);
+	SolidBlocks.Add(Item.Id, OutCells);
+	for(int32 Z = OutCells.Min.Z; Z <= OutCells.Max.Z; ++Z)
+		for(int32 Y = OutCells.Min.Y; Y <= OutCells.Max.Y; ++Y)
+			for(int32 X = OutCells.Min.X; X <= OutCells.Max.X; ++X)
+				SolidBlockCells.Add(FIntVector(X, Y, Z), Item.Id);
+	return true;
+}
+
+void UPlacementTool::RemoveSolidBlock(const FGridPlacerPlacedItem& Item)
+{
+	FGridPlacerCellBox Cells;
+	if(!SolidBlocks.RemoveAndCopyValue(Item.Id, Cells))
+		return;
+	SolidCells.Remove(Cells);
+	for(int32 Z = Cells.Min.Z; Z <= Cells.Max.Z; ++Z)
+		for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+			for(int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+				if(SolidBlockCells.FindRef(FIntVector(X, Y, Z)) == Item.Id)
+					SolidBlockCells.Remove(FIntVector(X, Y, Z));
+	//An actor that was only moved or swapped stays around and is already unregistered, so it's shown right here.
+	//Instance slots get reused by the swap remove and start out visible anyway
+	if(HiddenBlocks.Remove(Item.Id) && AppliedHiddenCellMode == EHiddenCellMode::Hide && Item.Actor.IsValid() && !Item.IsInstance())
+	{
+		Item.Actor->SetActorHiddenInGame(false);
+		Item.Actor->SetActorEnableCollision(true);
+	}
+	UpdateHiddenBlocks(Cells);
+}
+
+void UPlacementTool::RefreshHiddenBlocks()
+{
+	GRIDPLACER_SCOPE(HiddenCells);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	//Whatever an earlier pass hid has to be shown again if culling was turned off or writes to another custom data float now
+	if(AppliedHiddenCellMode == EHiddenCellMode::Hide
+		&& (Properties->HiddenCellMode != EHiddenCellMode::Hide || AppliedHiddenCustomDataIndex != Properties->HiddenCustomDataIndex))
+		Subsystem->SetItemsHidden(HiddenBlocks.Array(), false, AppliedHiddenCustomDataIndex);
+	AppliedHiddenCellMode = Properties->HiddenCellMode;
+	AppliedHiddenCustomDataIndex = Properties->HiddenCustomDataIndex;
+	HiddenBlocks.Reset();
+	if(Properties->HiddenCellMode == EHiddenCellMode::Off)
+		return;
+
+	//Blocks only read the solid cells, so all of them can be checked at once
+	TArray<uint32> Ids;
+	TArray<FGridPlacerCellBox> Cells;
+	SolidBlocks.GenerateKeyArray(Ids);
+	SolidBlocks.GenerateValueArray(Cells);
+	TArray<bool> Enclosed;
+	Enclosed.SetNumZeroed(Ids.Num());
+	ParallelFor(TEXT("GridPlacer.HiddenCells"), Ids.Num(), 1024, [&](int32 Index)
+	{
+		Enclosed[Index] = SolidCells.IsEnclosed(Cells[Index]);
+	});
+	TArray<uint32> Hidden;
+	TArray<uint32> Visible;
+	for(int32 Index = 0; Index < Ids.Num(); ++Index)
+		(Enclosed[Index] ? Hidden : Visible).Add(Ids[Index]);
+	HiddenBlocks.Append(Hidden);
+	ApplyHiddenBlocks(Hidden, true);
+	//Blocks can still be hidden from an earlier session even though they were uncovered since
+	ApplyHiddenBlocks(Visible, false);
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("HiddenCells", "{0} of {1} solid blocks are enclosed on all sides"), Hidden.Num(), Ids.Num()), EToolMessageLevel::UserNotification);
+}
+
+void UPlacementTool::UpdateHiddenBlocks(const FGridPlacerCellBox& ChangedCells)
+{
+	GRIDPLACER_SCOPE(HiddenCells);
+	const FGridPlacerCellBox Affected(ChangedCells.Min - FIntVector(1), ChangedCells.Max + FIntVector(1));
+	TSet<uint32> Blocks;
+	for(int32 Z = Affected.Min.Z; Z <= Affected.Max.Z; ++Z)
+		for(int32 Y = Affected.Min.Y; Y <= Affected.Max.Y; ++Y)
+			for(int32 X = Affected.Min.X; X <= Affected.Max.X; ++X)
+				if(const uint32* Id = SolidBlockCells.Find(FIntVector(X, Y, Z)))
+					Blocks.Add(*Id);
+
+	TArray<uint32> Hidden;
+	TArray<uint32> Visible;
+	for(const uint32 Id : Blocks)
+	{
+		const bool Enclosed = SolidCells.IsEnclosed(SolidBlocks.FindChecked(Id));
+		if(Enclosed && !HiddenBlocks.Contains(Id))
+		{
+			HiddenBlocks.Add(Id);
+			Hidden.Add(Id);
+		}
+		else if(!Enclosed && HiddenBlocks.Remove(Id))
+			Visible.Add(Id);
+	}
+	ApplyHiddenBlocks(Hidden, true);
+	ApplyHiddenBlocks(Visible, false);
+}
+
+void UPlacementTool::ApplyHiddenBlocks(TArrayView<const uint32> Ids, bool Hidden)
+{
+	if(Ids.Num() > 0 && AppliedHiddenCellMode == EHiddenCellMode::Hide)
+		GetSubsystem()->SetItemsHidden(Ids, Hidden, AppliedHiddenCustomDataIndex);
+}
+
+void UPlacementTool::StripHiddenCells()
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || Properties->HiddenCellMode == EHiddenCellMode::Off)
+		return;
+	EnsureOccupancy();
+	if(HiddenBlocks.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("NoHiddenCells", "There are no enclosed solid blocks to strip"), EToolMessageLevel::UserWarning);
+		return;
+	}
+	const TArray<uint32> Ids = HiddenBlocks.Array();
+	const FText Description = LOCTEXT("StripHiddenCells", "Strip Hidden Cells");
+	GEditor->BeginTransaction(Description);
+	Subsystem->RemoveBatch(Ids, Description);
+	GEditor->EndTransaction();
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("StrippedHiddenCells", "Stripped {0} enclosed solid blocks"), Ids.Num()), EToolMessageLevel::UserNotification);
+}
+
+FGridPlacerCellBox UPlacementTool::GetPaletteObjectFootprint(UPaletteObject* PaletteObject, const FTransform& ObjectToWorld)
+{
+	const FGridPlacerFrame Frame = GetGridFrame();
+	const FTransform ObjectToGrid = ObjectToWorld.GetRelativeTransform(Frame.GridToWorld);
+	//The rotated bounds only change with rotation and scale, moving the preview around just shifts them
+	if(!PaletteObject->CachedGridBoundsRotation.Equals(ObjectToGrid.GetRotation()) || !PaletteObject->CachedGridBoundsScale.Equals(ObjectToGrid.GetScale3D()))
+	{
+		const FBox LocalBounds = PaletteObject->ObjectType == EPaletteObjectType::Stamp
+			? PaletteObject->StampBounds
+			: GetSubsystem()->GetAssetBounds(PaletteObject->GetPlacedAsset());
+		PaletteObject->CachedGridBounds = LocalBounds.IsValid
+			? LocalBounds.TransformBy(FTransform(ObjectToGrid.GetRotation(), FVector::ZeroVector, ObjectToGrid.GetScale3D()))
+			: FBox(FVector::ZeroVector, FVector::ZeroVector);
+		PaletteObject->CachedGridBoundsRotation = ObjectToGrid.GetRotation();
+		PaletteObject->CachedGridBoundsScale = ObjectToGrid.GetScale3D();
+	}
+	return Frame.GetCellBox(PaletteObject->CachedGridBounds.ShiftBy(ObjectToGrid.GetTranslation()));
+}
+
+void UPlacementTool::UpdatePreviewFootprint()
+{
+	PreviewBlocked = false;
+	if(!Properties->PreventOverlaps || !PreviewActor || !PreviewPaletteObject || !GetSubsystem())
+		return;
+	EnsureOccupancy();
+	PreviewFootprint = GetPaletteObjectFootprint(PreviewPaletteObject, PreviewActor->GetActorTransform());
+	PreviewBlocked = Occupancy.Overlaps(PreviewFootprint);
+}
+
+void UPlacementTool::RebuildAutotileMeshes()
+{
+	AutotileMeshes.Reset();
+	for(UPaletteObject* PaletteObject : Properties->ObjectPalette.ObjectsInPalette)
+	{
+		if(!PaletteObject || PaletteObject->ObjectType != EPaletteObjectType::Autotile || !PaletteObject->AutotileSet)
+			continue;
+		for(const FGridPlacerAutotileVariant& Variant : PaletteObject->AutotileSet->Variants)
+			if(Variant.StaticMesh)
+				AutotileMeshes.Add(Variant.StaticMesh, PaletteObject->AutotileSet);
+	}
+	//Placed meshes might belong to a different set now
+	OccupancyValid = false;
 }
-bool UPlacementTool::CanBeginClickSequence(const FInputDeviceRay& ClickPos)
+
+FIntVector UPlacementTool::GetAutotileCell(const FVector& WorldLocation) const
+{
+	//Autotiles sit on the bottom of their layer, nudge them up so rounding errors can't push them into the layer below
+	return OccupancyFrame.WorldToCell(WorldLocation + OccupancyFrame.GridToWorld.GetRotation().GetUpVector() * OccupancyFrame.CellSize.Z * 0.5f);
+}
+
+uint8 UPlacementTool::GetAutotileMask(const FIntVector& Cell, const UGridPlacerAutotileSet* Set) const
+{
+	uint8 Mask = 0;
+	for(int32 i = 0; i < 8; ++i)
+	{
+		const FIntPoint& Offset = UGridPlacerAutotileSet::NeighborOffsets[i];
+		const FAutotileCell* Neighbor = AutotileCells.Find(Cell + FIntVector(Offset.X, Offset.Y, 0));
+		if(Neighbor && Neighbor->Set == Set)
+			Mask |= 1 << i;
+	}
+	return Mask;
+}
+
+FQuat UPlacementTool::GetAutotileRotation(uint8 RotationSteps) const
+{
+	return OccupancyFrame.GridToWorld.GetRotation() * FQuat(FVector::UpVector, FMath::DegreesToRadians(90.0f * RotationSteps));
+}
+
+void UPlacementTool::UpdateAutotilePreview()
 {
+	if(!PreviewActor || !PreviewPaletteObject || PreviewPaletteObject->ObjectType != EPaletteObjectType::Autotile || !PreviewPaletteObject->AutotileSet)
+		return;
+	EnsureOccupancy();
+	//Show the variant the hovered cell would actually get
+	UGridPlacerAutotileSet* Set = PreviewPaletteObject->AutotileSet;
+	const UGridPlacerAutotileSet::FResolvedVariant& Resolved = Set->Resolve(GetAutotileMask(GetAutotileCell(PreviewActor->GetActorLocation()), Set));
+	UStaticMesh* Mesh = Set->GetMesh(Resolved);
+	AStaticMeshActor* PreviewMeshActor = Cast<AStaticMeshActor>(PreviewActor);
+	if(!Mesh || !PreviewMeshActor)
+		return;
+	if(PreviewMeshActor->GetStaticMeshComponent()->GetStaticMesh() != Mesh)
+		PreviewMeshActor->GetStaticMeshComponent()->SetStaticMesh(Mesh);
+	PreviewActor->SetActorRotation(GetAutotileRotation(Resolved.RotationSteps));
+}
+
+bool UPlacementTool::PlaceAutotileCell(UGridPlacerAutotileSet* Set, const FTransform& PreviewTransform)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	EnsureOccupancy();
+	const FIntVector Cell = GetAutotileCell(PreviewTransform.GetLocation());
+	//Painting over a cell that already belongs to the set doesn't change anything
+	if(const FAutotileCell* Existing = AutotileCells.Find(Cell))
+		if(Existing->Set == Set)
+			return false;
+
+	const UGridPlacerAutotileSet::FResolvedVariant& Resolved = Set->Resolve(GetAutotileMask(Cell, Set));
+	UStaticMesh* Mesh = Set->GetMesh(Resolved);
+	if(!Mesh)
+		return false;
+
+	TArray<FGridPlacerSpawnRequest> Requests;
+	TArray<uint32> Removals;
+	FGridPlacerSpawnRequest& Request = Requests.AddDefaulted_GetRef();
+	Request.Asset = Mesh;
+	Request.Transform = FTransform(GetAutotileRotation(Resolved.RotationSteps), PreviewTransform.GetLocation(), PreviewTransform.GetScale3D());
+	Request.AsInstance = Properties->PlaceAsInstances;
+	//Claim the cell up front so the neighbors see it, placing the item fills in its id
+	AutotileCells.Add(Cell, {0, Set});
+	CollectAutotileNeighborUpdates(Cell, Set, Requests, Removals);
+
+	const FText Description = LOCTEXT("PlaceAutotile", "Place Autotile");
+	if(GEditor) GEditor->BeginTransaction(Description);
+	Subsystem->RemoveBatch(Removals, Description);
+	Subsystem->PlaceBatch(Requests, Description);
+	if(GEditor) GEditor->EndTransaction();
+
+	if(AutotileCells.FindRef(Cell).ItemId == 0)
+		AutotileCells.Remove(Cell);
 	return true;
 }
+
+void UPlacementTool::CollectAutotileNeighborUpdates(const FIntVector& Cell, const UGridPlacerAutotileSet* Set, TArray<FGridPlacerSpawnRequest>& OutRequests, TArray<uint32>& OutRemovals)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	for(const FIntPoint& Offset : UGridPlacerAutotileSet::NeighborOffsets)
+	{
+		const FIntVector NeighborCell = Cell + FIntVector(Offset.X, Offset.Y, 0);
+		const FAutotileCell* Neighbor = AutotileCells.Find(NeighborCell);
+		if(!Neighbor || Neighbor->Set != Set || Neighbor->ItemId == 0 || OutRemovals.Contains(Neighbor->ItemId))
+			continue;
+		const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Neighbor->ItemId);
+		if(!Item)
+			continue;
+		const UGridPlacerAutotileSet::FResolvedVariant& Resolved = Set->Resolve(GetAutotileMask(NeighborCell, Set));
+		UStaticMesh* Mesh = Set->GetMesh(Resolved);
+		const FQuat Rotation = GetAutotileRotation(Resolved.RotationSteps);
+		if(!Mesh || (Item->Asset.Get() == Mesh && Item->Transform.GetRotation().Equals(Rotation, KINDA_SMALL_NUMBER)))
+			continue;
+		OutRemovals.Add(Neighbor->ItemId);
+		FGridPlacerSpawnRequest& Request = OutRequests.AddDefaulted_GetRef();
+		Request.Asset = Mesh;
+		Request.Transform = FTransform(Rotation, Item->Transform.GetLocation(), Item->Transform.GetScale3D());
+		Request.AsInstance = Item->IsInstance();
+	}
+}
+
+void UPlacementTool::OnBeginSequencePreview(const FInputDeviceRay& ClickPos)
+{
+	GridPlacerStats::RecordPreviewUpdate();
+	UpdateGridSpace(ClickPos.WorldRay);
+	UpdatePlacementPoint(ClickPos.WorldRay);
+	if(PreviewActor)
+		PreviewActor->SetIsTemporarilyHiddenInEditor(Properties->ToolMode != EPlacementToolMode::Place);
+	if(PreviewActor)
+		PreviewActor->SetActorTransform(GetPlacementTransform(SnappedPlacementPoint, Properties->CurrentPlacementRotation,
+			Properties->CurrentPlacementHeightOffset, Properties->CurrentPlacementScale));
+	if(PreviewActor && PreviewPaletteObject && Properties->AutoStack && GetSubsystem())
+	{
+		EnsureOccupancy();
+		const FBox LocalBounds = PreviewPaletteObject->ObjectType == EPaletteObjectType::Stamp
+			? PreviewPaletteObject->StampBounds
+			: GetSubsystem()->GetAssetBounds(PreviewPaletteObject->GetPlacedAsset());
+		PreviewActor->SetActorTransform(StackOnColumns(LocalBounds, PreviewActor->GetActorTransform()));
+	}
+	SnapPreviewToSockets();
+	UpdateAutotilePreview();
+	UpdatePreviewFootprint();
+	UpdatePathPreview();
+	UpdatePastePreview();
+	if(Properties->ToolMode != EPlacementToolMode::Copy)
+		HasCopyStart = false;
+}
 void UPlacementTool::OnBeginClickSequence(const FInputDeviceRay& ClickPos)
 {
+	LastStrokePlacementPoint = SnappedPlacementPoint;
+	if(Properties->ToolMode == EPlacementToolMode::Erase)
+	{
+		if(EraseBrush())
+			StrokeHasChanges = true;
+		return;
+	}
+	if(Properties->ToolMode == EPlacementToolMode::Replace)
+	{
+		if(ReplaceBrush())
+			StrokeHasChanges = true;
+		return;
+	}
+	//Queued batches record their own undo step later, the stroke only keeps what was placed right away
+	if(Properties->ToolMode == EPlacementToolMode::Scatter)
+	{
+		if(ScatterBrush() == EBulkPlacementResult::Placed)
+			StrokeHasChanges = true;
+		return;
+	}
+	if(Properties->ToolMode == EPlacementToolMode::Line)
+	{
+		//The first click anchors the line, the second one places it
+		if(!HasLineStart)
+			LineStart = SnappedPlacementPoint;
+		else if(PlacePath(LOCTEXT("PlaceLine", "Place Line")) == EBulkPlacementResult::Placed)
+			StrokeHasChanges = true;
+		HasLineStart = !HasLineStart;
+		PathPreviewDirty = true;
+		UpdatePathPreview();
+		return;
+	}
+	if(Properties->ToolMode == EPlacementToolMode::Copy)
+	{
+		//The first click anchors the rectangle, the second one copies it and switches over to pasting
+		if(!HasCopyStart)
+		{
+			CopyStart = GetHoveredCell();
+			HasCopyStart = true;
+			return;
+		}
+		const FGridPlacerCellBox CopyCells = GetCopyCells();
+		HasCopyStart = false;
+		const int32 NumCopied = CopyRegion(CopyCells);
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("RegionCopied", "Copied {0} objects from {1}x{2} cells"),
+			NumCopied, CopyCells.Size().X, CopyCells.Size().Y), EToolMessageLevel::UserNotification);
+		if(NumCopied > 0)
+		{
+			Properties->ToolMode = EPlacementToolMode::Paste;
+			UpdateModePropertySets();
+			NotifyOfPropertyChangeByTool(Properties);
+		}
+		return;
+	}
+	if(Properties->ToolMode == EPlacementToolMode::Paste)
+	{
+		if(PasteRegion() == EBulkPlacementResult::Placed)
+			StrokeHasChanges = true;
+		return;
+	}
+	if(Properties->ToolMode == EPlacementToolMode::Spline)
+	{
+		PathPreviewDirty = true;
+		if(PlacePath(LOCTEXT("PlaceAlongSpline", "Place Along Spline")) == EBulkPlacementResult::Placed)
+			StrokeHasChanges = true;
+		UpdatePathPreview();
+		return;
+	}
+	//Don't place anything on top of cells that are already occupied
+	UpdatePreviewFootprint();
+	if(PreviewBlocked)
+		return;
 	//Realize preview and pick new random object to preview from the active palette
-	RealizePreview();
+	const EBulkPlacementResult Result = RealizePreview();
+	if(Result == EBulkPlacementResult::None)
+		return;
+	if(Result == EBulkPlacementResult::Placed)
+		StrokeHasChanges = true;
 	UPaletteObject* NextChosenObject = PickNextObjectFromPalette();
 	if(NextChosenObject){
 		SpawnPreviewActor(NextChosenObject);
@@ -549,21 +2203,119 @@ void UPlacementTool::OnBeginClickSequence(const FInputDeviceRay& ClickPos)
 		if(Properties->RandomizeScale)
 			RandomizeScale();
 	}
-	ShouldClickSequenceTerminate = true;
 }
-bool UPlacementTool::OnNextSequenceClick(const FInputDeviceRay& ClickPos)
+
+void UPlacementTool::BeginStroke()
+{
+	EndStroke();
+	StrokeHasChanges = false;
+	StrokeReplacedIds.Reset();
+	ScatterSamplerValid = false;
+	if(GEditor)
+		StrokeTransactionIndex = GEditor->BeginTransaction(LOCTEXT("PlacementStroke", "GridPlacer Stroke"));
+}
+
+void UPlacementTool::EndStroke()
+{
+	if(StrokeTransactionIndex == INDEX_NONE)
+		return;
+	//Clicks that didn't change anything shouldn't leave an empty entry in the undo history
+	if(StrokeHasChanges)
+		GEditor->EndTransaction();
+	else
+		GEditor->CancelTransaction(StrokeTransactionIndex);
+	StrokeTransactionIndex = INDEX_NONE;
+}
+
+FInputRayHit UPlacementTool::CanBeginClickDragSequence(const FInputDeviceRay& PressPos)
+{
+	//The grid plane is infinite, there is always something to hit
+	return FInputRayHit(0.0f);
+}
+
+void UPlacementTool::OnClickPress(const FInputDeviceRay& PressPos)
 {
-	return false;
+	BeginStroke();
+	OnBeginSequencePreview(PressPos);
+	OnBeginClickSequence(PressPos);
 }
-void UPlacementTool::OnTerminateClickSequence()
+
+void UPlacementTool::OnClickDrag(const FInputDeviceRay& DragPos)
 {
-	ShouldClickSequenceTerminate = false;
+	OnBeginSequencePreview(DragPos);
+	//Only place again once the cursor snapped to another point, or moved a whole cell when not snapping at all
+	const FVector StrokeDelta = SnappedPlacementPoint - LastStrokePlacementPoint;
+	const bool MovedOn = Properties->SnappingMode == ESnappingMode::None
+		? FMath::Abs(StrokeDelta.X) >= Properties->GridSize.X || FMath::Abs(StrokeDelta.Y) >= Properties->GridSize.Y
+		: !StrokeDelta.IsNearlyZero();
+	//Brushes keep going while dragging, they only affect what they haven't touched yet anyway. Lines and splines are placed by clicking
+	const bool IsBrush = Properties->ToolMode == EPlacementToolMode::Erase || Properties->ToolMode == EPlacementToolMode::Replace || Properties->ToolMode == EPlacementToolMode::Scatter;
+	if(IsBrush || (MovedOn && Properties->ToolMode == EPlacementToolMode::Place))
+		OnBeginClickSequence(DragPos);
 }
 
-bool UPlacementTool::RequestAbortClickSequence()
+void UPlacementTool::OnClickRelease(const FInputDeviceRay& ReleasePos)
 {
-	return ShouldClickSequenceTerminate;
+	EndStroke();
 }
+
+void UPlacementTool::OnTerminateDragSequence()
+{
+	EndStroke();
+}
+
+FInputRayHit UPlacementTool::BeginHoverSequenceHitTest(const FInputDeviceRay& PressPos)
+{
+	return FInputRayHit(0.0f);
+}
+
+void UPlacementTool::OnBeginHover(const FInputDeviceRay& DevicePos)
+{
+	OnBeginSequencePreview(DevicePos);
+}
+
+bool UPlacementTool::OnUpdateHover(const FInputDeviceRay& DevicePos)
+{
+	OnBeginSequencePreview(DevicePos);
+	return true;
+}
+
+void UPlacementTool::OnEndHover()
+{
+}
+#pragma endregion
+
+#pragma region Actions
+void UPlacementToolReplaceActions::ReplaceSelected()
+{
+	if(ParentTool.IsValid())
+		ParentTool->ReplaceSelected();
+}
+
+void UPlacementToolReplaceActions::ReplaceAll()
+{
+	if(ParentTool.IsValid())
+		ParentTool->ReplaceAll();
+}
+
+void UPlacementToolSplineActions::PlaceAlongSpline()
+{
+	if(ParentTool.IsValid())
+		ParentTool->PlaceAlongSpline();
+}
+
+void UPlacementToolStampActions::CaptureStamp()
+{
+	if(ParentTool.IsValid())
+		ParentTool->CaptureStamp();
+}
+
+void UPlacementToolHiddenCellActions::StripHiddenCells()
+{
+	if(ParentTool.IsValid())
+		ParentTool->StripHiddenCells();
+}
+
 #pragma endregion
 
 #pragma region Properties
@@ -5,10 +5,21 @@
 #include "CoreMinimal.h"
 #include "InteractiveTool.h"
 #include "InteractiveToolBuilder.h"
-#include "BaseBehaviors/MultiClickSequenceInputBehavior.h"
+#include "BaseBehaviors/BehaviorTargetInterfaces.h"
 #include "PlacementToolInputBehavior.h"
+#include "GridPlacerOccupancy.h"
+#include "GridPlacerSocketIndex.h"
+#include "GridPlacerAutotileSet.h"
+#include "GridPlacerGridMath.h"
+#include "GridPlacerPoissonSampler.h"
+#include "GridPlacerTypes.h"
+#include "GridPlacerSubsystem.h"
 #include "PlacementTool.generated.h"
 
+struct FGridPlacerPlacedItem;
+class UGridPlacerCellData;
+class USplineComponent;
+
 /**
  * Builder for UPlacementTool
  */
@@ -26,7 +37,81 @@ UENUM(BlueprintType)
 enum class EPaletteObjectType : uint8
 {
 	StaticMesh,
-	ActorClass
+	ActorClass,
+	Autotile,
+	Stamp
+};
+
+/**
+ * One object of a stamp, relative to the stamp's grid aligned pivot
+ */
+USTRUCT()
+struct FGridPlacerStampPiece
+{
+	GENERATED_BODY()
+
+	/*Either a UStaticMesh or an actor UClass*/
+	UPROPERTY()
+	TObjectPtr<UObject> Asset = nullptr;
+	UPROPERTY()
+	FTransform RelativeTransform;
+	/*Custom data the captured object had, placed pieces get it back before the variation is applied*/
+	UPROPERTY()
+	TArray<float> CustomData;
+};
+
+/**
+ * Tint, wear and atlas index written into the custom data of a placed object, see UPlacementToolProperties::ApplyVariation
+ */
+USTRUCT(BlueprintType)
+struct FGridPlacerVariation
+{
+	GENERATED_BODY()
+
+	/*The tint of the object to place*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FLinearColor Tint = FLinearColor::White;
+	/*How worn the object to place is*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (UIMin = "0.0", UIMax = "1.0"))
+	float Wear = 0.0f;
+	/*The tile of a texture atlas the object to place uses*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	int32 AtlasIndex = 0;
+	/*Wether to roll a random tint for every placed object*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization")
+	bool RandomizeTint = false;
+	/*Random tints are blended between these two colors*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization", meta = (EditCondition = "RandomizeTint == true", EditConditionHides))
+	FLinearColor RandomTintA = FLinearColor::White;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization", meta = (EditCondition = "RandomizeTint == true", EditConditionHides))
+	FLinearColor RandomTintB = FLinearColor(0.6f, 0.6f, 0.6f);
+	/*How many divisions of the blend between the random tints to use
+	 * Leave at 0 to allow any blend
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization", meta = (EditCondition = "RandomizeTint == true", EditConditionHides))
+	int TintRandomizationDivisions = 0;
+	/*Wether to roll a random wear for every placed object*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization")
+	bool RandomizeWear = false;
+	/*The range of valid values for the random wear*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization", meta = (EditCondition = "RandomizeWear == true", EditConditionHides))
+	FFloatInterval RandomWearRange = FFloatInterval(0.0f, 1.0f);
+	/*How many divisions of the random wear range to use
+	 * Leave at 0 to allow any value from the random wear range
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization", meta = (EditCondition = "RandomizeWear == true", EditConditionHides))
+	int WearRandomizationDivisions = 0;
+	/*Wether to roll a random atlas index for every placed object*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization")
+	bool RandomizeAtlasIndex = false;
+	/*The range of valid atlas indices, both ends included*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization", meta = (EditCondition = "RandomizeAtlasIndex == true", EditConditionHides))
+	FInt32Interval RandomAtlasIndexRange = FInt32Interval(0, 3);
+
+	/** Random values for the randomization settings, Random01 picks where in the range they end up */
+	FLinearColor GetRandomTint(float Random01) const;
+	float GetRandomWear(float Random01) const;
+	int32 GetRandomAtlasIndex(float Random01) const;
 };
 
 UCLASS()
@@ -43,12 +128,92 @@ public:
 	UStaticMesh* StaticMesh;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	TSubclassOf<AActor> ActorClass;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UGridPlacerAutotileSet* AutotileSet;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	EPaletteObjectType ObjectType;
 
+	/*Minimum distance to other objects when scattering, 0 derives it from the object's bounds*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ScatterSpacing = 0.0f;
+	/*Static meshes only: merged mesh baking may stretch one copy over a rectangle of equal neighbors on the same layer.
+	 UVs are extended along the stretch, so wrapping textures repeat once per tile, but bevels, trims and non-wrapping UV layouts (atlases)
+	 are stretched with it. Only for flat tiles and plain blocks, or tiles with world aligned materials that ignore UVs altogether*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool MergeCoplanar = false;
+	/*Generate only: labels of the edges towards +X, +Y, -X and -Y in grid space.
+	 Tiles are generated next to each other where the edges they touch with have the same label*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FName GenerateEdges[4];
+	/*Tint, wear and atlas index of every object placed from this entry, only written if the tool applies variation*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FGridPlacerVariation Variation;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	UObject* Asset;
+
+	/*Stamps only: every captured object relative to the pivot, which sits on the grid plane of the lowest captured layer*/
+	UPROPERTY()
+	TArray<FGridPlacerStampPiece> StampPieces;
+	/*Stamps only: bounds of all pieces relative to the pivot*/
+	UPROPERTY()
+	FBox StampBounds = FBox(ForceInit);
+
+	/** The static mesh or actor class that will end up in the world */
+	UObject* GetPlacedAsset() const
+	{
+		if(ObjectType == EPaletteObjectType::StaticMesh)
+			return StaticMesh;
+		if(ObjectType == EPaletteObjectType::ActorClass)
+			return ActorClass.Get();
+		if(ObjectType == EPaletteObjectType::Autotile && AutotileSet)
+			return AutotileSet->GetPreviewMesh();
+		return nullptr;
+	}
+
+	/*Grid space bounds of the asset for the rotation and scale it was last placed with*/
+	FBox CachedGridBounds = FBox(ForceInit);
+	FQuat CachedGridBoundsRotation = FQuat::Identity;
+	FVector CachedGridBoundsScale = FVector::ZeroVector;
+};
+
+/**
+ * A placed object in the region buffer
+ */
+struct FGridPlacerRegionPiece
+{
+	/*Index into FGridPlacerRegionBuffer::Assets*/
+	int32 AssetIndex = INDEX_NONE;
+	/*Relative to the pivot corner of the copied region, in grid space*/
+	FTransform GridTransform;
+	bool AsInstance = false;
+	TArray<float> CustomData;
+};
+
+/**
+ * Placed content of a rectangle of grid cells, copied so it can be pasted somewhere else
+ */
+USTRUCT()
+struct FGridPlacerRegionBuffer
+{
+	GENERATED_BODY()
+
+	/*Every asset found in the region once*/
+	UPROPERTY()
+	TArray<TObjectPtr<UObject>> Assets;
+	TArray<FGridPlacerRegionPiece> Pieces;
+	/*Copied cells, the pivot corner sits in the middle of them*/
+	FGridPlacerCellBox Cells;
+
+	void Reset()
+	{
+		Assets.Reset();
+		Pieces.Reset();
+		Cells = FGridPlacerCellBox();
+	}
+	bool IsEmpty() const { return Pieces.Num() == 0; }
+	FIntPoint GetPivotCell() const { return FIntPoint(Cells.Min.X + Cells.Size().X / 2, Cells.Min.Y + Cells.Size().Y / 2); }
 };
 
 DECLARE_DELEGATE(FOnActivePaletteChanged)
@@ -107,6 +272,19 @@ struct FObjectPalette {
 	}
 };
 
+UENUM(BlueprintType)
+enum class EPlacementToolMode : uint8
+{
+	Place,
+	Erase,
+	Replace,
+	Scatter,
+	Line,
+	Spline,
+	Copy,
+	Paste
+};
+
 UENUM(BlueprintType)
 enum class EPalettePickingMode : uint8
 {
@@ -122,15 +300,6 @@ enum class EGridSpaceMode : uint8
 	Custom
 };
 
-UENUM(BlueprintType)
-enum class ESnappingMode : uint8
-{
-	Center,
-	Edges,
-	Corners,
-	None
-};
-
 UENUM(BlueprintType)
 enum class ERotationAxis : uint8
 {
@@ -146,6 +315,37 @@ enum class ERotationPivotMode : uint8
 	Grid
 };
 
+UENUM(BlueprintType)
+enum class EHiddenCellMode : uint8
+{
+	Off,
+	Flag,
+	Hide
+};
+
+UENUM(BlueprintType)
+enum class EPlacementToolCommand : uint8
+{
+	None,
+	Bake,
+	Consolidate,
+	Merge,
+	Generate,
+	Import,
+	Journal
+};
+
+/*What became of a batch handed to the subsystem*/
+enum class EBulkPlacementResult : uint8
+{
+	/*Nothing was left to place*/
+	None,
+	/*Placed right away, inside whatever transaction is open*/
+	Placed,
+	/*Queued on the subsystem, it records its own undo step once it is done*/
+	Queued
+};
+
 /**
  * Property set for the UPlacementTool
  */
@@ -157,6 +357,47 @@ class GRIDPLACER_API UPlacementToolProperties : public UInteractiveToolPropertyS
 public:
 	UPlacementToolProperties();
 
+	/*(R) Determines what clicking and dragging in the viewport does
+	 * Place: Place objects from the active pool
+	 * Erase: Remove placed objects whose footprint overlaps the brush
+	 * Replace: Swap placed objects whose footprint overlaps the brush for objects from the active pool, keeping their transforms
+	 * Scatter: Fill the brush with objects from the active pool in a blue noise pattern, ignoring the grid
+	 * Line: Click a start and an end point to place a row of objects on every grid cell in between
+	 * Spline: Place objects end to end along the spline of SplineActor
+	 * Copy: Click two corners of a rectangle of cells to copy everything placed on them, on every layer
+	 * Paste: Place the copied cells at the hovered cell, turned by CurrentPlacementRotation in steps of 90 degrees
+	 */
+	UPROPERTY(EditAnywhere, Category = "Mode")
+	EPlacementToolMode ToolMode = EPlacementToolMode::Place;
+	/*The width and height of the brush in grid cells*/
+	UPROPERTY(EditAnywhere, Category = "Mode|Brush", meta = (EditCondition = "ToolMode == EPlacementToolMode::Erase || ToolMode == EPlacementToolMode::Replace || ToolMode == EPlacementToolMode::Scatter", EditConditionHides, ClampMin = "1", ClampMax = "64", UIMin = "1", UIMax = "64"))
+	int32 BrushSize = 1;
+	/*Affect objects on every layer instead of only the layer at CurrentPlacementHeightOffset*/
+	UPROPERTY(EditAnywhere, Category = "Mode|Brush", meta = (EditCondition = "ToolMode == EPlacementToolMode::Erase || ToolMode == EPlacementToolMode::Replace", EditConditionHides))
+	bool BrushAffectsAllLayers = false;
+	/*Only replace placed objects using this mesh. Leave empty to replace everything*/
+	UPROPERTY(EditAnywhere, Category = "Mode|Replace", meta = (EditCondition = "ToolMode == EPlacementToolMode::Replace", EditConditionHides, TransientToolProperty))
+	UStaticMesh* ReplaceOnlyMesh = nullptr;
+	/*How often the scatter brush tries to fit another object next to an existing one before giving up on it. More attempts pack tighter but cost more*/
+	UPROPERTY(EditAnywhere, Category = "Mode|Scatter", meta = (EditCondition = "ToolMode == EPlacementToolMode::Scatter", EditConditionHides, ClampMin = "1", ClampMax = "100", UIMin = "1", UIMax = "100"))
+	int32 ScatterAttempts = 30;
+	/*Turn every object of a line or spline to face along it, on top of CurrentPlacementRotation*/
+	UPROPERTY(EditAnywhere, Category = "Mode|Path", meta = (EditCondition = "ToolMode == EPlacementToolMode::Line || ToolMode == EPlacementToolMode::Spline", EditConditionHides))
+	bool OrientAlongPath = true;
+	/*The actor whose first spline component objects are placed along. Objects are spaced by the length of their bounds along X*/
+	UPROPERTY(EditAnywhere, Category = "Mode|Spline", meta = (EditCondition = "ToolMode == EPlacementToolMode::Spline", EditConditionHides, TransientToolProperty))
+	AActor* SplineActor = nullptr;
+	/*The one-shot command whose settings and buttons are shown below the tool's parameters
+	 * Bake: Bake the placed content into cell data for gameplay code
+	 * Consolidate: Turn static mesh actors of palette meshes into chunked instance components
+	 * Merge: Bake placed tiles into one merged static mesh per chunk and back
+	 * Generate: Fill a region with tiles from the active pool that fit together along their edges
+	 * Import: Place a layout sketched as an image
+	 * Journal: Record placements for crash recovery and replay them
+	 */
+	UPROPERTY(EditAnywhere, Category = "Mode")
+	EPlacementToolCommand Command = EPlacementToolCommand::None;
+
 	/*The palette contains all objects that you might want to place.
 	 Tick the checkmark on an object to add it to the active pool.
 	 Objects to be placed will be chosen from the active pool.
@@ -169,10 +410,16 @@ public:
 	 */
 	UPROPERTY(EditAnywhere, Category = "Palette")
 	EPalettePickingMode PalettePickingMode;
+	/*Place static meshes as instances of a shared instanced static mesh component instead of spawning an actor for each of them*/
+	UPROPERTY(EditAnywhere, Category = "Palette")
+	bool PlaceAsInstances = false;
 
 	/*The width and height of a grid cell in centimeters*/
 	UPROPERTY(EditAnywhere, Category = "Grid")
 	FVector2D GridSize = FVector2D(100.0f, 100.0f);
+	/*The height of a grid cell in centimeters. Used to tell stacked objects apart when checking for overlaps*/
+	UPROPERTY(EditAnywhere, Category = "Grid", meta = (ClampMin = "1.0", UIMin = "1.0"))
+	float GridLayerHeight = 100.0f;
 	/*Determines the origin and orientation of the grid
 	 * Global: Use GridOrigin and GridRotation to position the grid anywhere in the world
 	 * Local: The grid will align itself to surfaces of objects the mouse cursor hovers above
@@ -200,6 +447,57 @@ public:
 	 */
 	UPROPERTY(EditAnywhere, Category = "Grid")
 	ESnappingMode SnappingMode;
+	/*Refuse to place objects whose footprint overlaps cells that are already occupied by placed objects
+	 The footprint is derived from the bounds of the object and shown green (free) or red (blocked) in the preview
+	 */
+	UPROPERTY(EditAnywhere, Category = "Grid|Occupancy")
+	bool PreventOverlaps = false;
+	/*Solid blocks, static meshes that fill their cells completely, can't be seen if all six neighbors are solid blocks as well.
+	 (1) Off: Don't look for them
+	 (2) Flag: Keep track of them while placing and erasing, so they can be counted and stripped
+	 (3) Hide: Also hide them, actors in game and instances through their custom data
+	 */
+	UPROPERTY(EditAnywhere, Category = "Grid|Occupancy")
+	EHiddenCellMode HiddenCellMode = EHiddenCellMode::Off;
+	/*Custom data float that is set to 1 on hidden instances and 0 on visible ones. Their material has to mask or collapse them based on it*/
+	UPROPERTY(EditAnywhere, Category = "Grid|Occupancy", meta = (EditCondition = "HiddenCellMode == EHiddenCellMode::Hide", EditConditionHides, ClampMin = "0", UIMin = "0", UIMax = "15"))
+	int32 HiddenCustomDataIndex = 0;
+	/*Move the previewed static mesh so one of its sockets sits on the closest socket with the same tag of an object placed around it.
+	 Modular pieces like pipes, rails or walls connect that way even where they don't line up with the grid
+	 */
+	UPROPERTY(EditAnywhere, Category = "Grid|Sockets")
+	bool SnapToSockets = false;
+	/*How far a socket of the preview may be from a placed socket to snap to it*/
+	UPROPERTY(EditAnywhere, Category = "Grid|Sockets", meta = (EditCondition = "SnapToSockets == true", EditConditionHides, ClampMin = "1.0", UIMin = "1.0", UIMax = "1000.0"))
+	float SocketSnapDistance = 50.0f;
+	/*Also turn the preview so its socket faces the one it snaps to, X axes pointing at each other*/
+	UPROPERTY(EditAnywhere, Category = "Grid|Sockets", meta = (EditCondition = "SnapToSockets == true", EditConditionHides))
+	bool AlignToSockets = false;
+
+	/*Bulk operations like scattering trace down along the grid normal and put their objects onto whatever they hit instead of the grid plane.
+	 The height offset is kept relative to the surface
+	 */
+	UPROPERTY(EditAnywhere, Category = "Surface")
+	bool DropToSurface = false;
+	/*Tilt dropped objects so their up axis follows the surface normal*/
+	UPROPERTY(EditAnywhere, Category = "Surface", meta = (EditCondition = "DropToSurface == true", EditConditionHides))
+	bool AlignToSurfaceNormal = false;
+	/*Objects that would land on a surface steeper than this are not placed*/
+	UPROPERTY(EditAnywhere, Category = "Surface", meta = (EditCondition = "DropToSurface == true", EditConditionHides, ClampMin = "0.0", ClampMax = "90.0", UIMin = "0.0", UIMax = "90.0"))
+	float MaxSurfaceSlope = 90.0f;
+	/*How far above and below the grid plane to look for a surface*/
+	UPROPERTY(EditAnywhere, Category = "Surface", meta = (EditCondition = "DropToSurface == true", EditConditionHides, ClampMin = "1.0", UIMin = "1.0"))
+	float SurfaceTraceDistance = 10000.0f;
+	/*What collision channel to test against when dropping objects*/
+	UPROPERTY(EditAnywhere, Category = "Surface", meta = (EditCondition = "DropToSurface == true", EditConditionHides))
+	TEnumAsByte<ECollisionChannel> SurfaceCollisionChannel = ECC_Visibility;
+
+	/*Batches with more objects than this are placed over several frames instead of all at once, closest to the camera first*/
+	UPROPERTY(EditAnywhere, Category = "Queue", meta = (ClampMin = "1", UIMin = "1"))
+	int32 QueuedPlacementThreshold = 2000;
+	/*How many milliseconds per frame queued batches may spend on placing objects*/
+	UPROPERTY(EditAnywhere, Category = "Queue", meta = (ClampMin = "1.0", ClampMax = "100.0", UIMin = "1.0", UIMax = "100.0"))
+	float QueuedPlacementBudgetMs = 8.0f;
 
 	/*How far away from the surface of the grid should the object be placed*/
 	UPROPERTY(EditAnywhere, Category = "Height Offset")
@@ -223,6 +521,11 @@ public:
 	/*(Shift+Scroll) Change CurrentPlacementHeightOffset by a minor increment*/
 	UPROPERTY(EditAnywhere, Category = "Height Offset", meta = (ClampMin = "0.1", ClampMax = "100.0", UIMin = "0.1", UIMax = "100.0"))
 	float HeightOffsetMinorIncrement = 10.0f;
+	/*Objects land on top of whatever has already been placed in their cells instead of sinking into it.
+	 Uses the bounds of the placed objects, no traces. CurrentPlacementHeightOffset still applies on top of empty or lower cells
+	 */
+	UPROPERTY(EditAnywhere, Category = "Height Offset")
+	bool AutoStack = false;
 	/*Wether to randomize CurrentPlacementHeightOffset after each placement*/
 	UPROPERTY(EditAnywhere, Category = "Height Offset|Randomization")
 	bool RandomizeHeightOffset = false;
@@ -286,15 +589,304 @@ public:
 	/*The range of valid values for the random scale*/
 	UPROPERTY(EditAnywhere, Category = "Scale|Randomization", meta = (EditCondition = "RandomizeScale == true", EditConditionHides))
 	FFloatInterval RandomScaleRange = FFloatInterval(0.5f, 2.0f);
+
+	/*Write the tint, wear and atlas index of each palette entry into the custom data of placed instances or the custom primitive data of placed actors.
+	 Materials read them from there instead of needing a material instance per object, so variation costs no extra draw calls.
+	 Starting at VariationCustomDataIndex the floats are: Tint R, Tint G, Tint B, Wear, Atlas Index
+	 */
+	UPROPERTY(EditAnywhere, Category = "Variation")
+	bool ApplyVariation = false;
+	/*The first custom data float the variation is written to. The five floats must not cover Hidden Custom Data Index while hidden cells are hidden*/
+	UPROPERTY(EditAnywhere, Category = "Variation", meta = (EditCondition = "ApplyVariation == true", EditConditionHides, ClampMin = "0", UIMin = "0", UIMax = "16"))
+	int32 VariationCustomDataIndex = 1;
+};
+
+class UPlacementTool;
+
+/**
+ * Replace commands that work on more than the brush
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolReplaceActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*Replace the selected placed actors, or all instances if the GridPlacerInstances actor is selected*/
+	UFUNCTION(CallInEditor, Category = "Replace")
+	void ReplaceSelected();
+	/*Replace every placed object in the level*/
+	UFUNCTION(CallInEditor, Category = "Replace")
+	void ReplaceAll();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Spline commands, the spline is picked in the tool properties
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolSplineActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*Place the previewed objects along the spline of SplineActor*/
+	UFUNCTION(CallInEditor, Category = "Spline")
+	void PlaceAlongSpline();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Turns the editor selection into a stamp palette entry
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolStampActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*Add the selected actors (or the placed instances of a selected GridPlacerInstances actor) to the palette as a single stamp, pivoted on the grid below them*/
+	UFUNCTION(CallInEditor, Category = "Stamp")
+	void CaptureStamp();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Bakes the placed content into cell data for gameplay code
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolBakeActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*The asset to bake into, create one as a Data Asset of type GridPlacerCellData. Baking overwrites its content.*/
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	TObjectPtr<UGridPlacerCellData> CellData;
+
+	/*Bake every placed object into per cell palette ids, tags, heights and flags, using the current grid*/
+	UFUNCTION(CallInEditor, Category = "Bake")
+	void Bake();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Turns static mesh actors of palette meshes into chunked instance components
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolConsolidateActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*Width and depth in grid cells of the area one instance component covers. Smaller chunks cull better, larger ones need fewer components*/
+	UPROPERTY(EditAnywhere, Category = "Consolidate", meta = (ClampMin = "1", UIMin = "1", UIMax = "256"))
+	int32 ChunkSize = 16;
+	/*First corner of the cells Consolidate Region looks at, on every layer*/
+	UPROPERTY(EditAnywhere, Category = "Consolidate")
+	FIntPoint RegionMin = FIntPoint(0, 0);
+	/*Second corner of the cells Consolidate Region looks at, on every layer*/
+	UPROPERTY(EditAnywhere, Category = "Consolidate")
+	FIntPoint RegionMax = FIntPoint(63, 63);
+
+	/*Replace every static mesh actor in the level that uses a palette mesh by instances, grouped by mesh, materials and chunk*/
+	UFUNCTION(CallInEditor, Category = "Consolidate")
+	void ConsolidateLevel();
+	/*Same as Consolidate Level, but only for actors whose pivot lies between Region Min and Region Max*/
+	UFUNCTION(CallInEditor, Category = "Consolidate")
+	void ConsolidateRegion();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Bakes placed tiles into one merged static mesh per chunk and back
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolMergeActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*Width and depth in grid cells of the area one merged mesh covers*/
+	UPROPERTY(EditAnywhere, Category = "Merge", meta = (ClampMin = "1", UIMin = "1", UIMax = "256"))
+	int32 ChunkSize = 8;
+	/*Content folder the merged meshes are saved to*/
+	UPROPERTY(EditAnywhere, Category = "Merge", meta = (ContentDir))
+	FDirectoryPath OutputFolder = {TEXT("/Game/GridPlacer/Merged")};
+	/*First corner of the cells Merge Region bakes, on every layer*/
+	UPROPERTY(EditAnywhere, Category = "Merge")
+	FIntPoint RegionMin = FIntPoint(0, 0);
+	/*Second corner of the cells Merge Region bakes, on every layer*/
+	UPROPERTY(EditAnywhere, Category = "Merge")
+	FIntPoint RegionMax = FIntPoint(63, 63);
+
+	/*Bake every placed palette mesh whose pivot lies between Region Min and Region Max into one merged mesh per chunk and remove the originals*/
+	UFUNCTION(CallInEditor, Category = "Merge")
+	void MergeRegion();
+	/*Remove the selected merged chunks and place the objects they were baked from again*/
+	UFUNCTION(CallInEditor, Category = "Merge")
+	void UnmergeSelected();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Removes solid blocks nobody can see
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolHiddenCellActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*Remove every solid block that is enclosed by solid blocks on all six sides*/
+	UFUNCTION(CallInEditor, Category = "Hidden Cells")
+	void StripHiddenCells();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Fills a region with tiles from the active pool that fit together along their edges
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolGenerateActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*The same seed, region and tiles always generate the same layout*/
+	UPROPERTY(EditAnywhere, Category = "Generate")
+	int32 Seed = 0;
+	/*Also use every tile turned by 90, 180 and 270 degrees, its edge labels turning along*/
+	UPROPERTY(EditAnywhere, Category = "Generate")
+	bool RotateTiles = true;
+	/*Width and depth in grid cells of the blocks that are solved in parallel. Larger blocks leave fewer seams where nothing fits*/
+	UPROPERTY(EditAnywhere, Category = "Generate", meta = (ClampMin = "4", UIMin = "4", UIMax = "256"))
+	int32 BlockSize = 32;
+	/*How often a block starts over after running into a dead end, before it leaves the cells nothing fits into empty*/
+	UPROPERTY(EditAnywhere, Category = "Generate", meta = (ClampMin = "0", UIMin = "0", UIMax = "100"))
+	int32 Attempts = 10;
+	/*First corner of the cells Generate Region fills, on the layer at CurrentPlacementHeightOffset*/
+	UPROPERTY(EditAnywhere, Category = "Generate")
+	FIntPoint RegionMin = FIntPoint(0, 0);
+	/*Second corner of the cells Generate Region fills*/
+	UPROPERTY(EditAnywhere, Category = "Generate")
+	FIntPoint RegionMax = FIntPoint(63, 63);
+
+	/*Fill every cell between Region Min and Region Max with a tile from the active pool whose edge labels match its neighbors*/
+	UFUNCTION(CallInEditor, Category = "Generate")
+	void GenerateRegion();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Places a layout sketched as an image, one object per pixel
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolImportActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*The image to import. PNG and EXR pixels pick palette entries by color, 16 bit raw heightmaps (.r16, .raw) only drive the height*/
+	UPROPERTY(EditAnywhere, Category = "Import", meta = (FilePathFilter = "Layout images (*.png;*.exr;*.r16;*.raw)|*.png;*.exr;*.r16;*.raw"))
+	FFilePath ImageFile;
+	/*Width of a raw heightmap in pixels, leave at 0 for square ones*/
+	UPROPERTY(EditAnywhere, Category = "Import", meta = (ClampMin = "0", UIMin = "0"))
+	int32 RawWidth = 0;
+	/*The cell the top left pixel lands on. Rows run along +X, the image goes down along +Y*/
+	UPROPERTY(EditAnywhere, Category = "Import")
+	FIntPoint Origin = FIntPoint(0, 0);
+	/*Pixels of the Nth color place the Nth object of the active pool, pixels of other colors and transparent ones stay empty.
+	 Leave empty to pick from the active pool for every pixel like a line would*/
+	UPROPERTY(EditAnywhere, Category = "Import")
+	TArray<FColor> PaletteColors;
+	/*How far apart a pixel may be from a palette color on each channel, in steps of 1/255, and still count as that color*/
+	UPROPERTY(EditAnywhere, Category = "Import", meta = (ClampMin = "0", ClampMax = "255", UIMin = "0", UIMax = "255"))
+	int32 ColorTolerance = 8;
+	/*The height offsets black and white pixels are placed at, like CurrentPlacementHeightOffset*/
+	UPROPERTY(EditAnywhere, Category = "Import")
+	FFloatInterval HeightRange = FFloatInterval(0.0f, 0.0f);
+	/*Round the height offset of every pixel to whole layers of GridLayerHeight*/
+	UPROPERTY(EditAnywhere, Category = "Import")
+	bool SnapHeightToLayers = true;
+
+	/*Place an object for every pixel of Image File, as a single undo step*/
+	UFUNCTION(CallInEditor, Category = "Import")
+	void ImportImage();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
+};
+
+/**
+ * Records the session to a journal and places recorded sessions again
+ */
+UCLASS(Transient)
+class GRIDPLACER_API UPlacementToolJournalActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UPlacementTool* Tool) { ParentTool = Tool; }
+
+	/*Append every place, erase and replace in the level to a journal in Saved/GridPlacer/Journals, one file per level and editor session.
+	 Recording goes on after the tool is closed until this is turned off. After a crash Replay Journal places everything recorded since the last save again*/
+	UPROPERTY(EditAnywhere, Category = "Journal")
+	bool RecordJournal = true;
+	/*The journal to replay. Leave empty for every journal of the current level written to since it was last saved*/
+	UPROPERTY(EditAnywhere, Category = "Journal", meta = (FilePathFilter = "GridPlacer journals (*.gpjournal)|*.gpjournal", TransientToolProperty))
+	FFilePath ReplayFile;
+
+	/*Place every object that was alive at the end of the journals and placed after the last save as a single batch, skipping the ones that are still there*/
+	UFUNCTION(CallInEditor, Category = "Journal")
+	void ReplayJournal();
+
+private:
+	TWeakObjectPtr<UPlacementTool> ParentTool;
 };
 
 /**
  * 
  */
 UCLASS()
-class UPlacementTool : public UInteractiveTool, public IClickSequenceBehaviorTarget
+class UPlacementTool : public UInteractiveTool, public IClickDragBehaviorTarget, public IHoverBehaviorTarget
 {
 	GENERATED_BODY()
+	friend class FGridPlacerPerfHarness;
 
 public:
 	virtual void SetWorld(UWorld* World);
@@ -306,7 +898,23 @@ public:
 	virtual void Shutdown(EToolShutdownType ShutdownType) override;
 	
 public:
+	/*Layers looked at by operations that work on every layer*/
+	static constexpr int32 MaxBrushLayers = 4096;
+
 	void SetSnappingMode(ESnappingMode SnappingMode) { Properties->SnappingMode = SnappingMode; }
+	void ToggleEraseMode();
+	void ReplaceSelected();
+	void ReplaceAll();
+	void BakeCellData(UGridPlacerCellData* CellData);
+	void PlaceAlongSpline();
+	void CaptureStamp();
+	void Consolidate(const FGridPlacerCellBox& Region, int32 ChunkSize);
+	void MergeChunks(const FGridPlacerCellBox& Region, int32 ChunkSize, const FString& OutputFolder);
+	void UnmergeSelected();
+	void StripHiddenCells();
+	void GenerateRegion(const FIntPoint& Min, const FIntPoint& Max, int32 Seed, bool RotateTiles, int32 BlockSize, int32 Attempts);
+	void ImportImage(const UPlacementToolImportActions* Settings);
+	void ReplayJournal(const FString& Filename);
 	
 	enum EPlacementParameterChangeMode
 	{
@@ -329,9 +937,33 @@ protected:
 	/** Properties of the tool are stored here */
 	UPROPERTY()
 	TObjectPtr<UPlacementToolProperties> Properties;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolReplaceActions> ReplaceActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolSplineActions> SplineActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolStampActions> StampActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolBakeActions> BakeActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolConsolidateActions> ConsolidateActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolMergeActions> MergeActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolHiddenCellActions> HiddenCellActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolGenerateActions> GenerateActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolImportActions> ImportActions;
+	UPROPERTY()
+	TObjectPtr<UPlacementToolJournalActions> JournalActions;
 
 protected:
 	UWorld* TargetWorld = nullptr;
+	/*Off for tools driven without the editor's tool manager, e.g. by tests: settings are neither restored nor saved and the journal is left alone*/
+	bool UseSavedSettings = true;
+	/*Set by Shutdown, queued imports stop asking the tool for rows once it is*/
+	bool HasShutDown = false;
 
 	uint32 CurrentPaletteCyclingIndex = 0;
 	UPaletteObject* PreviewPaletteObject = nullptr;
@@ -344,8 +976,11 @@ protected:
 	UFUNCTION()
 	void OnActivePaletteChanged();
 	UPaletteObject* PickNextObjectFromPalette();
+	UPaletteObject* PickNextObjectFromPalette(const TArray<UPaletteObject*>& ActivePaletteObjects);
+	void UpdateModePropertySets();
 
 	void UpdateGridSpace(const FRay& WorldRay);
+	GridPlacerMath::FGridSpace GetGridSpace() const;
 	FVector WorldToGridSpace(FVector WorldSpace) const;
 	FVector WorldToGridSpaceDirection(FVector WorldSpaceDirection) const;
 	FVector GridToWorldSpace(FVector GridSpace) const;
@@ -353,25 +988,231 @@ protected:
 	
 	void UpdatePlacementPoint(const FRay& WorldRay);
 	void SnapPlacementPointToGrid();
-	FVector GetHeightOffsetVector();
+	FVector GetHeightOffsetVector() const;
+	FVector GetHeightOffsetVector(float HeightOffset) const;
+
+	FGridPlacerFrame GetGridFrame() const;
+	void EnsureOccupancy();
+	void OnPlacedItemAdded(const FGridPlacerPlacedItem& Item);
+	void OnPlacedItemRemoved(const FGridPlacerPlacedItem& Item);
+	FGridPlacerCellBox GetPaletteObjectFootprint(UPaletteObject* PaletteObject, const FTransform& ObjectToWorld);
+	void UpdatePreviewFootprint();
+
+	FGridPlacerOccupancy Occupancy;
+	FGridPlacerFrame OccupancyFrame;
+	bool OccupancyValid = false;
+	FGridPlacerCellBox PreviewFootprint;
+	bool PreviewBlocked = false;
+	FDelegateHandle ItemAddedHandle;
+	FDelegateHandle ItemRemovedHandle;
+
+	/** Adds Item to the solid blocks if hidden cells are looked for and it fills its cells. Returns whether it was added. */
+	bool AddSolidBlock(const FGridPlacerPlacedItem& Item, FGridPlacerCellBox& OutCells);
+	void RemoveSolidBlock(const FGridPlacerPlacedItem& Item);
+	/** Checks every solid block again, hides or shows them and reports how many are enclosed */
+	void RefreshHiddenBlocks();
+	/** Checks the solid blocks next to ChangedCells again, nothing further away can have gained or lost a neighbor */
+	void UpdateHiddenBlocks(const FGridPlacerCellBox& ChangedCells);
+	void ApplyHiddenBlocks(TArrayView<const uint32> Ids, bool Hidden);
+	/*Only the cells of solid blocks, in OccupancyFrame*/
+	FGridPlacerOccupancy SolidCells;
+	TMap<uint32, FGridPlacerCellBox> SolidBlocks;
+	/*The solid block covering each solid cell*/
+	TMap<FIntVector, uint32> SolidBlockCells;
+	/*Solid blocks that are currently enclosed on all six sides*/
+	TSet<uint32> HiddenBlocks;
+	/** Adds Item to the column height map if AutoStack is on */
+	void AddColumnItem(const FGridPlacerPlacedItem& Item);
+	void RemoveColumnItem(const FGridPlacerPlacedItem& Item);
+	/** Grid space cells and bounds of an object, in OccupancyFrame */
+	FGridPlacerCellBox GetGridFootprint(const FBox& LocalBounds, const FTransform& ObjectToWorld, FBox& OutGridBounds) const;
+	/** Moves an object with the given local bounds up along the grid normal until it rests on top of the columns it covers */
+	FTransform StackOnColumns(const FBox& LocalBounds, const FTransform& ObjectToWorld);
+	/** Stacks every request on the placed content if AutoStack is on */
+	void StackRequests(TArray<struct FGridPlacerSpawnRequest>& Requests);
+	/*Placed objects reaching into a column of cells and how high they reach, in grid space*/
+	struct FColumn
+	{
+		TArray<TPair<uint32, float>, TInlineAllocator<2>> Tops;
+		float Top = -UE_BIG_NUMBER;
+	};
+	/*Only filled while AutoStack is on, in OccupancyFrame*/
+	TMap<FIntPoint, FColumn> Columns;
+
+	/** Adds the sockets of Item to the socket index if SnapToSockets is on */
+	void AddItemSockets(const FGridPlacerPlacedItem& Item);
+	/** Moves the preview so its socket closest to a compatible placed socket sits on it */
+	void SnapPreviewToSockets();
+	/*Only filled while SnapToSockets is on, hashed by the cells of OccupancyFrame*/
+	FGridPlacerSocketIndex SocketIndex;
+	/** Starts or stops the subsystem's recording to match RecordJournal */
+	void UpdateJournal();
+	/*What HiddenBlocks were last applied with, so turning Hide off shows them again*/
+	EHiddenCellMode AppliedHiddenCellMode = EHiddenCellMode::Off;
+	int32 AppliedHiddenCustomDataIndex = 0;
 
 	void DrawGrid(IToolsContextRenderAPI* RenderAPI);
 	void DrawRotationAxis(IToolsContextRenderAPI* RenderAPI);
 
+	class UGridPlacerSubsystem* GetSubsystem() const;
 	AActor* SpawnPaletteObject(UPaletteObject* PaletteObject, const FName& Name);
 	void SpawnPreviewActor(UPaletteObject* PaletteObject);
 	void DestroyPreviewActor();
-	void RealizePreview();
+	EBulkPlacementResult RealizePreview();
+	/** Places every piece of a stamp whose pivot ends up at StampTransform as a single batch */
+	EBulkPlacementResult PlaceStamp(const UPaletteObject* Stamp, const FTransform& StampTransform);
+	/** Temporary actor that only holds instanced preview components */
+	AActor* SpawnPreviewHost(const FName& Name);
+	class UInstancedStaticMeshComponent* AddPreviewComponent(AActor* Host, UStaticMesh* StaticMesh);
+
+	/** Cells covered by the brush around the hovered cell */
+	FGridPlacerCellBox GetBrushCells() const;
+	/** Collects every placed object whose footprint overlaps the brush */
+	void CollectBrushItems(TArray<uint32>& OutIds);
+	/** Removes every placed object whose footprint overlaps the brush. Returns wether anything was removed */
+	bool EraseBrush();
+	/** Replaces every placed object under the brush that hasn't been replaced during this stroke yet */
+	bool ReplaceBrush();
+	/**
+	 * Swaps placed objects for picks from the active pool, keeping their transforms. Returns how many were replaced.
+	 * Stamps can't stand in for a single object, OutNumSkippedStamps receives how many active entries were left out for that.
+	 */
+	int32 ReplaceItems(TArrayView<const uint32> Ids, int32& OutNumSkippedStamps);
+
+	/** Grid space area the scatter brush covers around the cursor */
+	FBox2D GetScatterRegion() const;
+	/** Fills the part of the brush that has room left with a Poisson disk distribution of the active pool */
+	EBulkPlacementResult ScatterBrush();
+	/** Minimum distance of a scattered object, taken from its palette entry or its bounds */
+	float GetScatterSpacing(UObject* Asset, const UPaletteObject* PaletteObject);
+	/*Reset every stroke, placed objects around the brush are added as they come into reach*/
+	FGridPlacerPoissonSampler ScatterSampler;
+	TSet<uint32> ScatterKnownIds;
+	bool ScatterSamplerValid = false;
+
+	/**
+	 * Moves bulk placements down onto the level along the grid normal if DropToSurface is on.
+	 * All traces of a batch run in parallel, requests landing on too steep surfaces are removed.
+	 */
+	void ProjectToSurface(TArray<struct FGridPlacerSpawnRequest>& Requests);
+
+	/** Where the preview would end up at GridPoint with the given placement parameters */
+	FTransform GetPlacementTransform(const FVector& GridPoint, const FRotator& PlacementRotation, float HeightOffset, float Scale) const;
+	/** Random values for the randomization settings, Random01 picks where in the range they end up */
+	float GetRandomHeightOffset(float Random01) const;
+	FRotator GetRandomRotation(float Random01) const;
+	float GetRandomScale(float Random01) const;
+	/** Rotation, height offset and scale of the next bulk placed object, randomized from Stream where enabled */
+	void GetPlacementParameters(FRandomStream& Stream, FRotator& OutRotation, float& OutHeightOffset, float& OutScale) const;
+	/**
+	 * Custom data holding a variation at VariationCustomDataIndex, empty if ApplyVariation is off.
+	 * Every other float, including the hidden cell float if it overlaps, is NaN so placing leaves it alone.
+	 */
+	TArray<float> MakeVariationCustomData(const FLinearColor& Tint, float Wear, int32 AtlasIndex) const;
+	/** Whether the variation floats cover HiddenCustomDataIndex while hidden cells are hidden */
+	bool VariationOverlapsHiddenCell() const;
+	/** Custom data of the next object placed from PaletteObject, its variation randomized from Stream where enabled */
+	TArray<float> GetPlacementVariation(const UPaletteObject* PaletteObject, FRandomStream& Stream) const;
+
+	/** Active palette objects that can be placed in bulk, autotiles need their neighbors and are left out */
+	TArray<UPaletteObject*> GetBulkPaletteObjects();
+	/** Every static mesh the palette can place, active or not, including the meshes of stamps */
+	TSet<UStaticMesh*> GetPaletteMeshes() const;
+	/** Palette object of the PieceIndex-th piece, the same for every rebuild until the path is placed */
+	UPaletteObject* PickPathObject(const TArray<UPaletteObject*>& PathObjects, int32 PieceIndex, FRandomStream& Stream) const;
+	FGridPlacerSpawnRequest MakePathRequest(const UPaletteObject* PaletteObject, const FTransform& Transform) const;
+	/** One object on every grid cell Bresenham visits from Start to End, both in grid space */
+	void BuildLinePath(const FVector& Start, const FVector& End, TArray<FGridPlacerSpawnRequest>& OutRequests);
+	/** Objects end to end along Spline, each one as long as its bounds */
+	void BuildSplinePath(const USplineComponent* Spline, TArray<FGridPlacerSpawnRequest>& OutRequests);
+	USplineComponent* GetPathSpline() const;
+	/** Rebuilds PathRequests and the instanced preview if the line end or anything else it depends on changed */
+	void UpdatePathPreview();
+	void DestroyPathPreview();
+	/**
+	 * Places Requests as a single batch, or queues them on the subsystem if there are more than QueuedPlacementThreshold.
+	 * OutIds receives the ids of the new items if they were placed right away, queued ones don't have any yet.
+	 */
+	EBulkPlacementResult PlaceBulk(TArray<FGridPlacerSpawnRequest>&& Requests, const FText& Description, TArray<uint32>* OutIds = nullptr);
+	/** Drops requests whose footprint overlaps occupied cells if PreventOverlaps is on */
+	void RemoveBlockedRequests(TArray<FGridPlacerSpawnRequest>& Requests);
+	/** Places PathRequests as a single batch and rerolls the picks for the next path */
+	EBulkPlacementResult PlacePath(const FText& Description);
+
+	/** Grid cell below the cursor */
+	FIntPoint GetHoveredCell() const;
+	/** Cells from the copy start to the hovered cell, on every layer */
+	FGridPlacerCellBox GetCopyCells() const;
+	/** Stores everything placed on Cells in RegionBuffer. Returns how many objects were copied */
+	int32 CopyRegion(const FGridPlacerCellBox& Cells);
+	/** Where the pivot corner of RegionBuffer ends up when pasting at the hovered cell */
+	FTransform GetPasteTransform() const;
+	void UpdatePastePreview();
+	void DestroyPastePreview();
+	/** Places the whole RegionBuffer as a single batch */
+	EBulkPlacementResult PasteRegion();
+
+	UPROPERTY()
+	FGridPlacerRegionBuffer RegionBuffer;
+	AActor* PastePreviewActor = nullptr;
+	bool HasCopyStart = false;
+	FIntPoint CopyStart = FIntPoint::ZeroValue;
+
+	/*Everything the current line or spline would place, already dropped onto the surface*/
+	TArray<FGridPlacerSpawnRequest> PathRequests;
+	/*One instanced component per mesh, actor classes are drawn as their bounds*/
+	AActor* PathPreviewActor = nullptr;
+	TMap<UStaticMesh*, class UInstancedStaticMeshComponent*> PathPreviewComponents;
+	bool PathPreviewDirty = true;
+	FVector PathPreviewEnd = FVector::ZeroVector;
+	/*Seeds picks and randomization of a path so moving the cursor doesn't reroll pieces that are already previewed*/
+	int32 PathSeed = 0;
+	bool HasLineStart = false;
+	FVector LineStart = FVector::ZeroVector;
+
+	/*Autotile cells of the occupancy frame, kept up to date together with the occupancy*/
+	struct FAutotileCell
+	{
+		uint32 ItemId = 0;
+		UGridPlacerAutotileSet* Set = nullptr;
+	};
+	TMap<FIntVector, FAutotileCell> AutotileCells;
+	TMap<TWeakObjectPtr<UStaticMesh>, UGridPlacerAutotileSet*> AutotileMeshes;
+
+	void RebuildAutotileMeshes();
+	FIntVector GetAutotileCell(const FVector& WorldLocation) const;
+	uint8 GetAutotileMask(const FIntVector& Cell, const UGridPlacerAutotileSet* Set) const;
+	FQuat GetAutotileRotation(uint8 RotationSteps) const;
+	void UpdateAutotilePreview();
+	bool PlaceAutotileCell(UGridPlacerAutotileSet* Set, const FTransform& PreviewTransform);
+	/** Re-resolves the neighbors of Cell and collects the replacements for the ones that changed */
+	void CollectAutotileNeighborUpdates(const FIntVector& Cell, const UGridPlacerAutotileSet* Set, TArray<struct FGridPlacerSpawnRequest>& OutRequests, TArray<uint32>& OutRemovals);
 
 	TWeakObjectPtr<UPlacementToolInputBehavior> PlacementToolBehavior;
-	
-	// Inherited via IClickSequenceBehaviorTarget
-	void OnBeginSequencePreview(const FInputDeviceRay& ClickPos) override;
-	bool CanBeginClickSequence(const FInputDeviceRay& ClickPos) override;
-	void OnBeginClickSequence(const FInputDeviceRay& ClickPos) override;
-	bool OnNextSequenceClick(const FInputDeviceRay& ClickPos) override;
-	void OnTerminateClickSequence() override;
-	virtual bool RequestAbortClickSequence() override;
-	bool ShouldClickSequenceTerminate = false;
-	// target World we will raycast into
+
+	/** Updates the grid, placement point and preview for the cursor ray */
+	void OnBeginSequencePreview(const FInputDeviceRay& ClickPos);
+	/** Places the previewed object and picks the next one to preview from the palette */
+	void OnBeginClickSequence(const FInputDeviceRay& ClickPos);
+
+	/*Everything placed while the mouse button is held down is a single undo step*/
+	void BeginStroke();
+	void EndStroke();
+	int32 StrokeTransactionIndex = INDEX_NONE;
+	bool StrokeHasChanges = false;
+	TSet<uint32> StrokeReplacedIds;
+	FVector LastStrokePlacementPoint;
+
+	// Inherited via IClickDragBehaviorTarget
+	virtual FInputRayHit CanBeginClickDragSequence(const FInputDeviceRay& PressPos) override;
+	virtual void OnClickPress(const FInputDeviceRay& PressPos) override;
+	virtual void OnClickDrag(const FInputDeviceRay& DragPos) override;
+	virtual void OnClickRelease(const FInputDeviceRay& ReleasePos) override;
+	virtual void OnTerminateDragSequence() override;
+
+	// Inherited via IHoverBehaviorTarget
+	virtual FInputRayHit BeginHoverSequenceHitTest(const FInputDeviceRay& PressPos) override;
+	virtual void OnBeginHover(const FInputDeviceRay& DevicePos) override;
+	virtual bool OnUpdateHover(const FInputDeviceRay& DevicePos) override;
+	virtual void OnEndHover() override;
 };
\ No newline at end of file
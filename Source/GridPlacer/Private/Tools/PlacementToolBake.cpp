@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlacementTool.h"
+#include "InteractiveToolManager.h"
+#include "GridPlacerSubsystem.h"
+#include "GridPlacerCellData.h"
+
+// localization namespace
+#define LOCTEXT_NAMESPACE "UGridPlacerPlacementTool"
+
+#pragma region Tool
+void UPlacementTool::BakeCellData(UGridPlacerCellData* CellData)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return;
+	if(!CellData)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("BakeNoTarget", "Pick a GridPlacerCellData asset to bake into"), EToolMessageLevel::UserWarning);
+		return;
+	}
+	TArray<FName> DroppedTags;
+	const int32 NumCells = Subsystem->BakeCellData(GetGridFrame(), CellData, &DroppedTags);
+	if(DroppedTags.Num() > 0)
+	{
+		const FString DroppedNames = FString::JoinBy(DroppedTags, TEXT(", "), [](const FName& Tag) { return Tag.ToString(); });
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("BakedDroppedTags", "Baked {0} cells in {1} chunks into {2}, but only 32 tags fit in a cell. Left out: {3}"),
+			NumCells, CellData->GetNumChunks(), FText::FromString(CellData->GetName()), FText::FromString(DroppedNames)), EToolMessageLevel::UserWarning);
+		return;
+	}
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("Baked", "Baked {0} cells in {1} chunks into {2}"),
+		NumCells, CellData->GetNumChunks(), FText::FromString(CellData->GetName())), EToolMessageLevel::UserNotification);
+}
+#pragma endregion
+
+#pragma region Actions
+void UPlacementToolBakeActions::Bake()
+{
+	if(ParentTool.IsValid())
+		ParentTool->BakeCellData(CellData);
+}
+#pragma endregion
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlacementTool.h"
+#include "InteractiveToolManager.h"
+#include "GridPlacerSubsystem.h"
+
+// localization namespace
+#define LOCTEXT_NAMESPACE "UGridPlacerPlacementTool"
+
+#pragma region Tool
+void UPlacementTool::Consolidate(const FGridPlacerCellBox& Region, int32 ChunkSize)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return;
+	const TSet<UStaticMesh*> Meshes = GetPaletteMeshes();
+	if(Meshes.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("ConsolidateNoMeshes", "Add the meshes to consolidate to the palette first"), EToolMessageLevel::UserWarning);
+		return;
+	}
+
+	FGridPlacerConsolidateStats Before;
+	FGridPlacerConsolidateStats After;
+	const int32 NumConsolidated = Subsystem->ConsolidateActors(Meshes.Array(), GetGridFrame(), Region, ChunkSize,
+		LOCTEXT("ConsolidateActors", "Consolidate Actors"), Before, After);
+	if(NumConsolidated == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("ConsolidateNothing", "Found no static mesh actors of palette meshes to consolidate"), EToolMessageLevel::UserNotification);
+		return;
+	}
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("Consolidated", "Consolidated {0} actors into {1} instance components. Components {2} -> {1}, draw calls {3} -> {4}, memory {5} -> {6}"),
+		NumConsolidated, After.NumComponents, Before.NumComponents, Before.NumDrawCalls, After.NumDrawCalls,
+		FText::AsMemory(Before.MemoryBytes), FText::AsMemory(After.MemoryBytes)), EToolMessageLevel::UserNotification);
+}
+
+TSet<UStaticMesh*> UPlacementTool::GetPaletteMeshes() const
+{
+	TSet<UStaticMesh*> Meshes;
+	for(const UPaletteObject* PaletteObject : Properties->ObjectPalette.ObjectsInPalette)
+	{
+		if(!PaletteObject)
+			continue;
+		if(PaletteObject->ObjectType == EPaletteObjectType::StaticMesh && PaletteObject->StaticMesh)
+			Meshes.Add(PaletteObject->StaticMesh);
+		else if(PaletteObject->ObjectType == EPaletteObjectType::Stamp)
+			for(const FGridPlacerStampPiece& Piece : PaletteObject->StampPieces)
+				if(UStaticMesh* Mesh = Cast<UStaticMesh>(Piece.Asset))
+					Meshes.Add(Mesh);
+	}
+	return Meshes;
+}
+#pragma endregion
+
+#pragma region Actions
+void UPlacementToolConsolidateActions::ConsolidateLevel()
+{
+	if(ParentTool.IsValid())
+		ParentTool->Consolidate(FGridPlacerCellBox(), ChunkSize);
+}
+
+void UPlacementToolConsolidateActions::ConsolidateRegion()
+{
+	const FIntVector Min(FMath::Min(RegionMin.X, RegionMax.X), FMath::Min(RegionMin.Y, RegionMax.Y), -UPlacementTool::MaxBrushLayers);
+	const FIntVector Max(FMath::Max(RegionMin.X, RegionMax.X), FMath::Max(RegionMin.Y, RegionMax.Y), UPlacementTool::MaxBrushLayers);
+	if(ParentTool.IsValid())
+		ParentTool->Consolidate(FGridPlacerCellBox(Min, Max), ChunkSize);
+}
+#pragma endregion
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlacementTool.h"
+#include "InteractiveToolManager.h"
+#include "GridPlacerStats.h"
+#include "GridPlacerWaveCollapse.h"
+
+// localization namespace
+#define LOCTEXT_NAMESPACE "UGridPlacerPlacementTool"
+
+#pragma region Tool
+/*Upper bound for a generated region, the solver keeps a bitset of tiles per cell*/
+static constexpr int64 MaxGeneratedCells = 1024 * 1024;
+
+void UPlacementTool::GenerateRegion(const FIntPoint& Min, const FIntPoint& Max, int32 Seed, bool RotateTiles, int32 BlockSize, int32 Attempts)
+{
+	GRIDPLACER_SCOPE(Generate);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	const TArray<UPaletteObject*> TileObjects = GetBulkPaletteObjects();
+	if(TileObjects.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("GenerateNoTiles", "Add static meshes or actor blueprints with edge labels to the active pool first"), EToolMessageLevel::UserWarning);
+		return;
+	}
+	const FIntPoint Size = Max - Min + FIntPoint(1);
+	if(static_cast<int64>(Size.X) * Size.Y > MaxGeneratedCells)
+	{
+		GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("GenerateTooLarge", "Generated regions are limited to {0} cells"), MaxGeneratedCells), EToolMessageLevel::UserWarning);
+		return;
+	}
+
+	//Labels are compared as ids. Turning a tile by a quarter turn counterclockwise moves every label on to the next edge
+	TMap<FName, int32> LabelIds;
+	TArray<FGridPlacerWaveCollapse::FTile> Tiles;
+	TArray<TPair<UPaletteObject*, int32>> TileSources;
+	const int32 NumTurns = RotateTiles ? 4 : 1;
+	for(UPaletteObject* PaletteObject : TileObjects)
+	{
+		FGridPlacerWaveCollapse::FTile Tile;
+		//Every palette entry is as likely as the others, no matter how many turns it comes in
+		Tile.Weight = 1.0f / NumTurns;
+		for(int32 Edge = 0; Edge < FGridPlacerWaveCollapse::NumEdges; ++Edge)
+			Tile.Edges[Edge] = LabelIds.FindOrAdd(PaletteObject->GenerateEdges[Edge], LabelIds.Num());
+		for(int32 Turns = 0; Turns < NumTurns; ++Turns)
+		{
+			Tiles.Add(Tile);
+			TileSources.Add({PaletteObject, Turns});
+			const FGridPlacerWaveCollapse::FTile Unturned = Tile;
+			for(int32 Edge = 0; Edge < FGridPlacerWaveCollapse::NumEdges; ++Edge)
+				Tile.Edges[(Edge + 1) % FGridPlacerWaveCollapse::NumEdges] = Unturned.Edges[Edge];
+		}
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	FGridPlacerWaveCollapse WaveCollapse;
+	WaveCollapse.SetTiles(Tiles);
+	TArray<int32> Solution;
+	const int32 NumUnsolved = WaveCollapse.Solve(Size, Seed, BlockSize, Attempts, Solution);
+	const double SolveMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	FRandomStream Stream(Seed);
+	TArray<FGridPlacerSpawnRequest> Requests;
+	Requests.Reserve(Solution.Num() - NumUnsolved);
+	for(int32 Y = 0; Y < Size.Y; ++Y)
+	{
+		for(int32 X = 0; X < Size.X; ++X)
+		{
+			const int32 Tile = Solution[Y * Size.X + X];
+			if(Tile == INDEX_NONE)
+				continue;
+			const FVector GridPoint((Min.X + X + 0.5) * Properties->GridSize.X, (Min.Y + Y + 0.5) * Properties->GridSize.Y, 0.0);
+			const FRotator Rotation(0.0f, 90.0f * TileSources[Tile].Value, 0.0f);
+			FGridPlacerSpawnRequest& Request = Requests.Add_GetRef(MakePathRequest(TileSources[Tile].Key,
+				GetPlacementTransform(GridPoint, Rotation, Properties->CurrentPlacementHeightOffset, Properties->CurrentPlacementScale)));
+			Request.CustomData = GetPlacementVariation(TileSources[Tile].Key, Stream);
+		}
+	}
+	ProjectToSurface(Requests);
+	StackRequests(Requests);
+	RemoveBlockedRequests(Requests);
+	const int32 NumPlaced = Requests.Num();
+	const EBulkPlacementResult Result = PlaceBulk(MoveTemp(Requests), LOCTEXT("GenerateRegion", "Generate Region"));
+	GetToolManager()->DisplayMessage(FText::Format(Result == EBulkPlacementResult::Queued
+		? LOCTEXT("GeneratedQueued", "Generated {0} tiles from {1} variants in {2} ms, {3} cells had no fitting tile. They are placed over the next frames")
+		: LOCTEXT("Generated", "Generated {0} tiles from {1} variants in {2} ms, {3} cells had no fitting tile"),
+		NumPlaced, Tiles.Num(), FMath::RoundToInt32(SolveMs), NumUnsolved), EToolMessageLevel::UserNotification);
+}
+#pragma endregion
+
+#pragma region Actions
+void UPlacementToolGenerateActions::GenerateRegion()
+{
+	const FIntPoint Min(FMath::Min(RegionMin.X, RegionMax.X), FMath::Min(RegionMin.Y, RegionMax.Y));
+	const FIntPoint Max(FMath::Max(RegionMin.X, RegionMax.X), FMath::Max(RegionMin.Y, RegionMax.Y));
+	if(ParentTool.IsValid())
+		ParentTool->GenerateRegion(Min, Max, Seed, RotateTiles, BlockSize, Attempts);
+}
+#pragma endregion
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlacementTool.h"
+#include "InteractiveToolManager.h"
+#include "GridPlacerSubsystem.h"
+#include "GridPlacerStats.h"
+#include "GridPlacerImageImport.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
+
+// localization namespace
+#define LOCTEXT_NAMESPACE "UGridPlacerPlacementTool"
+
+#pragma region Tool
+/*The spawn queue asks an import for rows until it has at least this many requests, few enough to be traced and placed within a frame's budget*/
+static constexpr int32 ImportBatchSize = 1024;
+
+void UPlacementTool::ImportImage(const UPlacementToolImportActions* Settings)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem)
+		return;
+	GRIDPLACER_SCOPE(ImportImage);
+	LLM_SCOPE_BYTAG(GridPlacer);
+	const TArray<UPaletteObject*> ImportObjects = GetBulkPaletteObjects();
+	if(ImportObjects.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("ImportNoObjects", "Add the objects to import to the active pool first"), EToolMessageLevel::UserWarning);
+		return;
+	}
+	FText Error;
+	TUniquePtr<GridPlacerImageImport::FRowReader> Reader = GridPlacerImageImport::OpenImage(Settings->ImageFile.FilePath, Settings->RawWidth, Error);
+	if(!Reader)
+	{
+		GetToolManager()->DisplayMessage(Error, EToolMessageLevel::UserWarning);
+		return;
+	}
+	const int32 Width = Reader->GetWidth();
+	const int32 Height = Reader->GetHeight();
+
+	//The queue reads the image a few rows at a time while it places, the settings are taken as they are now
+	TArray<FColor> PaletteColors;
+	if(Reader->HasColor())
+		PaletteColors = Settings->PaletteColors;
+	PaletteColors.SetNum(FMath::Min(PaletteColors.Num(), ImportObjects.Num()));
+	//The tool is not kept alive by the queue, the import stops when it shuts down
+	Subsystem->PlaceStreamTimeSliced([this, Tool = TWeakObjectPtr<UPlacementTool>(this), Reader = MoveTemp(Reader), ImportObjects, PaletteColors = MoveTemp(PaletteColors), ColorTolerance = Settings->ColorTolerance,
+		Origin = Settings->Origin, HeightRange = Settings->HeightRange, SnapHeightToLayers = Settings->SnapHeightToLayers, Stream = FRandomStream(PathSeed),
+		ColorObjects = TMap<FColor, int32>(), Row = TArray<FLinearColor>(), NumRows = 0](TArray<FGridPlacerSpawnRequest>& OutRequests) mutable
+	{
+		if(!Tool.IsValid() || HasShutDown)
+		{
+			FNotificationInfo Info(FText::Format(LOCTEXT("ImportStopped", "The tool was closed after {0} of {1} rows, the rest is not imported"), NumRows, Reader->GetHeight()));
+			Info.ExpireDuration = 5.0f;
+			FSlateNotificationManager::Get().AddNotification(Info);
+			return false;
+		}
+		GRIDPLACER_SCOPE(ImportImage);
+		//Sketches only use a handful of colors, each one is matched against the palette colors once
+		auto GetColorObject = [&](const FLinearColor& Pixel)
+		{
+			const FColor Color = Pixel.QuantizeRound();
+			if(const int32* Found = ColorObjects.Find(Color))
+				return *Found;
+			int32 ObjectIndex = INDEX_NONE;
+			for(int32 ColorIndex = 0; ColorIndex < PaletteColors.Num() && ObjectIndex == INDEX_NONE; ++ColorIndex)
+			{
+				const FColor& PaletteColor = PaletteColors[ColorIndex];
+				if(FMath::Abs(Color.R - PaletteColor.R) <= ColorTolerance
+					&& FMath::Abs(Color.G - PaletteColor.G) <= ColorTolerance
+					&& FMath::Abs(Color.B - PaletteColor.B) <= ColorTolerance)
+					ObjectIndex = ColorIndex;
+			}
+			return ColorObjects.Add(Color, ObjectIndex);
+		};
+
+		const bool PickByColor = PaletteColors.Num() > 0;
+		for(; OutRequests.Num() < ImportBatchSize && NumRows < Reader->GetHeight(); ++NumRows)
+		{
+			if(!Reader->ReadRow(Row))
+			{
+				FNotificationInfo Info(FText::Format(LOCTEXT("ImportTruncated", "The image ended after {0} of {1} rows, the rest is not imported"), NumRows, Reader->GetHeight()));
+				Info.ExpireDuration = 5.0f;
+				FSlateNotificationManager::Get().AddNotification(Info);
+				NumRows = Reader->GetHeight();
+				break;
+			}
+			for(int32 X = 0; X < Row.Num(); ++X)
+			{
+				const FLinearColor& Pixel = Row[X];
+				if(Pixel.A <= 0.0f)
+					continue;
+				const int32 ObjectIndex = PickByColor ? GetColorObject(Pixel) : INDEX_NONE;
+				if(PickByColor && ObjectIndex == INDEX_NONE)
+					continue;
+				const UPaletteObject* PaletteObject = PickByColor
+					? ImportObjects[ObjectIndex]
+					: PickPathObject(ImportObjects, NumRows * Row.Num() + X, Stream);
+
+				FRotator Rotation;
+				float HeightOffset;
+				float Scale;
+				GetPlacementParameters(Stream, Rotation, HeightOffset, Scale);
+				HeightOffset = FMath::Lerp(HeightRange.Min, HeightRange.Max, (Pixel.R + Pixel.G + Pixel.B) / 3.0f);
+				if(SnapHeightToLayers)
+					HeightOffset = FMath::RoundToFloat(HeightOffset / Properties->GridLayerHeight) * Properties->GridLayerHeight;
+				const FVector GridPoint((Origin.X + X + 0.5) * Properties->GridSize.X, (Origin.Y + NumRows + 0.5) * Properties->GridSize.Y, 0.0);
+				FGridPlacerSpawnRequest& Request = OutRequests.Add_GetRef(MakePathRequest(PaletteObject, GetPlacementTransform(GridPoint, Rotation, HeightOffset, Scale)));
+				Request.CustomData = GetPlacementVariation(PaletteObject, Stream);
+			}
+		}
+		ProjectToSurface(OutRequests);
+		StackRequests(OutRequests);
+		RemoveBlockedRequests(OutRequests);
+		return NumRows < Reader->GetHeight();
+	}, TArray<UObject*>(ImportObjects), LOCTEXT("ImportImage", "Import Image"), Properties->QueuedPlacementBudgetMs);
+
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("ImportQueued", "Importing a {0}x{1} image, its objects are placed over the next frames"), Width, Height), EToolMessageLevel::UserNotification);
+}
+#pragma endregion
+
+#pragma region Actions
+void UPlacementToolImportActions::ImportImage()
+{
+	if(ParentTool.IsValid())
+		ParentTool->ImportImage(this);
+}
+#pragma endregion
+
+#undef LOCTEXT_NAMESPACE
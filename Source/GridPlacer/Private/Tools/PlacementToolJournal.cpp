@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlacementTool.h"
+#include "InteractiveToolManager.h"
+#include "GridPlacerSubsystem.h"
+#include "GridPlacerStats.h"
+#include "GridPlacerJournal.h"
+
+// localization namespace
+#define LOCTEXT_NAMESPACE "UGridPlacerPlacementTool"
+
+#pragma region Tool
+void UPlacementTool::UpdateJournal()
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || !UseSavedSettings)
+		return;
+	if(JournalActions->RecordJournal)
+		Subsystem->StartJournal(GetGridFrame());
+	else
+		Subsystem->StopJournal();
+}
+
+void UPlacementTool::ReplayJournal(const FString& Filename)
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || !TargetWorld)
+		return;
+	GRIDPLACER_SCOPE(ReplayJournal);
+	LLM_SCOPE_BYTAG(GridPlacer);
+
+	//The journal being recorded has to be read up to now
+	Subsystem->FlushJournal();
+	TArray<FString> JournalFiles;
+	if(Filename.IsEmpty())
+		JournalFiles = Subsystem->FindUnsavedJournals();
+	else
+		JournalFiles.Add(Filename);
+	if(JournalFiles.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("NoJournal", "There is no journal of this level written to since it was saved"), EToolMessageLevel::UserWarning);
+		return;
+	}
+
+	TArray<FGridPlacerJournal::FEntry> Entries;
+	TArray<FGridPlacerJournal::FEntry> Erased;
+	int32 NumRecords = 0;
+	for(const FString& JournalFile : JournalFiles)
+	{
+		int32 NumFileRecords = 0;
+		if(!FGridPlacerJournal::Read(JournalFile, Entries, Erased, NumFileRecords))
+		{
+			GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("JournalUnreadable", "{0} is not a GridPlacer journal"), FText::FromString(JournalFile)), EToolMessageLevel::UserWarning);
+			return;
+		}
+		NumRecords += NumFileRecords;
+	}
+
+	//Erases of objects that were there before the journals started: ones placed by another of the journals are simply not placed,
+	//ones still in the level are removed again
+	auto FindNearby = [Subsystem](const FVector& Location, TArray<uint32>& OutIds)
+	{
+		OutIds.Reset();
+		Subsystem->QueryItems(FBox(Location - FVector(1.0), Location + FVector(1.0)), OutIds);
+	};
+	TArray<uint32> NearbyIds;
+	TArray<uint32> RemovedIds;
+	for(const FGridPlacerJournal::FEntry& Entry : Erased)
+	{
+		const int32 EntryIndex = Entries.IndexOfByPredicate([&Entry](const FGridPlacerJournal::FEntry& Other)
+		{
+			return Other.Asset == Entry.Asset && Other.Transform.Equals(Entry.Transform, 0.01);
+		});
+		if(EntryIndex != INDEX_NONE)
+		{
+			Entries.RemoveAtSwap(EntryIndex);
+			continue;
+		}
+		const UObject* Asset = Entry.Asset.ResolveObject();
+		if(!Asset)
+			continue;
+		FindNearby(Entry.Transform.GetLocation(), NearbyIds);
+		for(const uint32 Id : NearbyIds)
+		{
+			const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+			if(Item && Item->Asset.Get() == Asset && Item->Transform.Equals(Entry.Transform, 0.01) && !RemovedIds.Contains(Id))
+			{
+				RemovedIds.Add(Id);
+				break;
+			}
+		}
+	}
+	if(RemovedIds.Num() > 0)
+		Subsystem->RemoveBatch(RemovedIds, LOCTEXT("ReplayJournalErases", "Replay Journal Erases"));
+
+	//Objects that are still there, e.g. because the level was saved before the crash, aren't placed twice,
+	//neither are objects that show up in more than one journal because an earlier replay placed them again
+	TArray<FGridPlacerSpawnRequest> Requests;
+	Requests.Reserve(Entries.Num());
+	TMultiMap<FIntVector, int32> RequestsByLocation;
+	int32 NumExisting = 0;
+	int32 NumMissingAssets = 0;
+	for(FGridPlacerJournal::FEntry& Entry : Entries)
+	{
+		UObject* Asset = Entry.Asset.TryLoad();
+		if(!Asset)
+		{
+			++NumMissingAssets;
+			continue;
+		}
+		const FVector Location = Entry.Transform.GetLocation();
+		const FIntVector RoundedLocation(FMath::RoundToInt32(Location.X), FMath::RoundToInt32(Location.Y), FMath::RoundToInt32(Location.Z));
+		TArray<int32, TInlineAllocator<4>> SameLocation;
+		RequestsByLocation.MultiFind(RoundedLocation, SameLocation);
+		FindNearby(Location, NearbyIds);
+		if(NearbyIds.ContainsByPredicate([&](uint32 Id)
+		{
+			const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+			return Item && Item->Asset.Get() == Asset && Item->Transform.Equals(Entry.Transform, 0.01);
+		}) || SameLocation.ContainsByPredicate([&](int32 Index)
+		{
+			return Requests[Index].Asset == Asset && Requests[Index].Transform.Equals(Entry.Transform, 0.01);
+		}))
+		{
+			++NumExisting;
+			continue;
+		}
+		RequestsByLocation.Add(RoundedLocation, Requests.Num());
+		FGridPlacerSpawnRequest& Request = Requests.AddDefaulted_GetRef();
+		Request.Asset = Asset;
+		Request.Transform = Entry.Transform;
+		Request.AsInstance = Entry.AsInstance && Cast<UStaticMesh>(Asset);
+		Request.CustomData = MoveTemp(Entry.CustomData);
+	}
+	const int32 NumReplayed = Requests.Num();
+	const EBulkPlacementResult Result = PlaceBulk(MoveTemp(Requests), LOCTEXT("ReplayJournal", "Replay Journal"));
+	GetToolManager()->DisplayMessage(FText::Format(Result == EBulkPlacementResult::Queued
+		? LOCTEXT("JournalReplayQueued", "Replaying {0} objects from {1} records of {2} journals over the next frames and erased {5} again, {3} were still there and {4} had missing assets")
+		: LOCTEXT("JournalReplayed", "Replayed {0} objects from {1} records of {2} journals and erased {5} again, {3} were still there and {4} had missing assets"),
+		NumReplayed, NumRecords, JournalFiles.Num(), NumExisting, NumMissingAssets, RemovedIds.Num()), EToolMessageLevel::UserNotification);
+}
+#pragma endregion
+
+#pragma region Actions
+void UPlacementToolJournalActions::ReplayJournal()
+{
+	if(ParentTool.IsValid())
+		ParentTool->ReplayJournal(ReplayFile.FilePath);
+}
+#pragma endregion
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlacementTool.h"
+#include "InteractiveToolManager.h"
+#include "GridPlacerSubsystem.h"
+#include "GridPlacerMeshMerge.h"
+#include "GridPlacerMergedChunk.h"
+#include "AssetToolsModule.h"
+#include "Engine/World.h"
+#include "Engine/Selection.h"
+#include "Editor.h"
+
+// localization namespace
+#define LOCTEXT_NAMESPACE "UGridPlacerPlacementTool"
+
+#pragma region Tool
+void UPlacementTool::MergeChunks(const FGridPlacerCellBox& Region, int32 ChunkSize, const FString& OutputFolder)
+{
+	GRIDPLACER_SCOPE(MergeChunks);
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || !GEditor)
+		return;
+	ChunkSize = FMath::Max(ChunkSize, 1);
+	const TSet<UStaticMesh*> Meshes = GetPaletteMeshes();
+	TSet<UStaticMesh*> CoplanarMeshes;
+	for(const UPaletteObject* PaletteObject : Properties->ObjectPalette.ObjectsInPalette)
+		if(PaletteObject && PaletteObject->ObjectType == EPaletteObjectType::StaticMesh && PaletteObject->MergeCoplanar)
+			CoplanarMeshes.Add(PaletteObject->StaticMesh);
+
+	//Everything placed with a palette mesh in the region, sorted into chunks by pivot cell
+	const FGridPlacerFrame Frame = GetGridFrame();
+	TArray<uint32> Candidates;
+	Subsystem->QueryItems(Frame.GetCellBounds(Region).TransformBy(Frame.GridToWorld), Candidates);
+	TMap<FIntPoint, TArray<uint32>> ChunkItems;
+	for(const uint32 Id : Candidates)
+	{
+		const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+		UStaticMesh* Mesh = Item && Item->IsValid() ? Cast<UStaticMesh>(Item->Asset.Get()) : nullptr;
+		if(!Mesh || !Meshes.Contains(Mesh))
+			continue;
+		//The merged mesh uses the materials of the tile meshes, overridden ones would get lost
+		const UMeshComponent* MeshComponent = Item->IsInstance() ? Cast<UMeshComponent>(Item->Component.Get()) : Cast<UMeshComponent>(Item->Actor->GetRootComponent());
+		if(MeshComponent && MeshComponent->OverrideMaterials.ContainsByPredicate([](const UMaterialInterface* Material) { return Material != nullptr; }))
+			continue;
+		const FIntVector Cell = Frame.WorldToCell(Item->Transform.GetLocation());
+		if(!Region.Intersects(FGridPlacerCellBox(Cell, Cell)))
+			continue;
+		ChunkItems.FindOrAdd(FIntPoint(FMath::FloorToInt32(Cell.X / static_cast<double>(ChunkSize)), FMath::FloorToInt32(Cell.Y / static_cast<double>(ChunkSize)))).Add(Id);
+	}
+	if(ChunkItems.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("MergeNothing", "Found no placed palette meshes to merge in the region"), EToolMessageLevel::UserNotification);
+		return;
+	}
+
+	const FText Description = LOCTEXT("MergeChunks", "Merge Chunks");
+	GEditor->BeginTransaction(Description);
+	UWorld* World = TargetWorld;
+	World->GetCurrentLevel()->Modify();
+	IAssetTools& AssetTools = FAssetToolsModule::GetModule().Get();
+	TArray<uint32> MergedIds;
+	TArray<GridPlacerMeshMerge::FTile> Tiles;
+	int32 NumChunks = 0;
+	int32 NumPieces = 0;
+	for(const TPair<FIntPoint, TArray<uint32>>& Chunk : ChunkItems)
+	{
+		Tiles.Reset();
+		for(const uint32 Id : Chunk.Value)
+		{
+			const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+			UStaticMesh* Mesh = Cast<UStaticMesh>(Item->Asset.Get());
+			Tiles.Add({Mesh, Item->Transform, CoplanarMeshes.Contains(Mesh)});
+		}
+		//Vertices are stored relative to the chunk corner to keep precision far away from the origin
+		const FVector ChunkCorner(Chunk.Key.X * ChunkSize * Frame.CellSize.X, Chunk.Key.Y * ChunkSize * Frame.CellSize.Y, 0.0);
+		const FTransform Pivot(Frame.GridToWorld.GetRotation(), Frame.GridToWorld.TransformPosition(ChunkCorner));
+		FString PackageName;
+		FString AssetName;
+		AssetTools.CreateUniqueAssetName(FString::Printf(TEXT("%s/SM_%s_Merged_X%dY%d"), *OutputFolder, *World->GetMapName(), Chunk.Key.X, Chunk.Key.Y), TEXT(""), PackageName, AssetName);
+		int32 NumChunkPieces = 0;
+		UStaticMesh* MergedMesh = GridPlacerMeshMerge::BuildMergedMesh(Tiles, Frame, Pivot, PackageName, NumChunkPieces);
+		if(!MergedMesh)
+			continue;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.OverrideLevel = World->GetCurrentLevel();
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AGridPlacerMergedChunk* ChunkActor = World->SpawnActor<AGridPlacerMergedChunk>(AGridPlacerMergedChunk::StaticClass(), Pivot, SpawnParams);
+		if(!ChunkActor)
+			continue;
+		ChunkActor->GetStaticMeshComponent()->SetStaticMesh(MergedMesh);
+		ChunkActor->SetActorLabel(AssetName);
+		ChunkActor->Chunk = Chunk.Key;
+		for(const uint32 Id : Chunk.Value)
+		{
+			const FGridPlacerPlacedItem* Item = Subsystem->FindItem(Id);
+			FGridPlacerMergedSource& Source = ChunkActor->Sources.AddDefaulted_GetRef();
+			Source.Asset = Item->Asset.Get();
+			Source.Transform = Item->Transform;
+			Source.AsInstance = Item->IsInstance();
+			Source.CustomData = Subsystem->GetItemCustomData(*Item);
+		}
+		ChunkActor->MarkPackageDirty();
+		MergedIds.Append(Chunk.Value);
+		NumPieces += NumChunkPieces;
+		++NumChunks;
+	}
+	Subsystem->RemoveBatch(MergedIds, Description);
+	GEditor->EndTransaction();
+
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("Merged", "Merged {0} objects into {1} chunk meshes made of {2} pieces"),
+		MergedIds.Num(), NumChunks, NumPieces), EToolMessageLevel::UserNotification);
+}
+
+void UPlacementTool::UnmergeSelected()
+{
+	UGridPlacerSubsystem* Subsystem = GetSubsystem();
+	if(!Subsystem || !GEditor)
+		return;
+	TArray<AGridPlacerMergedChunk*> Chunks;
+	for(FSelectionIterator It(*GEditor->GetSelectedActors()); It; ++It)
+		if(AGridPlacerMergedChunk* Chunk = Cast<AGridPlacerMergedChunk>(*It))
+			Chunks.Add(Chunk);
+	if(Chunks.Num() == 0)
+	{
+		GetToolManager()->DisplayMessage(LOCTEXT("UnmergeNothing", "Select the merged chunks to restore"), EToolMessageLevel::UserWarning);
+		return;
+	}
+
+	const FText Description = LOCTEXT("UnmergeChunks", "Unmerge Chunks");
+	GEditor->BeginTransaction(Description);
+	TArray<FGridPlacerSpawnRequest> Requests;
+	for(AGridPlacerMergedChunk* Chunk : Chunks)
+	{
+		for(const FGridPlacerMergedSource& Source : Chunk->Sources)
+		{
+			FGridPlacerSpawnRequest& Request = Requests.AddDefaulted_GetRef();
+			Request.Asset = Source.Asset.LoadSynchronous();
+			Request.Transform = Source.Transform;
+			Request.AsInstance = Source.AsInstance;
+			Request.CustomData = Source.CustomData;
+		}
+		//The merged mesh asset stays, other levels may use it as well
+		Chunk->Modify();
+		TargetWorld->EditorDestroyActor(Chunk, true);
+	}
+	Subsystem->PlaceBatch(Requests, Description);
+	GEditor->EndTransaction();
+	GetToolManager()->DisplayMessage(FText::Format(LOCTEXT("Unmerged", "Restored {0} objects from {1} merged chunks"), Requests.Num(), Chunks.Num()), EToolMessageLevel::UserNotification);
+}
+#pragma endregion
+
+#pragma region Actions
+void UPlacementToolMergeActions::MergeRegion()
+{
+	const FIntVector Min(FMath::Min(RegionMin.X, RegionMax.X), FMath::Min(RegionMin.Y, RegionMax.Y), -UPlacementTool::MaxBrushLayers);
+	const FIntVector Max(FMath::Max(RegionMin.X, RegionMax.X), FMath::Max(RegionMin.Y, RegionMax.Y), UPlacementTool::MaxBrushLayers);
+	if(ParentTool.IsValid())
+		ParentTool->MergeChunks(FGridPlacerCellBox(Min, Max), ChunkSize, OutputFolder.Path);
+}
+
+void UPlacementToolMergeActions::UnmergeSelected()
+{
+	if(ParentTool.IsValid())
+		ParentTool->UnmergeSelected();
+}
+#pragma endregion
+
+#undef LOCTEXT_NAMESPACE
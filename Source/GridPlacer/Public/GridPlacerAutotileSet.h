@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GridPlacerAutotileSet.generated.h"
+
+class UStaticMesh;
+
+UENUM(BlueprintType)
+enum class EGridPlacerAutotileNeighborhood : uint8
+{
+	FourNeighbors,
+	EightNeighbors
+};
+
+/*Neighbor directions in grid space, North being +X and East being +Y.
+ The bits go around clockwise so rotating a mask by 90° is a rotation by two bits.
+ */
+UENUM(meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EGridPlacerAutotileNeighbor : uint8
+{
+	None = 0 UMETA(Hidden),
+	North = 1 << 0,
+	NorthEast = 1 << 1,
+	East = 1 << 2,
+	SouthEast = 1 << 3,
+	South = 1 << 4,
+	SouthWest = 1 << 5,
+	West = 1 << 6,
+	NorthWest = 1 << 7
+};
+ENUM_CLASS_FLAGS(EGridPlacerAutotileNeighbor)
+
+USTRUCT(BlueprintType)
+struct FGridPlacerAutotileVariant
+{
+	GENERATED_BODY()
+
+	/*The mesh to place when the neighborhood of a cell matches Connections*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autotile")
+	UStaticMesh* StaticMesh = nullptr;
+	/*The neighbors this mesh connects to in its unrotated orientation*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autotile", meta = (Bitmask, BitmaskEnum = "/Script/GridPlacer.EGridPlacerAutotileNeighbor"))
+	int32 Connections = 0;
+	/*Wether the mesh may be rotated in 90° steps to match other neighborhoods*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autotile")
+	bool AllowRotation = true;
+};
+
+/**
+ * A set of meshes that GridPlacer picks from based on which neighboring cells are occupied by the same set,
+ * like tilemap autotiling. All 256 neighbor masks are resolved once into a lookup table.
+ */
+UCLASS(BlueprintType)
+class GRIDPLACER_API UGridPlacerAutotileSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	struct FResolvedVariant
+	{
+		int32 VariantIndex = INDEX_NONE;
+		uint8 RotationSteps = 0;
+	};
+
+	/*Offsets of the neighbor cells in the order of EGridPlacerAutotileNeighbor*/
+	static const FIntPoint NeighborOffsets[8];
+
+	/*Wether diagonal neighbors are taken into account*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autotile")
+	EGridPlacerAutotileNeighborhood Neighborhood = EGridPlacerAutotileNeighborhood::FourNeighbors;
+	/*The meshes to choose from. Neighborhoods that no variant matches exactly get the closest match*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autotile")
+	TArray<FGridPlacerAutotileVariant> Variants;
+
+	/** Variant and rotation for a mask of occupied neighbors */
+	const FResolvedVariant& Resolve(uint8 NeighborMask) const;
+	/** The mesh a resolved variant places, or nullptr */
+	UStaticMesh* GetMesh(const FResolvedVariant& Resolved) const;
+	/** The mesh to preview a cell without neighbors with */
+	UStaticMesh* GetPreviewMesh() const { return GetMesh(Resolve(0)); }
+	bool ContainsMesh(const UStaticMesh* StaticMesh) const;
+
+	/** UObject interface */
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	uint8 NormalizeMask(uint8 NeighborMask) const;
+	static uint8 RotateMask(uint8 NeighborMask, int32 Steps);
+	void BuildLookupTable() const;
+
+	mutable TArray<FResolvedVariant> LookupTable;
+};
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Change.h"
+
+struct FGridPlacerSpawnRequest;
+struct FGridPlacerConsolidateRequest;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Undo record for a batch of GridPlacer placements or removals.
+ * Only the touched items are stored (id, asset and transform), so memory and undo/redo time scale
+ * with the size of the change rather than with the size of the level or instance component.
+ * The change targets the level the items live in and resolves UGridPlacerSubsystem from it.
+ */
+class GRIDPLACER_API FGridPlacerPlacementChange : public FCommandChange
+{
+public:
+	enum class EKind : uint8
+	{
+		Added,
+		Removed
+	};
+
+	explicit FGridPlacerPlacementChange(EKind InKind) : Kind(InKind) {}
+
+	void AddRecord(uint32 Id, const FGridPlacerSpawnRequest& Request);
+	int32 Num() const { return Records.Num(); }
+
+	/** FCommandChange interface */
+	virtual void Apply(UObject* Object) override;
+	virtual void Revert(UObject* Object) override;
+	virtual bool HasExpired(UObject* Object) const override;
+	virtual FString ToString() const override;
+
+protected:
+	struct FRecord
+	{
+		uint32 Id;
+		int32 AssetIndex;
+		FTransform Transform;
+		bool AsInstance;
+		/*Consolidated instances go back into the component they came from as long as it exists*/
+		TWeakObjectPtr<UInstancedStaticMeshComponent> Component;
+		TArray<float> CustomData;
+	};
+
+	void SpawnRecords(UObject* Object);
+	void RemoveRecords(UObject* Object);
+
+	EKind Kind;
+	TArray<FRecord> Records;
+	/*Assets are shared between records, most batches only use a handful*/
+	TArray<TSoftObjectPtr<UObject>> Assets;
+};
+
+/**
+ * Undo record for a batch of asset swaps on placed items.
+ * Items keep their ids and transforms, so only the asset before and after is stored per item.
+ */
+class GRIDPLACER_API FGridPlacerReplaceChange : public FCommandChange
+{
+public:
+	void AddRecord(uint32 Id, UObject* PreviousAsset, UObject* NewAsset);
+	int32 Num() const { return Records.Num(); }
+
+	/** FCommandChange interface */
+	virtual void Apply(UObject* Object) override;
+	virtual void Revert(UObject* Object) override;
+	virtual bool HasExpired(UObject* Object) const override;
+	virtual FString ToString() const override;
+
+protected:
+	struct FRecord
+	{
+		uint32 Id;
+		int32 PreviousAssetIndex;
+		int32 NewAssetIndex;
+	};
+
+	void ReplaceRecords(UObject* Object, bool UseNewAssets);
+
+	TArray<FRecord> Records;
+	TArray<TSoftObjectPtr<UObject>> Assets;
+};
+
+/**
+ * Undo record for turning placed static mesh actors into instances of consolidated components.
+ * Items keep their ids, so only the mesh, override materials, transform, chunk and custom data are stored per item.
+ * The actors themselves are restored by the transaction this change is part of.
+ */
+class GRIDPLACER_API FGridPlacerConsolidateChange : public FCommandChange
+{
+public:
+	void AddRecord(const FGridPlacerConsolidateRequest& Request);
+	int32 Num() const { return Records.Num(); }
+
+	/** FCommandChange interface */
+	virtual void Apply(UObject* Object) override;
+	virtual void Revert(UObject* Object) override;
+	virtual bool HasExpired(UObject* Object) const override;
+	virtual FString ToString() const override;
+
+protected:
+	struct FRecord
+	{
+		uint32 Id;
+		int32 MeshIndex;
+		/*Indices into Assets, INDEX_NONE keeps the mesh's material*/
+		TArray<int32> MaterialIndices;
+		FTransform Transform;
+		FIntPoint Chunk;
+		TArray<float> CustomData;
+	};
+
+	TArray<FGridPlacerConsolidateRequest> ResolveRequests() const;
+
+	TArray<FRecord> Records;
+	TArray<TSoftObjectPtr<UObject>> Assets;
+};
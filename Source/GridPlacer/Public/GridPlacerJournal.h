@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPath.h"
+
+/**
+ * Append-only binary log of placed, erased and replaced items, so a session lost to a crash can be placed again.
+ * Records are collected in a buffer that is written out once it fills up or FlushInterval seconds after the last write,
+ * a crash loses at most that much. Assets are written once as a path and referred to by their index afterwards.
+ * Every Open appends a new section to the file, item ids and asset indices only hold within their section.
+ */
+class FGridPlacerJournal
+{
+public:
+	/*An item that is alive at the end of a journal, or one that was erased*/
+	struct FEntry
+	{
+		/*Grid cell of the item's pivot, in the grid it was placed on. Not recorded for erased items*/
+		FIntVector Cell = FIntVector::ZeroValue;
+		FSoftObjectPath Asset;
+		FTransform Transform;
+		bool AsInstance = false;
+		TArray<float> CustomData;
+	};
+
+	static constexpr double FlushInterval = 1.0;
+
+	~FGridPlacerJournal() { Close(); }
+
+	/** Starts a new section at the end of Filename, the file itself is only created or touched once the first record is written */
+	void Open(const FString& InFilename);
+	/** Writes everything that is still buffered and stops recording */
+	void Close();
+	bool IsOpen() const { return !Filename.IsEmpty(); }
+	/** The file records go to, empty if the journal is closed */
+	const FString& GetFilename() const { return Filename; }
+
+	/** Records a new item, or a replace if the same item was erased right before, as replacing and moving items does */
+	void RecordPlace(uint32 Id, const UObject* Asset, const FIntVector& Cell, const FTransform& Transform, bool AsInstance, TArrayView<const float> CustomData);
+	/** Records an erase along with what was erased, so items that were saved in the level or placed in an earlier section can be found again */
+	void RecordErase(uint32 Id, const UObject* Asset, const FTransform& Transform, bool AsInstance);
+	/** Records that the level was saved, everything alive up to here is part of it now and isn't replayed anymore */
+	void RecordSave();
+	/** Writes the buffer if FlushInterval has passed since the last write */
+	void Tick();
+	void Flush();
+
+	/**
+	 * Replays every record of a journal and collects the items that are alive at its end and were placed after the level was last saved,
+	 * as well as the items erased since then that the journal didn't place itself, i.e. ones saved in the level or placed by another journal.
+	 * A record cut off by a crash ends the journal early. Returns false if the file isn't a journal.
+	 */
+	static bool Read(const FString& Filename, TArray<FEntry>& OutEntries, TArray<FEntry>& OutErased, int32& OutNumRecords);
+
+private:
+	enum class ERecord : uint8
+	{
+		Asset,
+		Place,
+		Erase,
+		Replace,
+		Section,
+		Save
+	};
+
+	template<typename T>
+	void Write(const T& Value)
+	{
+		Buffer.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+	}
+	/** Starts the section before its first record */
+	void BeginRecord();
+	/** Index of Asset within the section, its path is written the first time it shows up */
+	int32 WriteAsset(const UObject* Asset);
+	void WriteTransform(const FTransform& Transform);
+
+	FString Filename;
+	TUniquePtr<FArchive> Writer;
+	TArray<uint8> Buffer;
+	double LastFlushTime = 0.0;
+	TMap<FSoftObjectPath, int32> AssetIndices;
+	bool SectionStarted = false;
+	/*A place of the item erased by the last record is a replace*/
+	uint32 LastErased = 0;
+};
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_STATS_GROUP(TEXT("GridPlacer"), STATGROUP_GridPlacer, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Render"), STAT_GridPlacer_Render, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Grid Space"), STAT_GridPlacer_UpdateGridSpace, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Placement Point"), STAT_GridPlacer_UpdatePlacementPoint, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Snap Placement Point"), STAT_GridPlacer_SnapPlacementPointToGrid, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Palette Object"), STAT_GridPlacer_SpawnPaletteObject, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Realize Preview"), STAT_GridPlacer_RealizePreview, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Palette Rebuild"), STAT_GridPlacer_PaletteRebuild, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Place Batch"), STAT_GridPlacer_PlaceBatch, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Remove Batch"), STAT_GridPlacer_RemoveBatch, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Replace Batch"), STAT_GridPlacer_ReplaceBatch, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Project To Surface"), STAT_GridPlacer_ProjectToSurface, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Path Preview"), STAT_GridPlacer_PathPreview, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Copy Region"), STAT_GridPlacer_CopyRegion, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Queue"), STAT_GridPlacer_SpawnQueue, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Consolidate"), STAT_GridPlacer_Consolidate, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Merge Chunks"), STAT_GridPlacer_MergeChunks, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hidden Cells"), STAT_GridPlacer_HiddenCells, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Socket Snap"), STAT_GridPlacer_SocketSnap, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate"), STAT_GridPlacer_Generate, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Import Image"), STAT_GridPlacer_ImportImage, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Replay Journal"), STAT_GridPlacer_ReplayJournal, STATGROUP_GridPlacer, GRIDPLACER_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Spawns"), STAT_GridPlacer_Spawns, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Spawns/sec"), STAT_GridPlacer_SpawnsPerSecond, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_GridPlacer_Traces, STATGROUP_GridPlacer, GRIDPLACER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Preview Updates"), STAT_GridPlacer_PreviewUpdates, STATGROUP_GridPlacer, GRIDPLACER_API);
+
+LLM_DECLARE_TAG_API(GridPlacer, GRIDPLACER_API);
+
+/*Cycle counter for stat GridPlacer plus a CPU scope of the same name for Unreal Insights*/
+#define GRIDPLACER_SCOPE(StatName) \
+	SCOPE_CYCLE_COUNTER(STAT_GridPlacer_##StatName); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(GridPlacer_##StatName)
+
+namespace GridPlacerStats
+{
+	GRIDPLACER_API void RecordSpawns(int32 NumSpawns);
+	GRIDPLACER_API void RecordTrace(int32 NumTraces = 1);
+	GRIDPLACER_API void RecordPreviewUpdate();
+
+	/** Starts and stops publishing the per frame counters, called by the module */
+	void Startup();
+	void Shutdown();
+}
@@ -0,0 +1,314 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GridPlacerSpatialHash.h"
+#include "Misc/Change.h"
+#include "Containers/Ticker.h"
+#include "EditorUndoClient.h"
+#include "GridPlacerChanges.h"
+#include "GridPlacerJournal.h"
+#include "GridPlacerOccupancy.h"
+#include "GridPlacerSubsystem.generated.h"
+
+class UStaticMesh;
+class UMaterialInterface;
+class SNotificationItem;
+class UInstancedStaticMeshComponent;
+class UGridPlacerCellData;
+class FObjectPostSaveContext;
+
+/**
+ * Describes a single object GridPlacer should put into the world
+ */
+struct FGridPlacerSpawnRequest
+{
+	/*Either a UStaticMesh or an actor UClass*/
+	UObject* Asset = nullptr;
+	FTransform Transform;
+	/*Static meshes only: add an instance to the shared instance host instead of spawning an actor*/
+	bool AsInstance = false;
+	/*Instances only: the component to add the instance to, e.g. a consolidated one. Null uses the shared component of the mesh*/
+	TWeakObjectPtr<UInstancedStaticMeshComponent> Component;
+	/*Per instance custom data, or custom primitive data of every primitive component of an actor, starting at index 0.
+	 NaN entries leave their float alone: actors keep their own default there, instances keep their current value*/
+	TArray<float> CustomData;
+};
+
+/**
+ * Swaps the asset of a placed item for another one
+ */
+struct FGridPlacerReplaceRequest
+{
+	uint32 Id = 0;
+	/*Either a UStaticMesh or an actor UClass*/
+	UObject* Asset = nullptr;
+};
+
+/**
+ * A single object GridPlacer has put into the world.
+ * Actors and instances are addressed by the same Id so undo records and queries don't have to care which one it is.
+ */
+struct FGridPlacerPlacedItem
+{
+	uint32 Id = 0;
+	TWeakObjectPtr<UObject> Asset;
+	TWeakObjectPtr<AActor> Actor;
+	TWeakObjectPtr<UInstancedStaticMeshComponent> Component;
+	int32 InstanceIndex = INDEX_NONE;
+	FTransform Transform;
+
+	bool IsInstance() const { return InstanceIndex != INDEX_NONE; }
+	bool IsValid() const { return IsInstance() ? Component.IsValid() : Actor.IsValid(); }
+};
+
+/**
+ * A placed static mesh that moves between a plain actor and an instance of a consolidated component
+ */
+struct FGridPlacerConsolidateRequest
+{
+	uint32 Id = 0;
+	UStaticMesh* Mesh = nullptr;
+	/*Override materials of the actor, null entries use the mesh's material*/
+	TArray<UMaterialInterface*> Materials;
+	FTransform Transform;
+	/*Consolidated components cover one chunk of cells each*/
+	FIntPoint Chunk = FIntPoint::ZeroValue;
+	/*Custom primitive data of the actor, becomes the custom data of its instance*/
+	TArray<float> CustomData;
+};
+
+/**
+ * Estimated cost of the actors and components touched by a consolidation
+ */
+struct FGridPlacerConsolidateStats
+{
+	int32 NumActors = 0;
+	int32 NumComponents = 0;
+	/*Sections of LOD 0 that are drawn on their own, instances of a component share theirs*/
+	int32 NumDrawCalls = 0;
+	SIZE_T MemoryBytes = 0;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGridPlacerItemChanged, const FGridPlacerPlacedItem&)
+
+/**
+ * Keeps track of everything GridPlacer has placed in a world and owns the batched placement path.
+ * Every mutation records a delta undo step (FGridPlacerPlacementChange) that only contains the touched items,
+ * so neither the level's actor list nor a component's whole instance array ends up in the transaction buffer.
+ */
+UCLASS()
+class GRIDPLACER_API UGridPlacerSubsystem : public UWorldSubsystem, public FEditorUndoClient
+{
+	GENERATED_BODY()
+
+public:
+	static const FName PlacedActorTag;
+	static const FName InstanceHostTag;
+	/*Component tag of instance components made by ConsolidateActors, new placements never go into them*/
+	static const FName ConsolidatedComponentTag;
+
+	/** USubsystem interface */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Places all requests and records them as a single undo step. Returns the ids of the new items. */
+	TArray<uint32> PlaceBatch(TArrayView<const FGridPlacerSpawnRequest> Requests, const FText& Description);
+	/**
+	 * Queues requests and places them over the next frames, spending at most BudgetMs per frame, so huge batches don't freeze the editor.
+	 * Requests closest to PriorityLocation go first. The whole batch becomes a single undo step once it is done,
+	 * cancelling it removes everything it placed so far.
+	 */
+	void PlaceBatchTimeSliced(TArray<FGridPlacerSpawnRequest>&& Requests, const FText& Description, const FVector& PriorityLocation, float BudgetMs);
+	/**
+	 * Like PlaceBatchTimeSliced for batches too big to build up front: whenever the requests Refill handed out are placed, it is asked for the next ones,
+	 * until it returns false. Sources are kept alive until then, so Refill may read from them. The requests are placed in the order they come.
+	 */
+	void PlaceStreamTimeSliced(TUniqueFunction<bool(TArray<FGridPlacerSpawnRequest>&)>&& Refill, TArrayView<UObject* const> Sources, const FText& Description, float BudgetMs);
+	/** Stops all queued batches and removes what they placed so far */
+	void CancelQueuedPlacements();
+	bool HasQueuedPlacements() const { return SpawnJobs.Num() > 0; }
+	/** Removes all items and records them as a single undo step */
+	void RemoveBatch(TArrayView<const uint32> Ids, const FText& Description);
+	/** Swaps the assets of placed items, keeping their ids and transforms, and records it as a single undo step. Returns how many items changed. */
+	int32 ReplaceBatch(TArrayView<const FGridPlacerReplaceRequest> Requests, const FText& Description);
+
+	/**
+	 * Replaces plain static mesh actors using one of Meshes by instances and records it as a single undo step.
+	 * Actors are grouped into one instance component per mesh, material overrides and chunk of ChunkSize x ChunkSize cells of Frame.
+	 * Only actors whose pivot lies in Region are touched if it is valid. Actors GridPlacer didn't place are adopted.
+	 * The actors are destroyed within the transaction, so undoing it brings them back as they were, with label, folder, tags and component settings.
+	 * Returns the number of consolidated actors.
+	 */
+	int32 ConsolidateActors(TArrayView<UStaticMesh* const> Meshes, const FGridPlacerFrame& Frame, const FGridPlacerCellBox& Region, int32 ChunkSize,
+		const FText& Description, FGridPlacerConsolidateStats& OutBefore, FGridPlacerConsolidateStats& OutAfter);
+
+	/** Spawns a single item without touching the undo buffer. A non-zero ForcedId re-registers a previously removed item. */
+	uint32 SpawnItem(const FGridPlacerSpawnRequest& Request, uint32 ForcedId = 0);
+	/** Removes a single item without touching the undo buffer. OutRequest receives what is needed to spawn it again. */
+	bool RemoveItem(uint32 Id, FGridPlacerSpawnRequest* OutRequest = nullptr);
+	/** Swaps assets without touching the undo buffer. OutPrevious receives the assets the changed items had before. */
+	int32 ReplaceItems(TArrayView<const FGridPlacerReplaceRequest> Requests, TArray<FGridPlacerReplaceRequest>* OutPrevious = nullptr);
+	/**
+	 * Turns placed static mesh actors into instances of consolidated components. Ids are kept.
+	 * Actors that still exist are destroyed through the current transaction, if any, the instances never touch the undo buffer.
+	 */
+	int32 ConsolidateItems(TArrayView<const FGridPlacerConsolidateRequest> Requests);
+	/** Removes consolidated instances again without touching the undo buffer, the transaction that destroyed their actors brings those back under the same ids */
+	int32 ExpandItems(TArrayView<const FGridPlacerConsolidateRequest> Requests);
+	/**
+	 * Hides or shows items without touching the undo buffer. Instances get 1 or 0 in their custom data float CustomDataIndex,
+	 * their material has to mask them based on it. Actors are hidden in game and lose their collision.
+	 */
+	void SetItemsHidden(TArrayView<const uint32> Ids, bool Hidden, int32 CustomDataIndex);
+
+	const FGridPlacerPlacedItem* FindItem(uint32 Id);
+	uint32 FindItemId(AActor* Actor);
+	uint32 FindItemId(UInstancedStaticMeshComponent* Component, int32 InstanceIndex);
+	const TMap<uint32, FGridPlacerPlacedItem>& GetItems();
+	/** Appends the ids of all items whose world bounds intersect WorldBounds */
+	void QueryItems(const FBox& WorldBounds, TArray<uint32>& OutIds);
+
+	/** Custom data of an instance or the custom primitive data of an actor */
+	TArray<float> GetItemCustomData(const FGridPlacerPlacedItem& Item) const;
+
+	/** Local bounds of a placeable asset (static mesh or actor class), cached per asset */
+	FBox GetAssetBounds(UObject* Asset);
+	/** World bounds of a placed item, or a point at its location if the asset has no bounds */
+	FBox GetItemBounds(const FGridPlacerPlacedItem& Item);
+
+	/**
+	 * Bakes every placed item into Target as seen from the grid Frame. Returns the number of occupied cells.
+	 * Only the first 32 distinct tags fit in a cell, OutDroppedTags receives the ones left out.
+	 */
+	int32 BakeCellData(const FGridPlacerFrame& Frame, UGridPlacerCellData* Target, TArray<FName>* OutDroppedTags = nullptr);
+
+	/**
+	 * Starts appending every place, erase and replace of this world to the journal of the level, or moves recording to a new Frame.
+	 * Recording goes on until StopJournal, whoever makes the change. Cells are recorded in Frame.
+	 * Each editor session writes one journal per level, a level loaded again in the same session appends to it.
+	 */
+	void StartJournal(const FGridPlacerFrame& Frame);
+	void StopJournal();
+	bool IsRecordingJournal() const { return Journal.IsOpen(); }
+	/** Writes everything recorded so far, so reading the journal sees all of it */
+	void FlushJournal() { Journal.Flush(); }
+	static FString GetJournalDirectory();
+	/** Journals of this level written to since it was last saved, oldest first. Unsaved levels get all of their journals. */
+	TArray<FString> FindUnsavedJournals() const;
+
+	/** UObject interface */
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	/** FEditorUndoClient interface */
+	virtual bool MatchesContext(const FTransactionContext& InContext, const TArray<TPair<UObject*, FTransactionObjectEvent>>& TransactionObjectContexts) const override;
+	virtual void PostUndo(bool bSuccess) override;
+	virtual void PostRedo(bool bSuccess) override;
+
+	/*Fired whenever an item is registered or unregistered, including undo/redo and manual edits of placed actors*/
+	FOnGridPlacerItemChanged OnItemAdded;
+	FOnGridPlacerItemChanged OnItemRemoved;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void EnsureRegistry();
+	/** Registers a tagged actor, or the instances of an instance host, that isn't tracked yet */
+	void RegisterExistingActor(AActor* Actor);
+	/** Drops items of the actors and components an undo or redo touched that are gone and registers tagged content that came back, e.g. through undoing a manual delete */
+	void SyncRegistry();
+	/** Spawns requests without touching the undo buffer and records them in Change. Instances of the same mesh are added with a single AddInstances call. */
+	void SpawnRequests(TArrayView<const FGridPlacerSpawnRequest> Requests, FGridPlacerPlacementChange& Change, TArray<uint32>& OutIds);
+	void StoreChange(TUniquePtr<FCommandChange> Change, const FText& Description);
+	uint32 RegisterActor(AActor* Actor, UObject* Asset, uint32 ForcedId);
+	uint32 RegisterInstance(UInstancedStaticMeshComponent* Component, int32 InstanceIndex, uint32 ForcedId);
+	void UnregisterItem(uint32 Id);
+	uint32 AllocateId(uint32 ForcedId);
+
+	AActor* FindOrCreateInstanceHost();
+	UInstancedStaticMeshComponent* FindOrCreateInstanceComponent(UStaticMesh* StaticMesh);
+	/** The component a spawn request adds its instance to */
+	UInstancedStaticMeshComponent* GetRequestComponent(const FGridPlacerSpawnRequest& Request);
+	/** Consolidated component of a mesh, material set and chunk. Only creates it if Create is set, otherwise returns null if there is none yet. */
+	UInstancedStaticMeshComponent* FindConsolidatedComponent(UStaticMesh* Mesh, TArrayView<UMaterialInterface* const> Materials, const FIntPoint& Chunk, bool Create);
+	void RemoveInstanceAtSwap(UInstancedStaticMeshComponent* Component, int32 InstanceIndex);
+	/** Grows the custom data of every instance to at least NumFloats, keeping the existing values */
+	void EnsureCustomDataFloats(UInstancedStaticMeshComponent* Component, int32 NumFloats);
+	/*An instance that keeps its item id and custom data while it moves to another component*/
+	struct FPendingInstance
+	{
+		uint32 Id;
+		FTransform Transform;
+		TArray<float> CustomData;
+	};
+	/** Appends instances to Component with a single AddInstances call and registers them under the given ids */
+	void AddInstancesWithIds(UInstancedStaticMeshComponent* Component, TArrayView<const FPendingInstance> Instances);
+	/** Writes CustomData to an instance, growing the custom data of the component if needed. The caller marks the render state dirty. */
+	void SetInstanceCustomData(UInstancedStaticMeshComponent* Component, int32 InstanceIndex, TArrayView<const float> CustomData);
+
+	void OnLevelActorAdded(AActor* Actor);
+	void OnLevelActorDeleted(AActor* Actor);
+	void OnActorMoved(AActor* Actor);
+
+	bool RegistryBuilt = false;
+	uint32 NextItemId = 1;
+	TMap<uint32, FGridPlacerPlacedItem> Items;
+	TMap<TWeakObjectPtr<AActor>, uint32> ActorIds;
+	/*Item ids of every instance, indexed like the component's instances*/
+	TMap<TWeakObjectPtr<UInstancedStaticMeshComponent>, TArray<uint32>> InstanceIds;
+	/*Ids of content deleted by hand, handed out again when an undo brings it back so older undo steps still find it*/
+	TMap<TWeakObjectPtr<AActor>, uint32> DeletedActorIds;
+	TMap<TWeakObjectPtr<UInstancedStaticMeshComponent>, TArray<uint32>> DeletedInstanceIds;
+	TMap<TWeakObjectPtr<UStaticMesh>, TWeakObjectPtr<UInstancedStaticMeshComponent>> InstanceComponents;
+	TWeakObjectPtr<AActor> InstanceHost;
+	/*Actors and instance components of the world the transaction being undone or redone touched, collected by MatchesContext which is const*/
+	mutable TSet<TWeakObjectPtr<AActor>> UndoActors;
+	mutable TSet<TWeakObjectPtr<UInstancedStaticMeshComponent>> UndoComponents;
+	TMap<TWeakObjectPtr<UObject>, FBox> AssetBounds;
+	FGridPlacerSpatialHash SpatialIndex;
+
+	/*A time sliced batch, placed front to back*/
+	struct FSpawnJob
+	{
+		TArray<FGridPlacerSpawnRequest> Requests;
+		int32 NumProcessed = 0;
+		float BudgetMs = 0.0f;
+		FText Description;
+		TUniquePtr<FGridPlacerPlacementChange> Change;
+		TArray<uint32> Ids;
+		/*Every asset of the requests once, kept alive until the job is done*/
+		TArray<TObjectPtr<UObject>> Assets;
+		/*Streamed jobs only: hands out the next requests, reset once it has nothing more*/
+		TUniqueFunction<bool(TArray<FGridPlacerSpawnRequest>&)> Refill;
+		TArray<TObjectPtr<UObject>> Sources;
+		/*Streamed jobs only: requests of earlier refills*/
+		int32 NumRefilled = 0;
+	};
+	FSpawnJob& AddSpawnJob(const FText& Description, float BudgetMs);
+	bool TickSpawnQueue(float DeltaTime);
+	void UpdateSpawnNotification();
+	TArray<FSpawnJob> SpawnJobs;
+	FTSTicker::FDelegateHandle SpawnTickerHandle;
+	TWeakPtr<SNotificationItem> SpawnNotification;
+
+	/** Journal of the level in this editor session */
+	FString GetJournalFilename() const;
+	bool TickJournal(float DeltaTime);
+	void OnJournalItemAdded(const FGridPlacerPlacedItem& Item);
+	void OnJournalItemRemoved(const FGridPlacerPlacedItem& Item);
+	void OnPostSaveWorld(UWorld* World, FObjectPostSaveContext Context);
+	/*Every change of the placed items while recording*/
+	FGridPlacerJournal Journal;
+	FGridPlacerFrame JournalFrame;
+	FTSTicker::FDelegateHandle JournalTickerHandle;
+	FDelegateHandle JournalItemAddedHandle;
+	FDelegateHandle JournalItemRemovedHandle;
+	FDelegateHandle PostSaveWorldHandle;
+
+	FDelegateHandle LevelActorAddedHandle;
+	FDelegateHandle LevelActorDeletedHandle;
+	FDelegateHandle ActorMovedHandle;
+	bool IsMutating = false;
+};
@@ -33,6 +33,8 @@ private:
 	void OnAssetsDropped(const FDragDropEvent& DragDropEvent, TArrayView<FAssetData> DraggedAssets);
 	void OnPaletteChanged(TSharedPtr<IPropertyHandle> Handle, TSharedPtr<IPropertyUtilities> Utils);
 	struct FObjectPalette* GetData();
+	/** Details view showing only the variation of PaletteObject */
+	static TSharedRef<class SWidget> MakeVariationDetailsView(class UPaletteObject* PaletteObject);
 private:
 	TSharedPtr<IPropertyHandle> PropertyHandle;
 	TSharedPtr<class FAssetThumbnailPool> ThumbnailPool;
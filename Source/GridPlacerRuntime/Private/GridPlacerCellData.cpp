@@ -0,0 +1,255 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerCellData.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#pragma region Chunk
+void FGridPlacerCellChunk::Init()
+{
+	PaletteIds.Init(InvalidPaletteId, NumCells);
+	TagMasks.Init(0, NumCells);
+	Heights.Init(0.0f, NumCells);
+	Flags.Init(0, NumCells);
+}
+
+void FGridPlacerCellChunk::Reset()
+{
+	PaletteIds.Empty();
+	TagMasks.Empty();
+	Heights.Empty();
+	Flags.Empty();
+}
+
+void FGridPlacerCellChunk::Serialize(FArchive& Ar)
+{
+	PaletteIds.BulkSerialize(Ar);
+	TagMasks.BulkSerialize(Ar);
+	Heights.BulkSerialize(Ar);
+	Flags.BulkSerialize(Ar);
+	if(Ar.IsLoading() && (PaletteIds.Num() != NumCells || TagMasks.Num() != NumCells || Heights.Num() != NumCells || Flags.Num() != NumCells))
+		Reset();
+}
+#pragma endregion
+
+#pragma region Serialization
+void UGridPlacerCellData::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	int32 NumPayloads = ChunkBulkData.Num();
+	Ar << NumPayloads;
+	if(Ar.IsLoading())
+	{
+		ChunkBulkData.Empty(NumPayloads);
+		for(int32 i = 0; i < NumPayloads; ++i)
+			ChunkBulkData.Add(new FByteBulkData());
+		LoadedChunks.Reset();
+		LoadedChunks.SetNum(NumPayloads);
+		ResidentChunks.Reset();
+	}
+	for(int32 i = 0; i < NumPayloads; ++i)
+		ChunkBulkData[i].Serialize(Ar, this, i);
+}
+
+#if WITH_EDITOR
+void UGridPlacerCellData::SetBakedData(const FGridPlacerFrame& Frame, TArray<TSoftObjectPtr<UObject>>&& InPalette, TArray<FName>&& InTags, TMap<FIntPoint, FGridPlacerCellChunk>&& Chunks)
+{
+	GridToWorld = Frame.GridToWorld;
+	CellSize = Frame.CellSize;
+	Palette = MoveTemp(InPalette);
+	Tags = MoveTemp(InTags);
+
+	FIntPoint Min(MAX_int32, MAX_int32);
+	FIntPoint Max(MIN_int32, MIN_int32);
+	for(const TPair<FIntPoint, FGridPlacerCellChunk>& Pair : Chunks)
+	{
+		Min = Min.ComponentMin(Pair.Key);
+		Max = Max.ComponentMax(Pair.Key);
+	}
+	ChunkMin = Chunks.Num() > 0 ? Min : FIntPoint::ZeroValue;
+	NumChunks = Chunks.Num() > 0 ? Max - Min + FIntPoint(1, 1) : FIntPoint::ZeroValue;
+	ChunkIndices.Init(INDEX_NONE, NumChunks.X * NumChunks.Y);
+
+	ChunkBulkData.Empty(Chunks.Num());
+	LoadedChunks.Reset(Chunks.Num());
+	ResidentChunks.Reset(Chunks.Num());
+	TArray<uint8> Bytes;
+	for(TPair<FIntPoint, FGridPlacerCellChunk>& Pair : Chunks)
+	{
+		const FIntPoint Local = Pair.Key - ChunkMin;
+		ChunkIndices[Local.Y * NumChunks.X + Local.X] = ChunkBulkData.Num();
+
+		Bytes.Reset();
+		FMemoryWriter Writer(Bytes);
+		Pair.Value.Serialize(Writer);
+		FByteBulkData* BulkData = new FByteBulkData();
+		//Every chunk goes into the .ubulk file so it can be streamed on its own
+		BulkData->SetBulkDataFlags(BULKDATA_Force_NOT_InlinePayload);
+		BulkData->Lock(LOCK_READ_WRITE);
+		FMemory::Memcpy(BulkData->Realloc(Bytes.Num()), Bytes.GetData(), Bytes.Num());
+		BulkData->Unlock();
+		ChunkBulkData.Add(BulkData);
+
+		//Freshly baked data stays resident, it is what the editor just looked at anyway
+		LoadedChunks.Add(MoveTemp(Pair.Value));
+		ResidentChunks.Add(Pair.Key);
+	}
+}
+#endif
+#pragma endregion
+
+#pragma region Lookup
+FIntPoint UGridPlacerCellData::WorldToCell(const FVector& WorldPosition) const
+{
+	const FVector GridPosition = GridToWorld.InverseTransformPosition(WorldPosition);
+	return FIntPoint(FMath::FloorToInt32(GridPosition.X / CellSize.X), FMath::FloorToInt32(GridPosition.Y / CellSize.Y));
+}
+
+FVector UGridPlacerCellData::CellToWorld(const FIntPoint& Cell) const
+{
+	return GridToWorld.TransformPosition(FVector((Cell.X + 0.5) * CellSize.X, (Cell.Y + 0.5) * CellSize.Y, 0.0));
+}
+
+int32 UGridPlacerCellData::FindChunkIndex(const FIntPoint& ChunkCoord) const
+{
+	const FIntPoint Local = ChunkCoord - ChunkMin;
+	if(Local.X < 0 || Local.Y < 0 || Local.X >= NumChunks.X || Local.Y >= NumChunks.Y)
+		return INDEX_NONE;
+	return ChunkIndices[Local.Y * NumChunks.X + Local.X];
+}
+
+const FGridPlacerCellChunk* UGridPlacerCellData::FindLoadedChunk(const FIntPoint& Cell) const
+{
+	const int32 Index = FindChunkIndex(FGridPlacerCellChunk::GetChunkCoord(Cell));
+	if(Index == INDEX_NONE || !LoadedChunks[Index].IsLoaded())
+		return nullptr;
+	return &LoadedChunks[Index];
+}
+
+uint16 UGridPlacerCellData::GetPaletteId(const FIntPoint& Cell) const
+{
+	const FGridPlacerCellChunk* Chunk = FindLoadedChunk(Cell);
+	return Chunk ? Chunk->PaletteIds[FGridPlacerCellChunk::GetLocalIndex(Cell)] : FGridPlacerCellChunk::InvalidPaletteId;
+}
+
+uint32 UGridPlacerCellData::GetTagMask(const FIntPoint& Cell) const
+{
+	const FGridPlacerCellChunk* Chunk = FindLoadedChunk(Cell);
+	return Chunk ? Chunk->TagMasks[FGridPlacerCellChunk::GetLocalIndex(Cell)] : 0;
+}
+
+float UGridPlacerCellData::GetHeight(const FIntPoint& Cell) const
+{
+	const FGridPlacerCellChunk* Chunk = FindLoadedChunk(Cell);
+	return Chunk ? Chunk->Heights[FGridPlacerCellChunk::GetLocalIndex(Cell)] : 0.0f;
+}
+
+EGridPlacerCellFlags UGridPlacerCellData::GetFlags(const FIntPoint& Cell) const
+{
+	const FGridPlacerCellChunk* Chunk = FindLoadedChunk(Cell);
+	return Chunk ? static_cast<EGridPlacerCellFlags>(Chunk->Flags[FGridPlacerCellChunk::GetLocalIndex(Cell)]) : EGridPlacerCellFlags::None;
+}
+
+bool UGridPlacerCellData::GetCell(const FIntPoint& Cell, FGridPlacerCell& OutCell) const
+{
+	OutCell = FGridPlacerCell();
+	const FGridPlacerCellChunk* Chunk = FindLoadedChunk(Cell);
+	if(!Chunk)
+		return false;
+	const int32 LocalIndex = FGridPlacerCellChunk::GetLocalIndex(Cell);
+	if(!(Chunk->Flags[LocalIndex] & static_cast<uint8>(EGridPlacerCellFlags::Occupied)))
+		return false;
+	const uint16 PaletteId = Chunk->PaletteIds[LocalIndex];
+	OutCell.PaletteIndex = PaletteId == FGridPlacerCellChunk::InvalidPaletteId ? INDEX_NONE : PaletteId;
+	OutCell.TagMask = static_cast<int32>(Chunk->TagMasks[LocalIndex]);
+	OutCell.Height = Chunk->Heights[LocalIndex];
+	OutCell.Flags = Chunk->Flags[LocalIndex];
+	return true;
+}
+
+bool UGridPlacerCellData::CellHasTag(const FIntPoint& Cell, FName Tag) const
+{
+	const int32 TagIndex = Tags.IndexOfByKey(Tag);
+	return TagIndex != INDEX_NONE && (GetTagMask(Cell) & (1u << TagIndex)) != 0;
+}
+#pragma endregion
+
+#pragma region Streaming
+bool UGridPlacerCellData::LoadChunk(const FIntPoint& ChunkCoord)
+{
+	const int32 Index = FindChunkIndex(ChunkCoord);
+	if(Index == INDEX_NONE)
+		return false;
+	FGridPlacerCellChunk& Chunk = LoadedChunks[Index];
+	if(Chunk.IsLoaded())
+		return true;
+
+	FByteBulkData& BulkData = ChunkBulkData[Index];
+	const int64 Size = BulkData.GetBulkDataSize();
+	void* Data = nullptr;
+	//The editor keeps its copy so the asset can still be saved
+	BulkData.GetCopy(&Data, !GIsEditor);
+	if(!Data)
+		return false;
+	FMemoryReaderView Reader(TArrayView<const uint8>(static_cast<const uint8*>(Data), Size));
+	Chunk.Serialize(Reader);
+	FMemory::Free(Data);
+	if(!Chunk.IsLoaded())
+		return false;
+	ResidentChunks.Add(ChunkCoord);
+	return true;
+}
+
+void UGridPlacerCellData::UnloadChunk(const FIntPoint& ChunkCoord)
+{
+	const int32 Index = FindChunkIndex(ChunkCoord);
+	if(Index == INDEX_NONE || !LoadedChunks[Index].IsLoaded())
+		return;
+	LoadedChunks[Index].Reset();
+	ResidentChunks.RemoveSwap(ChunkCoord);
+}
+
+bool UGridPlacerCellData::IsChunkLoaded(const FIntPoint& ChunkCoord) const
+{
+	const int32 Index = FindChunkIndex(ChunkCoord);
+	return Index != INDEX_NONE && LoadedChunks[Index].IsLoaded();
+}
+
+void UGridPlacerCellData::StreamAround(const FVector& WorldPosition, float Radius)
+{
+	const FVector Center = GridToWorld.InverseTransformPosition(WorldPosition);
+	const FVector ChunkExtent = CellSize * FGridPlacerCellChunk::ChunkSize;
+	const FIntPoint Min(FMath::FloorToInt32((Center.X - Radius) / ChunkExtent.X), FMath::FloorToInt32((Center.Y - Radius) / ChunkExtent.Y));
+	const FIntPoint Max(FMath::FloorToInt32((Center.X + Radius) / ChunkExtent.X), FMath::FloorToInt32((Center.Y + Radius) / ChunkExtent.Y));
+
+	//Only resident chunks can need unloading. Backwards, since unloading swaps the last one into its place.
+	for(int32 i = ResidentChunks.Num() - 1; i >= 0; --i)
+	{
+		const FIntPoint ChunkCoord = ResidentChunks[i];
+		if(ChunkCoord.X < Min.X || ChunkCoord.X > Max.X || ChunkCoord.Y < Min.Y || ChunkCoord.Y > Max.Y)
+			UnloadChunk(ChunkCoord);
+	}
+
+	//Clamped to the baked range, so a huge radius can't turn into a huge loop
+	const FIntPoint LoadMin = Min.ComponentMax(ChunkMin) - ChunkMin;
+	const FIntPoint LoadMax = Max.ComponentMin(ChunkMin + NumChunks - FIntPoint(1, 1)) - ChunkMin;
+	for(int32 Y = LoadMin.Y; Y <= LoadMax.Y; ++Y)
+	{
+		for(int32 X = LoadMin.X; X <= LoadMax.X; ++X)
+		{
+			const int32 Index = ChunkIndices[Y * NumChunks.X + X];
+			if(Index != INDEX_NONE && !LoadedChunks[Index].IsLoaded())
+				LoadChunk(ChunkMin + FIntPoint(X, Y));
+		}
+	}
+}
+
+void UGridPlacerCellData::LoadAllChunks()
+{
+	for(int32 Y = 0; Y < NumChunks.Y; ++Y)
+		for(int32 X = 0; X < NumChunks.X; ++X)
+			LoadChunk(ChunkMin + FIntPoint(X, Y));
+}
+#pragma endregion
@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerGridComponent.h"
+#include "GridPlacerGridMathConversions.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+static_assert(static_cast<uint8>(ESnappingMode::None) == static_cast<uint8>(GridPlacerMath::ESnapMode::None), "ESnappingMode and GridPlacerMath::ESnapMode have to match");
+
+UGridPlacerGridComponent::UGridPlacerGridComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	//Only ticks while placements are queued
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+#pragma region Queries
+FGridPlacerFrame UGridPlacerGridComponent::GetFrame() const
+{
+	FGridPlacerFrame Frame;
+	Frame.GridToWorld = FTransform(GetComponentQuat(), GetComponentLocation());
+	Frame.CellSize = CellSize;
+	return Frame;
+}
+
+FIntVector UGridPlacerGridComponent::WorldToCell(const FVector& WorldPosition) const
+{
+	return GetFrame().WorldToCell(WorldPosition);
+}
+
+FVector UGridPlacerGridComponent::CellToWorld(const FIntVector& Cell) const
+{
+	const FVector GridPosition((Cell.X + 0.5) * CellSize.X, (Cell.Y + 0.5) * CellSize.Y, Cell.Z * CellSize.Z);
+	return GetComponentLocation() + GetComponentQuat().RotateVector(GridPosition);
+}
+
+FVector UGridPlacerGridComponent::SnapToGrid(const FVector& WorldPosition, ESnappingMode SnappingMode) const
+{
+	using namespace GridPlacerMath;
+	const FGridSpace GridSpace{ToGridVector(GetComponentLocation()), ToGridRotation(GetComponentQuat())};
+	const FGridVector Snapped = Snap(GridSpace.WorldToGrid(ToGridVector(WorldPosition)), CellSize.X, CellSize.Y, static_cast<ESnapMode>(SnappingMode));
+	return ToFVector(GridSpace.GridToWorld(Snapped));
+}
+
+bool UGridPlacerGridComponent::IsCellOccupied(const FIntVector& Cell) const
+{
+	return Occupancy.IsOccupied(Cell);
+}
+
+bool UGridPlacerGridComponent::CanPlace(const UStaticMesh* Mesh, const FTransform& Transform) const
+{
+	if(!Mesh)
+		return false;
+	return !Occupancy.Overlaps(GetFrame().GetFootprint(Mesh->GetBoundingBox(), Transform));
+}
+#pragma endregion
+
+#pragma region Placement
+bool UGridPlacerGridComponent::QueuePlacement(UStaticMesh* Mesh, const FTransform& Transform)
+{
+	if(!Mesh)
+		return false;
+	const FGridPlacerCellBox Footprint = GetFrame().GetFootprint(Mesh->GetBoundingBox(), Transform);
+	if(PreventOverlaps && Occupancy.Overlaps(Footprint))
+		return false;
+
+	Occupancy.Add(Footprint);
+	FPendingPlacement& Placement = PendingPlacements.AddDefaulted_GetRef();
+	Placement.MeshIndex = FindOrAddMesh(Mesh);
+	Placement.Transform = Transform;
+	Placement.Footprint = Footprint;
+	SetComponentTickEnabled(true);
+	return true;
+}
+
+bool UGridPlacerGridComponent::RemoveAt(const FIntVector& Cell)
+{
+	//The cell may belong to a placement that has not been instanced yet
+	if(GetNumPendingPlacements() > 0)
+		FlushPlacements();
+
+	const FInstanceRef* Owner = CellOwners.Find(Cell);
+	if(!Owner)
+		return false;
+	const int32 MeshIndex = Owner->MeshIndex;
+	const int32 InstanceIndex = Owner->InstanceIndex;
+	UInstancedStaticMeshComponent* Component = InstanceComponents[MeshIndex];
+	TArray<FGridPlacerCellBox>& Footprints = MeshInstances[MeshIndex].Footprints;
+
+	const FGridPlacerCellBox Footprint = Footprints[InstanceIndex];
+	Occupancy.Remove(Footprint);
+	ReplaceCellOwner(Footprint, {MeshIndex, InstanceIndex}, FInstanceRef());
+
+	const int32 LastIndex = Footprints.Num() - 1;
+	if(InstanceIndex != LastIndex)
+	{
+		//Move the last instance into the gap so only the last slot has to go and no other index changes
+		FTransform LastTransform;
+		Component->GetInstanceTransform(LastIndex, LastTransform, true);
+		Component->UpdateInstanceTransform(InstanceIndex, LastTransform, true, true, true);
+		Footprints[InstanceIndex] = Footprints[LastIndex];
+		ReplaceCellOwner(Footprints[InstanceIndex], {MeshIndex, LastIndex}, {MeshIndex, InstanceIndex});
+	}
+	Component->RemoveInstance(LastIndex);
+	Footprints.Pop(false);
+	return true;
+}
+
+void UGridPlacerGridComponent::FlushPlacements()
+{
+	FlushPendingPlacements(MAX_int32);
+}
+
+void UGridPlacerGridComponent::FlushPendingPlacements(int32 MaxPlacements)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(GridPlacer_FlushPlacements);
+	const int32 First = NumFlushedPlacements;
+	const int32 Last = First + FMath::Min(MaxPlacements, PendingPlacements.Num() - First);
+
+	//Group by mesh so every component receives a single AddInstances call
+	for(int32 i = First; i < Last; ++i)
+	{
+		const FPendingPlacement& Placement = PendingPlacements[i];
+		MeshInstances[Placement.MeshIndex].ScratchTransforms.Add(Placement.Transform);
+	}
+	for(int32 MeshIndex = 0; MeshIndex < MeshInstances.Num(); ++MeshIndex)
+	{
+		FMeshInstances& Instances = MeshInstances[MeshIndex];
+		if(Instances.ScratchTransforms.Num() == 0)
+			continue;
+		InstanceComponents[MeshIndex]->AddInstances(Instances.ScratchTransforms, false, true);
+		Instances.ScratchTransforms.Reset();
+	}
+	//Instances were appended in queue order per mesh, so footprints and cell owners follow the same order
+	for(int32 i = First; i < Last; ++i)
+	{
+		const FPendingPlacement& Placement = PendingPlacements[i];
+		TArray<FGridPlacerCellBox>& Footprints = MeshInstances[Placement.MeshIndex].Footprints;
+		SetCellOwner(Placement.Footprint, {Placement.MeshIndex, Footprints.Add(Placement.Footprint)});
+	}
+
+	NumFlushedPlacements = Last;
+	if(NumFlushedPlacements == PendingPlacements.Num())
+	{
+		//Keeps the capacity for the next batch
+		PendingPlacements.Reset();
+		NumFlushedPlacements = 0;
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UGridPlacerGridComponent::ClearGrid()
+{
+	for(UInstancedStaticMeshComponent* Component : InstanceComponents)
+	{
+		if(Component)
+			Component->ClearInstances();
+	}
+	for(FMeshInstances& Instances : MeshInstances)
+		Instances.Footprints.Reset();
+	CellOwners.Reset();
+	Occupancy.Reset();
+	PendingPlacements.Reset();
+	NumFlushedPlacements = 0;
+	SetComponentTickEnabled(false);
+}
+
+int32 UGridPlacerGridComponent::FindOrAddMesh(UStaticMesh* Mesh)
+{
+	//Build modes use a handful of meshes, a linear search beats hashing here
+	const int32 Existing = Meshes.Find(Mesh);
+	if(Existing != INDEX_NONE)
+		return Existing;
+
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(GetOwner(), NAME_None, RF_Transient);
+	Component->SetMobility(Mobility);
+	Component->SetStaticMesh(Mesh);
+	Component->SetupAttachment(this);
+	Component->RegisterComponent();
+
+	Meshes.Add(Mesh);
+	InstanceComponents.Add(Component);
+	return MeshInstances.AddDefaulted();
+}
+
+void UGridPlacerGridComponent::SetCellOwner(const FGridPlacerCellBox& Cells, const FInstanceRef& Owner)
+{
+	for(int32 Z = Cells.Min.Z; Z <= Cells.Max.Z; ++Z)
+		for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+			for(int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+				CellOwners.Add(FIntVector(X, Y, Z), Owner);
+}
+
+void UGridPlacerGridComponent::ReplaceCellOwner(const FGridPlacerCellBox& Cells, const FInstanceRef& From, const FInstanceRef& To)
+{
+	for(int32 Z = Cells.Min.Z; Z <= Cells.Max.Z; ++Z)
+		for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+			for(int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+			{
+				const FIntVector Cell(X, Y, Z);
+				FInstanceRef* Owner = CellOwners.Find(Cell);
+				if(!Owner || !(*Owner == From))
+					continue;
+				if(To.MeshIndex == INDEX_NONE)
+					CellOwners.Remove(Cell);
+				else
+					*Owner = To;
+			}
+}
+#pragma endregion
+
+void UGridPlacerGridComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	FlushPendingPlacements(MaxPlacementsPerFrame);
+}
+
+void UGridPlacerGridComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+	for(UInstancedStaticMeshComponent* Component : InstanceComponents)
+	{
+		if(Component)
+			Component->DestroyComponent();
+	}
+	InstanceComponents.Reset();
+	Meshes.Reset();
+	MeshInstances.Reset();
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
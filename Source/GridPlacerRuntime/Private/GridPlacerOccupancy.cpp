@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerOccupancy.h"
+
+#pragma region Frame
+FIntVector FGridPlacerFrame::WorldToCell(const FVector& WorldPosition) const
+{
+	const FVector GridPosition = GridToWorld.InverseTransformPosition(WorldPosition);
+	return FIntVector(
+		FMath::FloorToInt32(GridPosition.X / CellSize.X),
+		FMath::FloorToInt32(GridPosition.Y / CellSize.Y),
+		FMath::FloorToInt32(GridPosition.Z / CellSize.Z));
+}
+
+FGridPlacerCellBox FGridPlacerFrame::GetCellBox(const FBox& GridSpaceBounds) const
+{
+	//Shrink the bounds a little so objects that exactly fill their cells don't spill into the neighbors
+	const FVector Tolerance = CellSize * 0.01f;
+	const FIntVector Min(
+		FMath::FloorToInt32((GridSpaceBounds.Min.X + Tolerance.X) / CellSize.X),
+		FMath::FloorToInt32((GridSpaceBounds.Min.Y + Tolerance.Y) / CellSize.Y),
+		FMath::FloorToInt32((GridSpaceBounds.Min.Z + Tolerance.Z) / CellSize.Z));
+	const FIntVector Max(
+		FMath::FloorToInt32((GridSpaceBounds.Max.X - Tolerance.X) / CellSize.X),
+		FMath::FloorToInt32((GridSpaceBounds.Max.Y - Tolerance.Y) / CellSize.Y),
+		FMath::FloorToInt32((GridSpaceBounds.Max.Z - Tolerance.Z) / CellSize.Z));
+	//Flat or tiny objects still occupy the cell they are in
+	return FGridPlacerCellBox(Min, FIntVector(FMath::Max(Min.X, Max.X), FMath::Max(Min.Y, Max.Y), FMath::Max(Min.Z, Max.Z)));
+}
+
+FGridPlacerCellBox FGridPlacerFrame::GetFootprint(const FBox& LocalBounds, const FTransform& ObjectToWorld) const
+{
+	if(!LocalBounds.IsValid)
+	{
+		const FVector GridPosition = GridToWorld.InverseTransformPosition(ObjectToWorld.GetLocation());
+		return GetCellBox(FBox(GridPosition, GridPosition));
+	}
+	return GetCellBox(LocalBounds.TransformBy(ObjectToWorld.GetRelativeTransform(GridToWorld)));
+}
+
+FBox FGridPlacerFrame::GetCellBounds(const FGridPlacerCellBox& Cells) const
+{
+	return FBox(FVector(Cells.Min) * CellSize, FVector(Cells.Max + FIntVector(1)) * CellSize);
+}
+
+bool FGridPlacerFrame::Equals(const FGridPlacerFrame& Other) const
+{
+	return GridToWorld.Equals(Other.GridToWorld) && CellSize.Equals(Other.CellSize);
+}
+#pragma endregion
+
+#pragma region Occupancy
+template<typename VisitorType>
+void FGridPlacerOccupancy::ForEachRowSpan(const FGridPlacerCellBox& Cells, VisitorType&& Visitor)
+{
+	for(int32 Layer = Cells.Min.Z; Layer <= Cells.Max.Z; ++Layer)
+	{
+		for(int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+		{
+			int32 X = Cells.Min.X;
+			while(X <= Cells.Max.X)
+			{
+				const int32 ChunkX = X >> ChunkShift;
+				const int32 ChunkMinX = ChunkX << ChunkShift;
+				const int32 LocalMinX = X - ChunkMinX;
+				const int32 LocalMaxX = FMath::Min(Cells.Max.X - ChunkMinX, ChunkSize - 1);
+				const int32 Width = LocalMaxX - LocalMinX + 1;
+				const uint64 RowMask = (Width == ChunkSize ? ~uint64(0) : ((uint64(1) << Width) - 1)) << LocalMinX;
+				if(!Visitor(FIntVector(ChunkX, Y >> ChunkShift, Layer), Y, RowMask, ChunkMinX))
+					return;
+				X = ChunkMinX + ChunkSize;
+			}
+		}
+	}
+}
+
+void FGridPlacerOccupancy::Reset()
+{
+	Chunks.Reset();
+	ExtraReferences.Reset();
+	NumOccupied = 0;
+}
+
+void FGridPlacerOccupancy::Add(const FGridPlacerCellBox& Cells)
+{
+	ForEachRowSpan(Cells, [this](const FIntVector& ChunkKey, int32 Y, uint64 RowMask, int32 ChunkMinX)
+	{
+		FChunk& Chunk = Chunks.FindOrAdd(ChunkKey);
+		uint64& Row = Chunk.Rows[Y & (ChunkSize - 1)];
+		const uint64 AlreadySet = Row & RowMask;
+		const int32 NumNew = FMath::CountBits(RowMask & ~Row);
+		Row |= RowMask;
+		Chunk.NumOccupied += NumNew;
+		NumOccupied += NumNew;
+		for(uint64 Bits = AlreadySet; Bits; Bits &= Bits - 1)
+			ExtraReferences.FindOrAdd(FIntVector(ChunkMinX + FMath::CountTrailingZeros64(Bits), Y, ChunkKey.Z))++;
+		return true;
+	});
+}
+
+void FGridPlacerOccupancy::Remove(const FGridPlacerCellBox& Cells)
+{
+	ForEachRowSpan(Cells, [this](const FIntVector& ChunkKey, int32 Y, uint64 RowMask, int32 ChunkMinX)
+	{
+		FChunk* Chunk = Chunks.Find(ChunkKey);
+		if(!Chunk)
+			return true;
+		uint64& Row = Chunk->Rows[Y & (ChunkSize - 1)];
+		uint64 ToClear = Row & RowMask;
+		//Cells that are covered more than once stay occupied
+		if(ExtraReferences.Num() > 0)
+		{
+			for(uint64 Bits = ToClear; Bits; Bits &= Bits - 1)
+			{
+				const int32 BitIndex = FMath::CountTrailingZeros64(Bits);
+				const FIntVector Cell(ChunkMinX + BitIndex, Y, ChunkKey.Z);
+				if(int32* Extra = ExtraReferences.Find(Cell))
+				{
+					if(--(*Extra) == 0)
+						ExtraReferences.Remove(Cell);
+					ToClear &= ~(uint64(1) << BitIndex);
+				}
+			}
+		}
+		Row &= ~ToClear;
+		const int32 NumCleared = FMath::CountBits(ToClear);
+		Chunk->NumOccupied -= NumCleared;
+		NumOccupied -= NumCleared;
+		if(Chunk->NumOccupied == 0)
+			Chunks.Remove(ChunkKey);
+		return true;
+	});
+}
+
+bool FGridPlacerOccupancy::IsOccupied(const FIntVector& Cell) const
+{
+	const FChunk* Chunk = Chunks.Find(FIntVector(Cell.X >> ChunkShift, Cell.Y >> ChunkShift, Cell.Z));
+	return Chunk && (Chunk->Rows[Cell.Y & (ChunkSize - 1)] & (uint64(1) << (Cell.X & (ChunkSize - 1)))) != 0;
+}
+
+bool FGridPlacerOccupancy::Overlaps(const FGridPlacerCellBox& Cells) const
+{
+	bool Overlapping = false;
+	ForEachRowSpan(Cells, [this, &Overlapping](const FIntVector& ChunkKey, int32 Y, uint64 RowMask, int32 ChunkMinX)
+	{
+		const FChunk* Chunk = Chunks.Find(ChunkKey);
+		Overlapping = Chunk && (Chunk->Rows[Y & (ChunkSize - 1)] & RowMask) != 0;
+		return !Overlapping;
+	});
+	return Overlapping;
+}
+
+uint64 FGridPlacerOccupancy::GetRow(int32 ChunkX, int32 Y, int32 Layer) const
+{
+	const FChunk* Chunk = Chunks.Find(FIntVector(ChunkX, Y >> ChunkShift, Layer));
+	return Chunk ? Chunk->Rows[Y & (ChunkSize - 1)] : 0;
+}
+
+uint64 FGridPlacerOccupancy::GetEnclosedRow(int32 ChunkX, int32 Y, int32 Layer) const
+{
+	const uint64 Row = GetRow(ChunkX, Y, Layer);
+	if(!Row)
+		return 0;
+	//Shifting the row by one lines every cell up with its neighbor along X, the ends come from the neighboring chunks
+	const uint64 Left = (Row << 1) | (GetRow(ChunkX - 1, Y, Layer) >> (ChunkSize - 1));
+	const uint64 Right = (Row >> 1) | (GetRow(ChunkX + 1, Y, Layer) << (ChunkSize - 1));
+	return Row & Left & Right
+		& GetRow(ChunkX, Y - 1, Layer) & GetRow(ChunkX, Y + 1, Layer)
+		& GetRow(ChunkX, Y, Layer - 1) & GetRow(ChunkX, Y, Layer + 1);
+}
+
+bool FGridPlacerOccupancy::IsEnclosed(const FGridPlacerCellBox& Cells) const
+{
+	bool Enclosed = true;
+	ForEachRowSpan(Cells, [this, &Enclosed](const FIntVector& ChunkKey, int32 Y, uint64 RowMask, int32 ChunkMinX)
+	{
+		Enclosed = (GetEnclosedRow(ChunkKey.X, Y, ChunkKey.Z) & RowMask) == RowMask;
+		return Enclosed;
+	});
+	return Enclosed;
+}
+#pragma endregion
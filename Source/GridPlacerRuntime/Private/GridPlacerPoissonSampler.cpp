@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerPoissonSampler.h"
+
+void FGridPlacerPoissonSampler::Reset(double MinSpacing)
+{
+	CellSize = FMath::Max(MinSpacing, UE_KINDA_SMALL_NUMBER) * UE_INV_SQRT_2;
+	MaxSpacing = 0.0;
+	Samples.Reset();
+	Cells.Reset();
+	Active.Reset();
+}
+
+FIntPoint FGridPlacerPoissonSampler::GetCell(const FVector2D& Position) const
+{
+	return FIntPoint(FMath::FloorToInt32(Position.X / CellSize), FMath::FloorToInt32(Position.Y / CellSize));
+}
+
+int32 FGridPlacerPoissonSampler::Add(const FSample& Sample)
+{
+	const int32 Index = Samples.AddDefaulted();
+	FEntry& Entry = Samples[Index];
+	Entry.Sample = Sample;
+	//Existing objects can be closer than the background grid assumes, so cells hold a list instead of a single sample
+	int32& Head = Cells.FindOrAdd(GetCell(Sample.Position), INDEX_NONE);
+	Entry.Next = Head;
+	Head = Index;
+	MaxSpacing = FMath::Max(MaxSpacing, Sample.Spacing);
+	return Index;
+}
+
+void FGridPlacerPoissonSampler::AddExisting(const FVector2D& Position, double Spacing)
+{
+	Add({Position, Spacing, INDEX_NONE});
+}
+
+bool FGridPlacerPoissonSampler::IsFree(const FVector2D& Position, double Spacing) const
+{
+	//Any sample closer than the larger spacing is a conflict, and no spacing is larger than MaxSpacing
+	const double SearchRadius = FMath::Max(Spacing, MaxSpacing);
+	const FIntPoint Min = GetCell(Position - FVector2D(SearchRadius));
+	const FIntPoint Max = GetCell(Position + FVector2D(SearchRadius));
+	for(int32 Y = Min.Y; Y <= Max.Y; ++Y)
+	{
+		for(int32 X = Min.X; X <= Max.X; ++X)
+		{
+			const int32* Head = Cells.Find(FIntPoint(X, Y));
+			for(int32 Index = Head ? *Head : INDEX_NONE; Index != INDEX_NONE; Index = Samples[Index].Next)
+			{
+				const FSample& Other = Samples[Index].Sample;
+				const double MinDistance = FMath::Max(Spacing, Other.Spacing);
+				if(FVector2D::DistSquared(Position, Other.Position) < MinDistance * MinDistance)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+void FGridPlacerPoissonSampler::Fill(const FBox2D& Region, int32 Attempts, FRandomStream& Stream, TFunctionRef<double(int32&)> PickCandidate, TArray<FSample>& OutSamples)
+{
+	if(!Region.bIsValid)
+		return;
+	Attempts = FMath::Max(Attempts, 1);
+
+	//Samples next to the region can grow into it, everything further away can't reach it
+	const FBox2D GrowRegion = Region.ExpandBy(2.0 * MaxSpacing);
+	Active.Reset();
+	for(int32 Index = 0; Index < Samples.Num(); ++Index)
+		if(!Samples[Index].Closed && GrowRegion.IsInside(Samples[Index].Sample.Position))
+			Active.Add(Index);
+
+	//A fresh seed covers empty regions and parts that are cut off from the existing samples
+	for(int32 Attempt = 0; Attempt < Attempts; ++Attempt)
+	{
+		FSample Seed;
+		Seed.Spacing = PickCandidate(Seed.Tag);
+		Seed.Position = FVector2D(Stream.FRandRange(Region.Min.X, Region.Max.X), Stream.FRandRange(Region.Min.Y, Region.Max.Y));
+		if(!IsFree(Seed.Position, Seed.Spacing))
+			continue;
+		Active.Add(Add(Seed));
+		OutSamples.Add(Seed);
+		break;
+	}
+
+	while(Active.Num() > 0)
+	{
+		const int32 ActiveIndex = Stream.RandHelper(Active.Num());
+		const FSample Origin = Samples[Active[ActiveIndex]].Sample;
+		bool Found = false;
+		bool LeftRegion = false;
+		for(int32 Attempt = 0; Attempt < Attempts && !Found; ++Attempt)
+		{
+			FSample Candidate;
+			Candidate.Spacing = PickCandidate(Candidate.Tag);
+			//Bridson's annulus between one and two times the spacing
+			const double Distance = FMath::Max(Candidate.Spacing, Origin.Spacing) * (1.0 + Stream.GetFraction());
+			const double Angle = Stream.GetFraction() * UE_TWO_PI;
+			Candidate.Position = Origin.Position + FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * Distance;
+			if(!Region.IsInside(Candidate.Position))
+			{
+				LeftRegion = true;
+				continue;
+			}
+			if(!IsFree(Candidate.Position, Candidate.Spacing))
+				continue;
+			Active.Add(Add(Candidate));
+			OutSamples.Add(Candidate);
+			Found = true;
+		}
+		if(!Found)
+		{
+			Samples[Active[ActiveIndex]].Closed = !LeftRegion;
+			Active.RemoveAtSwap(ActiveIndex, 1, false);
+		}
+	}
+}
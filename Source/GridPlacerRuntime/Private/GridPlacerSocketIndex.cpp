@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerSocketIndex.h"
+
+void FGridPlacerSocketIndex::Reset(const FGridPlacerFrame& InFrame)
+{
+	Frame = InFrame;
+	Sockets.Reset();
+	Cells.Reset();
+	ItemSocketIndices.Reset();
+}
+
+void FGridPlacerSocketIndex::Add(uint32 ItemId, TArrayView<const FSocket> ItemSockets)
+{
+	Remove(ItemId);
+	if(ItemSockets.Num() == 0)
+		return;
+	TArray<int32, TInlineAllocator<4>>& Indices = ItemSocketIndices.Add(ItemId);
+	for(const FSocket& Socket : ItemSockets)
+	{
+		const int32 Index = Sockets.Add(Socket);
+		Sockets[Index].ItemId = ItemId;
+		Indices.Add(Index);
+		Cells.FindOrAdd(Frame.WorldToCell(Socket.Transform.GetLocation())).Add(Index);
+	}
+}
+
+void FGridPlacerSocketIndex::Remove(uint32 ItemId)
+{
+	TArray<int32, TInlineAllocator<4>> Indices;
+	if(!ItemSocketIndices.RemoveAndCopyValue(ItemId, Indices))
+		return;
+	for(const int32 Index : Indices)
+	{
+		const FIntVector Cell = Frame.WorldToCell(Sockets[Index].Transform.GetLocation());
+		if(TArray<int32>* CellSockets = Cells.Find(Cell))
+		{
+			CellSockets->RemoveSingleSwap(Index, false);
+			if(CellSockets->Num() == 0)
+				Cells.Remove(Cell);
+		}
+		Sockets.RemoveAt(Index);
+	}
+}
+
+const FGridPlacerSocketIndex::FSocket* FGridPlacerSocketIndex::FindClosest(const FVector& Location, FName Tag, double MaxDistance) const
+{
+	//Every cell the sphere around Location can reach, the grid may be rotated so the box is built in grid space
+	const FVector GridLocation = Frame.GridToWorld.InverseTransformPosition(Location);
+	const FGridPlacerCellBox Reach = Frame.GetCellBox(FBox(GridLocation - FVector(MaxDistance), GridLocation + FVector(MaxDistance)));
+	const FSocket* Closest = nullptr;
+	double ClosestDistanceSquared = MaxDistance * MaxDistance;
+	for(int32 Z = Reach.Min.Z; Z <= Reach.Max.Z; ++Z)
+	{
+		for(int32 Y = Reach.Min.Y; Y <= Reach.Max.Y; ++Y)
+		{
+			for(int32 X = Reach.Min.X; X <= Reach.Max.X; ++X)
+			{
+				const TArray<int32>* CellSockets = Cells.Find(FIntVector(X, Y, Z));
+				if(!CellSockets)
+					continue;
+				for(const int32 Index : *CellSockets)
+				{
+					const FSocket& Socket = Sockets[Index];
+					const double DistanceSquared = FVector::DistSquared(Socket.Transform.GetLocation(), Location);
+					if(Socket.Tag == Tag && DistanceSquared <= ClosestDistanceSquared)
+					{
+						Closest = &Socket;
+						ClosestDistanceSquared = DistanceSquared;
+					}
+				}
+			}
+		}
+	}
+	return Closest;
+}
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerSpatialHash.h"
+
+namespace
+{
+	constexpr int64 MaxBucketsPerItem = 512;
+}
+
+FGridPlacerSpatialHash::FGridPlacerSpatialHash(double InBucketSize)
+	: BucketSize(InBucketSize)
+{
+}
+
+void FGridPlacerSpatialHash::Reset()
+{
+	Buckets.Reset();
+	ItemBounds.Reset();
+	OversizedItems.Reset();
+}
+
+FIntVector FGridPlacerSpatialHash::GetBucket(const FVector& Position) const
+{
+	return FIntVector(
+		FMath::FloorToInt32(Position.X / BucketSize),
+		FMath::FloorToInt32(Position.Y / BucketSize),
+		FMath::FloorToInt32(Position.Z / BucketSize));
+}
+
+bool FGridPlacerSpatialHash::IsOversized(const FBox& Bounds) const
+{
+	const FIntVector Size = GetBucket(Bounds.Max) - GetBucket(Bounds.Min) + FIntVector(1);
+	return int64(Size.X) * Size.Y * Size.Z > MaxBucketsPerItem;
+}
+
+void FGridPlacerSpatialHash::Insert(uint32 Id, const FBox& Bounds)
+{
+	Remove(Id);
+	ItemBounds.Add(Id, Bounds);
+	if(IsOversized(Bounds))
+	{
+		OversizedItems.Add(Id);
+		return;
+	}
+	const FIntVector Min = GetBucket(Bounds.Min);
+	const FIntVector Max = GetBucket(Bounds.Max);
+	for(int32 Z = Min.Z; Z <= Max.Z; ++Z)
+		for(int32 Y = Min.Y; Y <= Max.Y; ++Y)
+			for(int32 X = Min.X; X <= Max.X; ++X)
+				Buckets.FindOrAdd(FIntVector(X, Y, Z)).Add(Id);
+}
+
+void FGridPlacerSpatialHash::Remove(uint32 Id)
+{
+	FBox Bounds;
+	if(!ItemBounds.RemoveAndCopyValue(Id, Bounds))
+		return;
+	if(IsOversized(Bounds))
+	{
+		OversizedItems.RemoveSwap(Id);
+		return;
+	}
+	const FIntVector Min = GetBucket(Bounds.Min);
+	const FIntVector Max = GetBucket(Bounds.Max);
+	for(int32 Z = Min.Z; Z <= Max.Z; ++Z)
+	{
+		for(int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			for(int32 X = Min.X; X <= Max.X; ++X)
+			{
+				const FIntVector Key(X, Y, Z);
+				if(TArray<uint32>* Bucket = Buckets.Find(Key))
+				{
+					Bucket->RemoveSingleSwap(Id, false);
+					if(Bucket->Num() == 0)
+						Buckets.Remove(Key);
+				}
+			}
+		}
+	}
+}
+
+void FGridPlacerSpatialHash::Query(const FBox& QueryBounds, TArray<uint32>& OutIds) const
+{
+	const FIntVector Min = GetBucket(QueryBounds.Min);
+	const FIntVector Max = GetBucket(QueryBounds.Max);
+	const int64 NumQueryBuckets = int64(Max.X - Min.X + 1) * (Max.Y - Min.Y + 1) * (Max.Z - Min.Z + 1);
+	if(NumQueryBuckets > Buckets.Num())
+	{
+		//Huge query boxes are cheaper to answer by walking the occupied buckets
+		for(const TPair<FIntVector, TArray<uint32>>& Pair : Buckets)
+		{
+			const FIntVector& Key = Pair.Key;
+			if(Key.X < Min.X || Key.Y < Min.Y || Key.Z < Min.Z || Key.X > Max.X || Key.Y > Max.Y || Key.Z > Max.Z)
+				continue;
+			for(const uint32 Id : Pair.Value)
+			{
+				const FBox& Bounds = ItemBounds.FindChecked(Id);
+				//Items spanning several buckets are only reported by the bucket holding the minimum of the overlap
+				if(Bounds.Intersect(QueryBounds) && GetBucket(Bounds.Min.ComponentMax(QueryBounds.Min)) == Key)
+					OutIds.Add(Id);
+			}
+		}
+	}
+	else
+	{
+		for(int32 Z = Min.Z; Z <= Max.Z; ++Z)
+		{
+			for(int32 Y = Min.Y; Y <= Max.Y; ++Y)
+			{
+				for(int32 X = Min.X; X <= Max.X; ++X)
+				{
+					const FIntVector Key(X, Y, Z);
+					const TArray<uint32>* Bucket = Buckets.Find(Key);
+					if(!Bucket)
+						continue;
+					for(const uint32 Id : *Bucket)
+					{
+						const FBox& Bounds = ItemBounds.FindChecked(Id);
+						if(Bounds.Intersect(QueryBounds) && GetBucket(Bounds.Min.ComponentMax(QueryBounds.Min)) == Key)
+							OutIds.Add(Id);
+					}
+				}
+			}
+		}
+	}
+	for(const uint32 Id : OversizedItems)
+		if(ItemBounds.FindChecked(Id).Intersect(QueryBounds))
+			OutIds.Add(Id);
+}
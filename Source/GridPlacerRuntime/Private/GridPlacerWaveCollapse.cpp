@@ -0,0 +1,270 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GridPlacerWaveCollapse.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	const FIntPoint EdgeOffsets[FGridPlacerWaveCollapse::NumEdges] = {FIntPoint(1, 0), FIntPoint(0, 1), FIntPoint(-1, 0), FIntPoint(0, -1)};
+
+	int32 GetOppositeEdge(int32 Edge)
+	{
+		return (Edge + 2) % FGridPlacerWaveCollapse::NumEdges;
+	}
+
+	struct FEntropyEntry
+	{
+		double Entropy;
+		int32 Cell;
+
+		bool operator<(const FEntropyEntry& Other) const { return Entropy < Other.Entropy; }
+	};
+
+	/*Marks cells that were given up on, nothing fits into them*/
+	constexpr int32 UnsolvableTile = -2;
+}
+
+void FGridPlacerWaveCollapse::SetTiles(TArrayView<const FTile> Tiles)
+{
+	const int32 Num = Tiles.Num();
+	NumWords = FMath::DivideAndRoundUp(Num, 64);
+	Weights.SetNumUninitialized(Num);
+	WeightLogWeights.SetNumUninitialized(Num);
+	Compatible.Reset();
+	Compatible.SetNumZeroed(NumEdges * Num * NumWords);
+	for(int32 Tile = 0; Tile < Num; ++Tile)
+	{
+		const double Weight = FMath::Max(static_cast<double>(Tiles[Tile].Weight), UE_KINDA_SMALL_NUMBER);
+		Weights[Tile] = Weight;
+		WeightLogWeights[Tile] = Weight * FMath::Loge(Weight);
+		for(int32 Edge = 0; Edge < NumEdges; ++Edge)
+		{
+			uint64* Mask = &Compatible[(Edge * Num + Tile) * NumWords];
+			for(int32 Other = 0; Other < Num; ++Other)
+				if(Tiles[Tile].Edges[Edge] == Tiles[Other].Edges[GetOppositeEdge(Edge)])
+					Mask[Other / 64] |= 1ull << (Other % 64);
+		}
+	}
+}
+
+int32 FGridPlacerWaveCollapse::Solve(const FIntPoint& Size, int32 Seed, int32 BlockSize, int32 Attempts, TArray<int32>& OutTiles) const
+{
+	OutTiles.Init(INDEX_NONE, FMath::Max(Size.X, 0) * FMath::Max(Size.Y, 0));
+	if(NumTiles() == 0 || OutTiles.Num() == 0)
+		return OutTiles.Num();
+
+	BlockSize = FMath::Max(BlockSize, 1);
+	const FIntPoint NumBlocks(FMath::DivideAndRoundUp(Size.X, BlockSize), FMath::DivideAndRoundUp(Size.Y, BlockSize));
+	TArray<FIntRect> Blocks[2];
+	for(int32 BlockY = 0; BlockY < NumBlocks.Y; ++BlockY)
+		for(int32 BlockX = 0; BlockX < NumBlocks.X; ++BlockX)
+			Blocks[(BlockX + BlockY) % 2].Add(FIntRect(FIntPoint(BlockX, BlockY) * BlockSize, FIntPoint::ComponentMin(FIntPoint(BlockX + 1, BlockY + 1) * BlockSize, Size)));
+
+	int32 NumUnsolved = 0;
+	for(const TArray<FIntRect>& ColorBlocks : Blocks)
+	{
+		TArray<int32> BlockUnsolved;
+		BlockUnsolved.SetNumZeroed(ColorBlocks.Num());
+		ParallelFor(TEXT("GridPlacer.WaveCollapse"), ColorBlocks.Num(), 1, [&](int32 BlockIndex)
+		{
+			const FIntRect& Block = ColorBlocks[BlockIndex];
+			for(int32 Attempt = 0; ; ++Attempt)
+			{
+				//Seeded per block and attempt, so it doesn't matter which thread gets which block
+				FRandomStream Stream(static_cast<int32>(HashCombine(HashCombine(GetTypeHash(Seed), GetTypeHash(Block.Min)), GetTypeHash(Attempt))));
+				const int32 Result = SolveBlock(Size, Block, Stream, Attempt >= Attempts, OutTiles);
+				if(Result != INDEX_NONE)
+				{
+					BlockUnsolved[BlockIndex] = Result;
+					break;
+				}
+			}
+		});
+		for(const int32 Unsolved : BlockUnsolved)
+			NumUnsolved += Unsolved;
+	}
+	return NumUnsolved;
+}
+
+int32 FGridPlacerWaveCollapse::SolveBlock(const FIntPoint& Size, const FIntRect& Block, FRandomStream& Stream, bool Tolerant, TArray<int32>& Tiles) const
+{
+	const FIntPoint BlockSize = Block.Size();
+	const int32 NumCells = BlockSize.X * BlockSize.Y;
+	const int32 Num = NumTiles();
+
+	//Every cell starts out allowing every tile
+	TArray<uint64> Domains;
+	Domains.SetNumUninitialized(NumCells * NumWords);
+	for(int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		for(int32 Word = 0; Word < NumWords; ++Word)
+			Domains[Cell * NumWords + Word] = ~0ull;
+		if(Num % 64)
+			Domains[Cell * NumWords + NumWords - 1] = (1ull << (Num % 64)) - 1;
+	}
+	TArray<int32> Picked;
+	Picked.Init(INDEX_NONE, NumCells);
+	TArray<double> Entropies;
+	Entropies.SetNumUninitialized(NumCells);
+	TArray<FEntropyEntry> Heap;
+	Heap.Reserve(NumCells * 2);
+	TArray<int32> Worklist;
+	TBitArray<> Queued(false, NumCells);
+	TArray<uint64> Allowed;
+	Allowed.SetNumUninitialized(NumWords);
+	int32 NumUnsolved = 0;
+
+	auto GetLocalCell = [&](const FIntPoint& Position) { return (Position.Y - Block.Min.Y) * BlockSize.X + Position.X - Block.Min.X; };
+	auto GetPosition = [&](int32 Cell) { return Block.Min + FIntPoint(Cell % BlockSize.X, Cell / BlockSize.X); };
+
+	auto UpdateEntropy = [&](int32 Cell)
+	{
+		double SumWeights = 0.0;
+		double SumWeightLogWeights = 0.0;
+		for(int32 Word = 0; Word < NumWords; ++Word)
+		{
+			for(uint64 Bits = Domains[Cell * NumWords + Word]; Bits; Bits &= Bits - 1)
+			{
+				const int32 Tile = Word * 64 + FMath::CountTrailingZeros64(Bits);
+				SumWeights += Weights[Tile];
+				SumWeightLogWeights += WeightLogWeights[Tile];
+			}
+		}
+		//A little noise breaks ties without always favoring the first cells
+		Entropies[Cell] = FMath::Loge(SumWeights) - SumWeightLogWeights / SumWeights + Stream.GetFraction() * 1e-6;
+		Heap.HeapPush({Entropies[Cell], Cell});
+	};
+
+	auto Enqueue = [&](int32 Cell)
+	{
+		if(!Queued[Cell])
+		{
+			Queued[Cell] = true;
+			Worklist.Add(Cell);
+		}
+	};
+
+	//Removes the tiles missing from Mask from the domain of Cell. Returns false on a contradiction
+	auto Restrict = [&](int32 Cell, const uint64* Mask)
+	{
+		if(Picked[Cell] == UnsolvableTile)
+			return true;
+		uint64* Domain = &Domains[Cell * NumWords];
+		bool Changed = false;
+		bool Empty = true;
+		for(int32 Word = 0; Word < NumWords; ++Word)
+		{
+			const uint64 Restricted = Domain[Word] & Mask[Word];
+			Changed |= Restricted != Domain[Word];
+			Empty &= Restricted == 0;
+		}
+		if(Empty)
+		{
+			if(!Tolerant)
+				return false;
+			//The cell stays empty and stops constraining its neighbors
+			Picked[Cell] = UnsolvableTile;
+			++NumUnsolved;
+			return true;
+		}
+		if(!Changed)
+			return true;
+		for(int32 Word = 0; Word < NumWords; ++Word)
+			Domain[Word] &= Mask[Word];
+		Enqueue(Cell);
+		if(Picked[Cell] == INDEX_NONE)
+			UpdateEntropy(Cell);
+		return true;
+	};
+
+	auto Propagate = [&]()
+	{
+		while(Worklist.Num() > 0)
+		{
+			const int32 Cell = Worklist.Pop(false);
+			Queued[Cell] = false;
+			if(Picked[Cell] == UnsolvableTile)
+				continue;
+			const FIntPoint Position = GetPosition(Cell);
+			for(int32 Edge = 0; Edge < NumEdges; ++Edge)
+			{
+				const FIntPoint Neighbor = Position + EdgeOffsets[Edge];
+				if(!Block.Contains(Neighbor))
+					continue;
+				FMemory::Memzero(Allowed.GetData(), NumWords * sizeof(uint64));
+				for(int32 Word = 0; Word < NumWords; ++Word)
+				{
+					for(uint64 Bits = Domains[Cell * NumWords + Word]; Bits; Bits &= Bits - 1)
+					{
+						const uint64* Mask = GetCompatible(Edge, Word * 64 + FMath::CountTrailingZeros64(Bits));
+						for(int32 AllowedWord = 0; AllowedWord < NumWords; ++AllowedWord)
+							Allowed[AllowedWord] |= Mask[AllowedWord];
+					}
+				}
+				if(!Restrict(GetLocalCell(Neighbor), Allowed.GetData()))
+					return false;
+			}
+		}
+		return true;
+	};
+
+	for(int32 Cell = 0; Cell < NumCells; ++Cell)
+		UpdateEntropy(Cell);
+
+	//Fit the border to the blocks around that are solved already
+	for(int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		const FIntPoint Position = GetPosition(Cell);
+		for(int32 Edge = 0; Edge < NumEdges; ++Edge)
+		{
+			const FIntPoint Neighbor = Position + EdgeOffsets[Edge];
+			if(Block.Contains(Neighbor) || Neighbor.X < 0 || Neighbor.Y < 0 || Neighbor.X >= Size.X || Neighbor.Y >= Size.Y)
+				continue;
+			const int32 NeighborTile = Tiles[Neighbor.Y * Size.X + Neighbor.X];
+			if(NeighborTile != INDEX_NONE && !Restrict(Cell, GetCompatible(GetOppositeEdge(Edge), NeighborTile)))
+				return INDEX_NONE;
+		}
+	}
+	if(!Propagate())
+		return INDEX_NONE;
+
+	while(Heap.Num() > 0)
+	{
+		FEntropyEntry Entry;
+		Heap.HeapPop(Entry, false);
+		//Entries of cells whose domain shrank since are stale
+		if(Picked[Entry.Cell] != INDEX_NONE || Entry.Entropy != Entropies[Entry.Cell])
+			continue;
+
+		uint64* Domain = &Domains[Entry.Cell * NumWords];
+		double SumWeights = 0.0;
+		for(int32 Word = 0; Word < NumWords; ++Word)
+			for(uint64 Bits = Domain[Word]; Bits; Bits &= Bits - 1)
+				SumWeights += Weights[Word * 64 + FMath::CountTrailingZeros64(Bits)];
+		double Pick = Stream.GetFraction() * SumWeights;
+		int32 PickedTile = INDEX_NONE;
+		for(int32 Word = 0; Word < NumWords && Pick >= 0.0; ++Word)
+		{
+			for(uint64 Bits = Domain[Word]; Bits && Pick >= 0.0; Bits &= Bits - 1)
+			{
+				PickedTile = Word * 64 + FMath::CountTrailingZeros64(Bits);
+				Pick -= Weights[PickedTile];
+			}
+		}
+
+		FMemory::Memzero(Domain, NumWords * sizeof(uint64));
+		Domain[PickedTile / 64] = 1ull << (PickedTile % 64);
+		Picked[Entry.Cell] = PickedTile;
+		Enqueue(Entry.Cell);
+		if(!Propagate())
+			return INDEX_NONE;
+	}
+
+	for(int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		const FIntPoint Position = GetPosition(Cell);
+		Tiles[Position.Y * Size.X + Position.X] = Picked[Cell] >= 0 ? Picked[Cell] : INDEX_NONE;
+	}
+	return NumUnsolved;
+}
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Serialization/BulkData.h"
+#include "GridPlacerOccupancy.h"
+#include "GridPlacerCellData.generated.h"
+
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EGridPlacerCellFlags : uint8
+{
+	None = 0 UMETA(Hidden),
+	/*Something was placed in the cell*/
+	Occupied = 1 << 0,
+	/*More than one object covers the cell, the topmost one determines palette id and height*/
+	Stacked = 1 << 1,
+	/*At least one object covering the cell has collision*/
+	Blocking = 1 << 2
+};
+ENUM_CLASS_FLAGS(EGridPlacerCellFlags)
+
+USTRUCT(BlueprintType)
+struct FGridPlacerCell
+{
+	GENERATED_BODY()
+
+	/*Index into the palette of the cell data, INDEX_NONE for empty cells*/
+	UPROPERTY(BlueprintReadOnly, Category = "GridPlacer")
+	int32 PaletteIndex = INDEX_NONE;
+	/*Bit i is set if the cell carries tag i of the cell data*/
+	UPROPERTY(BlueprintReadOnly, Category = "GridPlacer")
+	int32 TagMask = 0;
+	/*Top of the topmost object in grid space*/
+	UPROPERTY(BlueprintReadOnly, Category = "GridPlacer")
+	float Height = 0.0f;
+	UPROPERTY(BlueprintReadOnly, Category = "GridPlacer", meta = (Bitmask, BitmaskEnum = "/Script/GridPlacerRuntime.EGridPlacerCellFlags"))
+	int32 Flags = 0;
+};
+
+/**
+ * One ChunkSize x ChunkSize block of cells, stored as one array per channel.
+ * The arrays are empty while the chunk is not streamed in.
+ */
+struct GRIDPLACERRUNTIME_API FGridPlacerCellChunk
+{
+	static constexpr int32 ChunkShift = 6;
+	static constexpr int32 ChunkSize = 1 << ChunkShift;
+	static constexpr int32 NumCells = ChunkSize * ChunkSize;
+	static constexpr uint16 InvalidPaletteId = MAX_uint16;
+
+	TArray<uint16> PaletteIds;
+	TArray<uint32> TagMasks;
+	TArray<float> Heights;
+	TArray<uint8> Flags;
+
+	/** Sizes all channels and marks every cell empty */
+	void Init();
+	void Reset();
+	bool IsLoaded() const { return PaletteIds.Num() == NumCells; }
+	void Serialize(FArchive& Ar);
+
+	static FIntPoint GetChunkCoord(const FIntPoint& Cell) { return FIntPoint(Cell.X >> ChunkShift, Cell.Y >> ChunkShift); }
+	static int32 GetLocalIndex(const FIntPoint& Cell) { return ((Cell.Y & (ChunkSize - 1)) << ChunkShift) | (Cell.X & (ChunkSize - 1)); }
+};
+
+/**
+ * Baked snapshot of what GridPlacer put into a level, so gameplay code can ask "what is in cell (X, Y)" without touching actors.
+ * Cells are 2D columns of the grid the content was baked in. Each chunk lives in its own bulk data payload,
+ * which ends up in a separate .ubulk file when cooking, so only the chunks around the player have to be resident.
+ * Lookups are a handful of shifts and array accesses.
+ */
+UCLASS(BlueprintType)
+class GRIDPLACERRUNTIME_API UGridPlacerCellData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** UObject interface */
+	virtual void Serialize(FArchive& Ar) override;
+
+	/*Grid the cells were baked in*/
+	UPROPERTY(VisibleAnywhere, Category = "Grid")
+	FTransform GridToWorld = FTransform::Identity;
+	UPROPERTY(VisibleAnywhere, Category = "Grid")
+	FVector CellSize = FVector(100.0);
+	/*Every asset found while baking, cells refer to it by index*/
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cells")
+	TArray<TSoftObjectPtr<UObject>> Palette;
+	/*Actor tags found while baking, bit i of a cell's tag mask stands for Tags[i]*/
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cells")
+	TArray<FName> Tags;
+
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	FIntPoint WorldToCell(const FVector& WorldPosition) const;
+	/** World position of the center of a cell's floor */
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	FVector CellToWorld(const FIntPoint& Cell) const;
+
+	/**
+	 * Reads a cell.
+	 * @return False if the cell is empty or its chunk is not loaded
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	bool GetCell(const FIntPoint& Cell, FGridPlacerCell& OutCell) const;
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	bool CellHasTag(const FIntPoint& Cell, FName Tag) const;
+
+	/** Per channel lookups for hot paths, empty or unloaded cells read as InvalidPaletteId, 0 and None */
+	uint16 GetPaletteId(const FIntPoint& Cell) const;
+	uint32 GetTagMask(const FIntPoint& Cell) const;
+	float GetHeight(const FIntPoint& Cell) const;
+	EGridPlacerCellFlags GetFlags(const FIntPoint& Cell) const;
+
+	/** Makes a chunk resident. Returns false if nothing was baked there. */
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	bool LoadChunk(const FIntPoint& ChunkCoord);
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	void UnloadChunk(const FIntPoint& ChunkCoord);
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	bool IsChunkLoaded(const FIntPoint& ChunkCoord) const;
+	/** Makes exactly the chunks within Radius of WorldPosition resident */
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	void StreamAround(const FVector& WorldPosition, float Radius);
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	void LoadAllChunks();
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	FIntPoint GetChunkCoord(const FIntPoint& Cell) const { return FGridPlacerCellChunk::GetChunkCoord(Cell); }
+
+	int32 GetNumChunks() const { return ChunkBulkData.Num(); }
+	int32 GetNumLoadedChunks() const { return ResidentChunks.Num(); }
+
+#if WITH_EDITOR
+	/** Replaces the baked content. Chunks have to be initialized, their coordinates are chunk coordinates. */
+	void SetBakedData(const FGridPlacerFrame& Frame, TArray<TSoftObjectPtr<UObject>>&& InPalette, TArray<FName>&& InTags, TMap<FIntPoint, FGridPlacerCellChunk>&& Chunks);
+#endif
+
+private:
+	/** Index into ChunkBulkData and LoadedChunks, INDEX_NONE if nothing was baked there */
+	int32 FindChunkIndex(const FIntPoint& ChunkCoord) const;
+	/** Resident chunk containing Cell or nullptr */
+	const FGridPlacerCellChunk* FindLoadedChunk(const FIntPoint& Cell) const;
+
+	/*Chunk coordinate of ChunkIndices[0], ChunkIndices covers NumChunks.X x NumChunks.Y chunks from there*/
+	UPROPERTY()
+	FIntPoint ChunkMin = FIntPoint::ZeroValue;
+	UPROPERTY()
+	FIntPoint NumChunks = FIntPoint::ZeroValue;
+	/*Dense lookup from chunk coordinate to payload index, INDEX_NONE for empty chunks*/
+	UPROPERTY()
+	TArray<int32> ChunkIndices;
+
+	TIndirectArray<FByteBulkData> ChunkBulkData;
+	TArray<FGridPlacerCellChunk> LoadedChunks;
+	/*Coordinates of the resident chunks, so streaming visits those instead of every baked chunk*/
+	TArray<FIntPoint> ResidentChunks;
+};
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "GridPlacerOccupancy.h"
+#include "GridPlacerTypes.h"
+#include "GridPlacerGridComponent.generated.h"
+
+class UStaticMesh;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Lightweight grid service for in-game build modes.
+ * The component transform is the grid frame. Placements claim their cells right away so follow-up queries see them,
+ * but the instances themselves are added once per frame in one AddInstances call per mesh.
+ * All scratch buffers are kept between frames, so placing does not allocate once they have grown to the working set.
+ */
+UCLASS(ClassGroup = (GridPlacer), meta = (BlueprintSpawnableComponent))
+class GRIDPLACERRUNTIME_API UGridPlacerGridComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UGridPlacerGridComponent();
+
+	/*The width, depth and layer height of a cell*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid")
+	FVector CellSize = FVector(100.0);
+	/*Refuse placements whose footprint overlaps occupied cells*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid")
+	bool PreventOverlaps = true;
+	/*How many queued placements are turned into instances per frame, the rest waits for the next frame*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid", meta = (ClampMin = "1"))
+	int32 MaxPlacementsPerFrame = 4096;
+
+	/** Cell that contains a world position */
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	FIntVector WorldToCell(const FVector& WorldPosition) const;
+	/** World position of the center of a cell's floor */
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	FVector CellToWorld(const FIntVector& Cell) const;
+	/** Snaps a world position to the center, closest edge or closest corner of its cell, keeping its height */
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	FVector SnapToGrid(const FVector& WorldPosition, ESnappingMode SnappingMode = ESnappingMode::Center) const;
+
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	bool IsCellOccupied(const FIntVector& Cell) const;
+	/** Whether Mesh could be placed at Transform without overlapping occupied cells */
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	bool CanPlace(const UStaticMesh* Mesh, const FTransform& Transform) const;
+
+	/**
+	 * Queues an instance of Mesh and claims its cells.
+	 * @return False if the footprint is blocked and PreventOverlaps is on
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	bool QueuePlacement(UStaticMesh* Mesh, const FTransform& Transform);
+	/**
+	 * Removes the instance covering Cell and frees its cells.
+	 * @return False if no instance covers Cell
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	bool RemoveAt(const FIntVector& Cell);
+	/** Turns every queued placement into instances now instead of spreading them over the next frames */
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	void FlushPlacements();
+	/** Removes all instances and frees all cells */
+	UFUNCTION(BlueprintCallable, Category = "GridPlacer")
+	void ClearGrid();
+
+	UFUNCTION(BlueprintPure, Category = "GridPlacer")
+	int32 GetNumPendingPlacements() const { return PendingPlacements.Num() - NumFlushedPlacements; }
+
+	FGridPlacerFrame GetFrame() const;
+	const FGridPlacerOccupancy& GetOccupancy() const { return Occupancy; }
+
+	/** UActorComponent interface */
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+
+private:
+	struct FPendingPlacement
+	{
+		int32 MeshIndex = INDEX_NONE;
+		FTransform Transform;
+		FGridPlacerCellBox Footprint;
+	};
+
+	/** Where a placed instance lives, looked up by every cell it covers */
+	struct FInstanceRef
+	{
+		int32 MeshIndex = INDEX_NONE;
+		int32 InstanceIndex = INDEX_NONE;
+
+		bool operator==(const FInstanceRef& Other) const { return MeshIndex == Other.MeshIndex && InstanceIndex == Other.InstanceIndex; }
+	};
+
+	struct FMeshInstances
+	{
+		/*Footprint of every instance, indexed like the instances of the component*/
+		TArray<FGridPlacerCellBox> Footprints;
+		/*Reused every flush*/
+		TArray<FTransform> ScratchTransforms;
+	};
+
+	int32 FindOrAddMesh(UStaticMesh* Mesh);
+	void FlushPendingPlacements(int32 MaxPlacements);
+	void SetCellOwner(const FGridPlacerCellBox& Cells, const FInstanceRef& Owner);
+	/** Hands the cells still owned by From over to To, or frees them if To is unset. Cells claimed by later overlapping placements stay untouched. */
+	void ReplaceCellOwner(const FGridPlacerCellBox& Cells, const FInstanceRef& From, const FInstanceRef& To);
+
+	FGridPlacerOccupancy Occupancy;
+	/*One component per mesh, MeshIndex indexes this, Meshes and MeshInstances alike*/
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInstancedStaticMeshComponent>> InstanceComponents;
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UStaticMesh>> Meshes;
+	TArray<FMeshInstances> MeshInstances;
+	TMap<FIntVector, FInstanceRef> CellOwners;
+
+	/*Consumed from the front, NumFlushedPlacements entries are already instanced*/
+	TArray<FPendingPlacement> PendingPlacements;
+	int32 NumFlushedPlacements = 0;
+};
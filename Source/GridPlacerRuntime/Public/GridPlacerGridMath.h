@@ -0,0 +1,233 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * The grid math of GridPlacer without any engine dependency: grid space transforms, snapping, cell lookup,
+ * height offsets and randomization with divisions. Everything is header-only and constexpr, so it can be
+ * compiled, tested and benchmarked as plain C++ as well as evaluated at compile time.
+ * GridPlacerGridMathConversions.h converts between these types and the engine's.
+ */
+namespace GridPlacerMath
+{
+	struct FGridVector
+	{
+		double X = 0.0;
+		double Y = 0.0;
+		double Z = 0.0;
+
+		constexpr FGridVector() = default;
+		constexpr FGridVector(double InX, double InY, double InZ) : X(InX), Y(InY), Z(InZ) {}
+
+		constexpr FGridVector operator+(const FGridVector& Other) const { return FGridVector(X + Other.X, Y + Other.Y, Z + Other.Z); }
+		constexpr FGridVector operator-(const FGridVector& Other) const { return FGridVector(X - Other.X, Y - Other.Y, Z - Other.Z); }
+		constexpr FGridVector operator*(double Scale) const { return FGridVector(X * Scale, Y * Scale, Z * Scale); }
+		constexpr bool operator==(const FGridVector& Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+		constexpr double SizeSquared() const { return X * X + Y * Y + Z * Z; }
+	};
+
+	constexpr FGridVector Cross(const FGridVector& A, const FGridVector& B)
+	{
+		return FGridVector(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X);
+	}
+
+	/*Unit quaternion*/
+	struct FGridRotation
+	{
+		double X = 0.0;
+		double Y = 0.0;
+		double Z = 0.0;
+		double W = 1.0;
+
+		constexpr FGridRotation() = default;
+		constexpr FGridRotation(double InX, double InY, double InZ, double InW) : X(InX), Y(InY), Z(InZ), W(InW) {}
+
+		constexpr FGridRotation Inverse() const { return FGridRotation(-X, -Y, -Z, W); }
+
+		constexpr FGridVector Rotate(const FGridVector& V) const
+		{
+			//v' = v + 2w(q x v) + 2q x (q x v)
+			const FGridVector Q(X, Y, Z);
+			const FGridVector T = Cross(Q, V) * 2.0;
+			return V + T * W + Cross(Q, T);
+		}
+	};
+
+	constexpr double Floor(double Value)
+	{
+		const double Truncated = static_cast<double>(static_cast<int64_t>(Value));
+		return Value < Truncated ? Truncated - 1.0 : Truncated;
+	}
+
+	/*Rounds halves up, like FMath::RoundToFloat*/
+	constexpr double Round(double Value)
+	{
+		return Floor(Value + 0.5);
+	}
+
+	constexpr int32_t FloorToInt(double Value)
+	{
+		return static_cast<int32_t>(Floor(Value));
+	}
+
+	constexpr int32_t Abs(int32_t Value)
+	{
+		return Value < 0 ? -Value : Value;
+	}
+
+	/**
+	 * Origin and orientation of a grid
+	 */
+	struct FGridSpace
+	{
+		FGridVector Origin;
+		FGridRotation Rotation;
+
+		constexpr FGridVector WorldToGrid(const FGridVector& WorldPosition) const { return Rotation.Inverse().Rotate(WorldPosition - Origin); }
+		constexpr FGridVector WorldToGridDirection(const FGridVector& WorldDirection) const { return Rotation.Inverse().Rotate(WorldDirection); }
+		constexpr FGridVector GridToWorld(const FGridVector& GridPosition) const { return Rotation.Rotate(GridPosition) + Origin; }
+		constexpr FGridVector GridToWorldDirection(const FGridVector& GridDirection) const { return Rotation.Rotate(GridDirection); }
+
+		/** Intersects a grid space ray with the grid plane. Returns false for rays parallel to the plane */
+		static constexpr bool IntersectPlane(const FGridVector& RayOrigin, const FGridVector& RayDirection, FGridVector& OutIntersection)
+		{
+			if(RayDirection.Z == 0.0)
+				return false;
+			OutIntersection = RayOrigin - RayDirection * (RayOrigin.Z / RayDirection.Z);
+			return true;
+		}
+	};
+
+	/*Same order as ESnappingMode*/
+	enum class ESnapMode : uint8_t
+	{
+		Center,
+		Edges,
+		Corners,
+		None
+	};
+
+	/** Grid space corner of the cell a grid space position lies in */
+	constexpr FGridVector GetCellCorner(const FGridVector& GridPosition, double CellSizeX, double CellSizeY)
+	{
+		return FGridVector(Floor(GridPosition.X / CellSizeX) * CellSizeX, Floor(GridPosition.Y / CellSizeY) * CellSizeY, GridPosition.Z);
+	}
+
+	/** Snaps a grid space position to the center, closest edge or closest corner of its cell */
+	constexpr FGridVector Snap(const FGridVector& GridPosition, double CellSizeX, double CellSizeY, ESnapMode Mode)
+	{
+		const FGridVector CellCenter(
+			(Round(GridPosition.X / CellSizeX + 0.5) - 0.5) * CellSizeX,
+			(Round(GridPosition.Y / CellSizeY + 0.5) - 0.5) * CellSizeY,
+			GridPosition.Z);
+		switch(Mode)
+		{
+		case ESnapMode::Center:
+			return CellCenter;
+		case ESnapMode::Edges:
+		{
+			const FGridVector Edges[4] = {
+				CellCenter + FGridVector(CellSizeX * 0.5, 0.0, 0.0),
+				CellCenter - FGridVector(CellSizeX * 0.5, 0.0, 0.0),
+				CellCenter + FGridVector(0.0, CellSizeY * 0.5, 0.0),
+				CellCenter - FGridVector(0.0, CellSizeY * 0.5, 0.0)
+			};
+			//Squared distances pick the same edge without a square root
+			int32_t ClosestEdge = 0;
+			double ClosestDistanceSquared = (CellSizeX + CellSizeY) * (CellSizeX + CellSizeY);
+			for(int32_t i = 0; i < 4; ++i)
+			{
+				const double DistanceSquared = (GridPosition - Edges[i]).SizeSquared();
+				if(DistanceSquared < ClosestDistanceSquared)
+				{
+					ClosestDistanceSquared = DistanceSquared;
+					ClosestEdge = i;
+				}
+			}
+			return Edges[ClosestEdge];
+		}
+		case ESnapMode::Corners:
+			return FGridVector(Round(GridPosition.X / CellSizeX) * CellSizeX, Round(GridPosition.Y / CellSizeY) * CellSizeY, GridPosition.Z);
+		case ESnapMode::None:
+		default:
+			return GridPosition;
+		}
+	}
+
+	/*Same order as EGridSpaceMode*/
+	enum class EOffsetSpace : uint8_t
+	{
+		Global,
+		Local,
+		Custom
+	};
+
+	/**
+	 * World space offset of Offset along the up axis of the given space.
+	 * CustomUp is the world space up vector of the custom space target, or nullptr if there is none.
+	 */
+	constexpr FGridVector GetHeightOffset(double Offset, EOffsetSpace Space, const FGridRotation& GridRotation, const FGridVector* CustomUp)
+	{
+		const FGridVector Up(0.0, 0.0, 1.0);
+		switch(Space)
+		{
+		case EOffsetSpace::Global:
+			return Up * Offset;
+		case EOffsetSpace::Custom:
+			return CustomUp ? *CustomUp * Offset : Up * Offset;
+		case EOffsetSpace::Local:
+		default:
+			return GridRotation.Rotate(Up * Offset);
+		}
+	}
+
+	/** Value at Step of a range split into Divisions equal parts. Step 0 is Min, step Divisions is Max */
+	constexpr double GetDivisionValue(double Min, double Max, int32_t Divisions, int32_t Step)
+	{
+		return Min + ((Max - Min) / Divisions) * Step;
+	}
+
+	/**
+	 * Maps a uniform random number in [0, 1) onto a range. With Divisions other than 0 the result is snapped to one of
+	 * the divisions, IncludeMax decides wether Max itself is one of them (it isn't for full turns where Max equals Min).
+	 */
+	constexpr double GetRandomValue(double Min, double Max, int32_t Divisions, bool IncludeMax, double Random01)
+	{
+		if(Divisions == 0)
+			return Min + (Max - Min) * Random01;
+		const int32_t NumSteps = Abs(Divisions) + (IncludeMax ? 1 : 0);
+		int32_t Step = FloorToInt(Random01 * NumSteps);
+		Step = Step < NumSteps ? Step : NumSteps - 1;
+		return GetDivisionValue(Min, Max, Divisions, Step);
+	}
+
+	/** Calls Visitor(X, Y) for every cell of the Bresenham line from (X0, Y0) to (X1, Y1), both ends included */
+	template<typename VisitorType>
+	constexpr void ForEachLineCell(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1, VisitorType&& Visitor)
+	{
+		const int32_t DeltaX = Abs(X1 - X0);
+		const int32_t DeltaY = -Abs(Y1 - Y0);
+		const int32_t StepX = X0 < X1 ? 1 : -1;
+		const int32_t StepY = Y0 < Y1 ? 1 : -1;
+		int32_t Error = DeltaX + DeltaY;
+		while(true)
+		{
+			Visitor(X0, Y0);
+			if(X0 == X1 && Y0 == Y1)
+				break;
+			const int32_t DoubleError = 2 * Error;
+			if(DoubleError >= DeltaY)
+			{
+				Error += DeltaY;
+				X0 += StepX;
+			}
+			if(DoubleError <= DeltaX)
+			{
+				Error += DeltaX;
+				Y0 += StepY;
+			}
+		}
+	}
+}
@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridPlacerGridMath.h"
+
+namespace GridPlacerMath
+{
+	inline FGridVector ToGridVector(const FVector& Vector) { return FGridVector(Vector.X, Vector.Y, Vector.Z); }
+	inline FVector ToFVector(const FGridVector& Vector) { return FVector(Vector.X, Vector.Y, Vector.Z); }
+	inline FGridRotation ToGridRotation(const FQuat& Quat) { return FGridRotation(Quat.X, Quat.Y, Quat.Z, Quat.W); }
+	inline FQuat ToFQuat(const FGridRotation& Rotation) { return FQuat(Rotation.X, Rotation.Y, Rotation.Z, Rotation.W); }
+	inline FGridSpace ToGridSpace(const FVector& Origin, const FRotator& Rotation) { return {ToGridVector(Origin), ToGridRotation(Rotation.Quaternion())}; }
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StaticMeshActor.h"
+#include "GridPlacerMergedChunk.generated.h"
+
+/**
+ * One placement a merged chunk was baked from
+ */
+USTRUCT()
+struct FGridPlacerMergedSource
+{
+	GENERATED_BODY()
+
+	/*Either a UStaticMesh or an actor UClass*/
+	UPROPERTY()
+	TSoftObjectPtr<UObject> Asset;
+	UPROPERTY()
+	FTransform Transform;
+	UPROPERTY()
+	bool AsInstance = false;
+	/*Per instance custom data or custom primitive data of the placement, e.g. its variation and hidden cell flag*/
+	UPROPERTY()
+	TArray<float> CustomData;
+};
+
+/**
+ * Static mesh actor showing the merged mesh of one chunk of placed grid tiles.
+ * It remembers the placements it replaced, so the editor can swap the original layout back in.
+ */
+UCLASS()
+class GRIDPLACERRUNTIME_API AGridPlacerMergedChunk : public AStaticMeshActor
+{
+	GENERATED_BODY()
+
+public:
+#if WITH_EDITORONLY_DATA
+	/*The chunk of the grid this actor was baked for, in chunks of the size used when baking*/
+	UPROPERTY(VisibleAnywhere, Category = "GridPlacer")
+	FIntPoint Chunk = FIntPoint::ZeroValue;
+	/*Every placement merged into the mesh*/
+	UPROPERTY()
+	TArray<FGridPlacerMergedSource> Sources;
+#endif
+};
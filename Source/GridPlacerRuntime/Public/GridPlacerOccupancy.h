@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Inclusive range of grid cells, addressed as (X, Y, Layer)
+ */
+struct GRIDPLACERRUNTIME_API FGridPlacerCellBox
+{
+	FIntVector Min = FIntVector(0);
+	FIntVector Max = FIntVector(-1);
+
+	FGridPlacerCellBox() {}
+	FGridPlacerCellBox(const FIntVector& InMin, const FIntVector& InMax) : Min(InMin), Max(InMax) {}
+
+	bool IsValid() const { return Max.X >= Min.X && Max.Y >= Min.Y && Max.Z >= Min.Z; }
+	FIntVector Size() const { return Max - Min + FIntVector(1); }
+	bool Intersects(const FGridPlacerCellBox& Other) const
+	{
+		return Min.X <= Other.Max.X && Max.X >= Other.Min.X
+			&& Min.Y <= Other.Max.Y && Max.Y >= Other.Min.Y
+			&& Min.Z <= Other.Max.Z && Max.Z >= Other.Min.Z;
+	}
+	bool operator==(const FGridPlacerCellBox& Other) const { return Min == Other.Min && Max == Other.Max; }
+};
+
+/**
+ * Origin, orientation and cell size of a grid.
+ * Layers stack along the grid normal, CellSize.Z apart.
+ */
+struct GRIDPLACERRUNTIME_API FGridPlacerFrame
+{
+	FTransform GridToWorld = FTransform::Identity;
+	FVector CellSize = FVector(100.0f);
+
+	FIntVector WorldToCell(const FVector& WorldPosition) const;
+	/** Cells covered by a box given in grid space */
+	FGridPlacerCellBox GetCellBox(const FBox& GridSpaceBounds) const;
+	/** Cells covered by an object with the given local bounds */
+	FGridPlacerCellBox GetFootprint(const FBox& LocalBounds, const FTransform& ObjectToWorld) const;
+	/** Grid space box spanned by a range of cells */
+	FBox GetCellBounds(const FGridPlacerCellBox& Cells) const;
+
+	bool Equals(const FGridPlacerFrame& Other) const;
+};
+
+/**
+ * Sparse occupancy mask over grid cells.
+ * Every layer is split into 64x64 chunks that store one uint64 per row, so testing an NxM footprint
+ * boils down to one AND per row and chunk instead of a lookup per cell.
+ */
+class GRIDPLACERRUNTIME_API FGridPlacerOccupancy
+{
+public:
+	static constexpr int32 ChunkShift = 6;
+	static constexpr int32 ChunkSize = 1 << ChunkShift;
+
+	void Reset();
+	void Add(const FGridPlacerCellBox& Cells);
+	void Remove(const FGridPlacerCellBox& Cells);
+	bool IsOccupied(const FIntVector& Cell) const;
+	bool Overlaps(const FGridPlacerCellBox& Cells) const;
+	int32 Num() const { return NumOccupied; }
+
+	/** Occupied cells of one row of a chunk as bits, bit 0 is the first cell of the chunk */
+	uint64 GetRow(int32 ChunkX, int32 Y, int32 Layer) const;
+	/** Cells of one row of a chunk that are occupied and whose six neighbors are occupied as well */
+	uint64 GetEnclosedRow(int32 ChunkX, int32 Y, int32 Layer) const;
+	/** Whether every one of Cells is occupied and surrounded by occupied cells on all six sides */
+	bool IsEnclosed(const FGridPlacerCellBox& Cells) const;
+
+private:
+	struct FChunk
+	{
+		uint64 Rows[ChunkSize] = {};
+		int32 NumOccupied = 0;
+	};
+
+	/** Calls Visitor(ChunkKey, LocalRow, RowMask, FirstCellX) for every chunk row touched by Cells */
+	template<typename VisitorType>
+	static void ForEachRowSpan(const FGridPlacerCellBox& Cells, VisitorType&& Visitor);
+
+	TMap<FIntVector, FChunk> Chunks;
+	/*How many more objects cover a cell than the one its bit stands for. Only filled when overlaps were allowed.*/
+	TMap<FIntVector, int32> ExtraReferences;
+	int32 NumOccupied = 0;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Incremental Poisson disk sampler (Bridson) with a spacing per sample.
+ * Two samples keep at least the larger of their spacings apart. A background grid with cells of MinSpacing / sqrt(2)
+ * makes every test look at a few cells only, so regions can be filled one after another, e.g. while dragging a brush.
+ */
+class GRIDPLACERRUNTIME_API FGridPlacerPoissonSampler
+{
+public:
+	struct FSample
+	{
+		FVector2D Position = FVector2D::ZeroVector;
+		double Spacing = 0.0;
+		/*Whatever the caller picked the spacing for, e.g. a palette index*/
+		int32 Tag = INDEX_NONE;
+	};
+
+	/** Forgets all samples. MinSpacing should be the smallest spacing that will be requested, it sizes the background grid. */
+	void Reset(double MinSpacing);
+	/** Adds a sample that is already there, new samples keep their distance to it */
+	void AddExisting(const FVector2D& Position, double Spacing);
+	/**
+	 * Grows samples into Region until no candidate fits anymore.
+	 * PickCandidate(OutTag) returns the spacing of the next candidate and the tag it is stored with.
+	 * New samples are appended to OutSamples.
+	 */
+	void Fill(const FBox2D& Region, int32 Attempts, FRandomStream& Stream, TFunctionRef<double(int32&)> PickCandidate, TArray<FSample>& OutSamples);
+
+	int32 Num() const { return Samples.Num(); }
+
+private:
+	struct FEntry
+	{
+		FSample Sample;
+		/*Next sample in the same grid cell*/
+		int32 Next = INDEX_NONE;
+		/*Failed to grow for lack of space rather than for leaving the region, no later region can change that*/
+		bool Closed = false;
+	};
+
+	FIntPoint GetCell(const FVector2D& Position) const;
+	bool IsFree(const FVector2D& Position, double Spacing) const;
+	int32 Add(const FSample& Sample);
+
+	double CellSize = 1.0;
+	double MaxSpacing = 0.0;
+	TArray<FEntry> Samples;
+	/*First sample of every occupied grid cell*/
+	TMap<FIntPoint, int32> Cells;
+	TArray<int32> Active;
+};
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridPlacerOccupancy.h"
+
+/**
+ * World space sockets of placed objects, hashed by the grid cell they are in.
+ * Looking for the closest compatible socket only visits the cells within reach of the query point,
+ * no matter how many objects have been placed.
+ */
+class GRIDPLACERRUNTIME_API FGridPlacerSocketIndex
+{
+public:
+	struct FSocket
+	{
+		uint32 ItemId = 0;
+		FTransform Transform;
+		/*Sockets only connect to sockets with the same tag*/
+		FName Tag;
+	};
+
+	/** Forgets all sockets, new ones are hashed by the cells of Frame */
+	void Reset(const FGridPlacerFrame& InFrame);
+	/** Adds the sockets of an item, replacing the ones it had before */
+	void Add(uint32 ItemId, TArrayView<const FSocket> ItemSockets);
+	void Remove(uint32 ItemId);
+	/** Closest socket tagged Tag that is at most MaxDistance away from Location, null if there is none */
+	const FSocket* FindClosest(const FVector& Location, FName Tag, double MaxDistance) const;
+	int32 Num() const { return Sockets.Num(); }
+
+private:
+	FGridPlacerFrame Frame;
+	TSparseArray<FSocket> Sockets;
+	/*Indices into Sockets*/
+	TMap<FIntVector, TArray<int32>> Cells;
+	TMap<uint32, TArray<int32, TInlineAllocator<4>>> ItemSocketIndices;
+};
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Uniform world space hash over the bounds of placed items.
+ * Items are stored in every bucket their bounds touch, queries only visit the buckets overlapping the query box.
+ */
+class GRIDPLACERRUNTIME_API FGridPlacerSpatialHash
+{
+public:
+	explicit FGridPlacerSpatialHash(double InBucketSize = 400.0);
+
+	void Reset();
+	void Insert(uint32 Id, const FBox& Bounds);
+	void Remove(uint32 Id);
+	/** Appends the ids of all items whose bounds intersect QueryBounds, every id at most once */
+	void Query(const FBox& QueryBounds, TArray<uint32>& OutIds) const;
+	int32 Num() const { return ItemBounds.Num(); }
+
+private:
+	FIntVector GetBucket(const FVector& Position) const;
+	bool IsOversized(const FBox& Bounds) const;
+
+	double BucketSize;
+	TMap<FIntVector, TArray<uint32>> Buckets;
+	TMap<uint32, FBox> ItemBounds;
+	/*Items that would touch too many buckets are checked by every query instead*/
+	TArray<uint32> OversizedItems;
+};
@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridPlacerTypes.generated.h"
+
+/*Shared by the placement tool and the runtime grid, same order as GridPlacerMath::ESnapMode*/
+UENUM(BlueprintType)
+enum class ESnappingMode : uint8
+{
+	Center,
+	Edges,
+	Corners,
+	None
+};
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Wave function collapse over a rectangle of grid cells.
+ * Every cell starts out allowing every tile as a bitset. Picking a tile for the cell with the fewest options left
+ * removes the tiles that don't fit next to it from its neighbors, which is passed on through a worklist until nothing changes.
+ * The region is cut into blocks like a checkerboard. Blocks of one color only touch blocks of the other color,
+ * so all blocks of a color are solved in parallel and the second color is fitted in between the first.
+ */
+class GRIDPLACERRUNTIME_API FGridPlacerWaveCollapse
+{
+public:
+	/*Edges of a tile, counterclockwise in grid space*/
+	enum EEdge
+	{
+		PosX,
+		PosY,
+		NegX,
+		NegY,
+		NumEdges
+	};
+
+	struct FTile
+	{
+		/*Tiles fit next to each other if the edges they touch with have the same label*/
+		int32 Edges[NumEdges] = {0, 0, 0, 0};
+		float Weight = 1.0f;
+	};
+
+	void SetTiles(TArrayView<const FTile> Tiles);
+	int32 NumTiles() const { return Weights.Num(); }
+
+	/**
+	 * Picks a tile for every cell of a Size.X by Size.Y region, stored row by row in OutTiles.
+	 * The result only depends on the tiles, Size, Seed and BlockSize, not on how the blocks are scheduled.
+	 * Blocks that run into a contradiction start over with another seed up to Attempts times,
+	 * after that cells no tile fits into are left at INDEX_NONE. Returns how many cells that are.
+	 */
+	int32 Solve(const FIntPoint& Size, int32 Seed, int32 BlockSize, int32 Attempts, TArray<int32>& OutTiles) const;
+
+private:
+	/**
+	 * Solves the cells of Block, fitting them to the cells around it that are already solved in Tiles.
+	 * Returns INDEX_NONE on a contradiction, unless Tolerant gives up on the cells nothing fits into instead.
+	 * Otherwise Tiles is filled for the block and the number of cells given up on is returned.
+	 */
+	int32 SolveBlock(const FIntPoint& Size, const FIntRect& Block, FRandomStream& Stream, bool Tolerant, TArray<int32>& Tiles) const;
+	const uint64* GetCompatible(int32 Edge, int32 Tile) const { return &Compatible[(Edge * NumTiles() + Tile) * NumWords]; }
+
+	/*64 tiles per word of a domain*/
+	int32 NumWords = 0;
+	TArray<double> Weights;
+	TArray<double> WeightLogWeights;
+	/*For every edge and tile the tiles that fit next to it across that edge, NumWords each*/
+	TArray<uint64> Compatible;
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GridPlacerGridMath.h"
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace GridPlacerMath;
+
+namespace
+{
+	/** Cursor positions spread over a few hundred cells in every direction, the same set for every run */
+	std::vector<FGridVector> MakePositions(size_t Count)
+	{
+		std::vector<FGridVector> Positions;
+		Positions.reserve(Count);
+		uint64_t State = 0x9E3779B97F4A7C15ull;
+		for(size_t i = 0; i < Count; ++i)
+		{
+			auto Next = [&State]()
+			{
+				State = State * 6364136223846793005ull + 1442695040888963407ull;
+				return static_cast<double>(State >> 11) / static_cast<double>(1ull << 53);
+			};
+			Positions.emplace_back(Next() * 50000.0 - 25000.0, Next() * 50000.0 - 25000.0, Next() * 1000.0);
+		}
+		return Positions;
+	}
+
+	const std::vector<FGridVector>& GetPositions()
+	{
+		static const std::vector<FGridVector> Positions = MakePositions(4096);
+		return Positions;
+	}
+}
+
+/** Snapping a grid space position, as done for every preview update */
+static void BM_Snap(benchmark::State& State)
+{
+	const ESnapMode Mode = static_cast<ESnapMode>(State.range(0));
+	const std::vector<FGridVector>& Positions = GetPositions();
+	size_t Index = 0;
+	for(auto _ : State)
+	{
+		benchmark::DoNotOptimize(Snap(Positions[Index], 100.0, 100.0, Mode));
+		Index = (Index + 1) % Positions.size();
+	}
+	State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_Snap)->ArgName("Mode")->Arg(static_cast<int>(ESnapMode::Center))->Arg(static_cast<int>(ESnapMode::Edges))->Arg(static_cast<int>(ESnapMode::Corners));
+
+/** The whole placement point of a hover on a rotated grid: ray into grid space, plane intersection, snap, height offset and back to world space */
+static void BM_PlacementPoint(benchmark::State& State)
+{
+	const double HalfAngle = 0.3;
+	const FGridSpace Space{FGridVector(150.0, -70.0, 20.0), FGridRotation(0.0, 0.0, std::sin(HalfAngle), std::cos(HalfAngle))};
+	const FGridVector RayDirection = FGridVector(0.2, -0.1, -1.0);
+	const std::vector<FGridVector>& Positions = GetPositions();
+	size_t Index = 0;
+	for(auto _ : State)
+	{
+		const FGridVector RayOrigin = Positions[Index] + FGridVector(0.0, 0.0, 2000.0);
+		FGridVector GridPosition;
+		if(FGridSpace::IntersectPlane(Space.WorldToGrid(RayOrigin), Space.WorldToGridDirection(RayDirection), GridPosition))
+		{
+			const FGridVector Snapped = Snap(GridPosition, 100.0, 100.0, ESnapMode::Edges);
+			benchmark::DoNotOptimize(Space.GridToWorld(Snapped) + GetHeightOffset(100.0, EOffsetSpace::Local, Space.Rotation, nullptr));
+		}
+		Index = (Index + 1) % Positions.size();
+	}
+	State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_PlacementPoint);
+
+/** Walking the cells of a line placement, per cell */
+static void BM_ForEachLineCell(benchmark::State& State)
+{
+	const int32_t Length = static_cast<int32_t>(State.range(0));
+	int64_t NumCells = 0;
+	for(auto _ : State)
+	{
+		int64_t Checksum = 0;
+		ForEachLineCell(-Length / 2, 7, Length / 2, Length / 3, [&Checksum](int32_t X, int32_t Y) { Checksum += X ^ Y; });
+		benchmark::DoNotOptimize(Checksum);
+		NumCells += Length + 1;
+	}
+	State.SetItemsProcessed(NumCells);
+}
+BENCHMARK(BM_ForEachLineCell)->ArgName("Length")->RangeMultiplier(8)->Range(8, 32768);
+
+/** Rolling a randomized rotation with divisions, done for every object placed in bulk */
+static void BM_GetRandomValue(benchmark::State& State)
+{
+	const std::vector<FGridVector>& Positions = GetPositions();
+	size_t Index = 0;
+	for(auto _ : State)
+	{
+		benchmark::DoNotOptimize(GetRandomValue(0.0, 360.0, 4, false, Positions[Index].Z / 1000.0));
+		Index = (Index + 1) % Positions.size();
+	}
+	State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_GetRandomValue);
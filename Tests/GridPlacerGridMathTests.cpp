@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GridPlacerGridMath.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace GridPlacerMath;
+
+namespace
+{
+	constexpr double Tolerance = 1e-9;
+
+	void ExpectNear(const FGridVector& Actual, const FGridVector& Expected)
+	{
+		EXPECT_NEAR(Actual.X, Expected.X, Tolerance);
+		EXPECT_NEAR(Actual.Y, Expected.Y, Tolerance);
+		EXPECT_NEAR(Actual.Z, Expected.Z, Tolerance);
+	}
+
+	std::vector<std::pair<int32_t, int32_t>> GetLineCells(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+	{
+		std::vector<std::pair<int32_t, int32_t>> Cells;
+		ForEachLineCell(X0, Y0, X1, Y1, [&Cells](int32_t X, int32_t Y) { Cells.emplace_back(X, Y); });
+		return Cells;
+	}
+
+	constexpr int32_t CountLineCells(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1)
+	{
+		int32_t NumCells = 0;
+		ForEachLineCell(X0, Y0, X1, Y1, [&NumCells](int32_t, int32_t) { ++NumCells; });
+		return NumCells;
+	}
+}
+
+//Everything is constexpr, so the tool can rely on it being evaluated at compile time
+static_assert(Floor(-0.5) == -1.0, "Floor rounds towards negative infinity");
+static_assert(Snap(FGridVector(130.0, -20.0, 5.0), 100.0, 100.0, ESnapMode::Center) == FGridVector(150.0, -50.0, 5.0), "Snap is constexpr");
+static_assert(CountLineCells(0, 0, 7, -3) == 8, "ForEachLineCell is constexpr");
+
+TEST(GridMathRounding, FloorRoundsTowardsNegativeInfinity)
+{
+	EXPECT_EQ(Floor(0.0), 0.0);
+	EXPECT_EQ(Floor(1.5), 1.0);
+	EXPECT_EQ(Floor(2.0), 2.0);
+	EXPECT_EQ(Floor(-1.5), -2.0);
+	EXPECT_EQ(Floor(-2.0), -2.0);
+	EXPECT_EQ(Floor(-0.25), -1.0);
+	EXPECT_EQ(FloorToInt(-0.25), -1);
+	EXPECT_EQ(FloorToInt(3.99), 3);
+}
+
+TEST(GridMathRounding, RoundRoundsHalvesUp)
+{
+	EXPECT_EQ(Round(0.5), 1.0);
+	EXPECT_EQ(Round(1.49), 1.0);
+	EXPECT_EQ(Round(-0.5), 0.0);
+	EXPECT_EQ(Round(-1.5), -1.0);
+	EXPECT_EQ(Round(-1.51), -2.0);
+}
+
+TEST(GridMathSnap, CenterSnapsToTheCenterOfTheCell)
+{
+	ExpectNear(Snap(FGridVector(130.0, -20.0, 5.0), 100.0, 100.0, ESnapMode::Center), FGridVector(150.0, -50.0, 5.0));
+	ExpectNear(Snap(FGridVector(0.0, 0.0, 0.0), 100.0, 100.0, ESnapMode::Center), FGridVector(50.0, 50.0, 0.0));
+	ExpectNear(Snap(FGridVector(-0.1, 99.9, 0.0), 100.0, 100.0, ESnapMode::Center), FGridVector(-50.0, 50.0, 0.0));
+	//Cells don't have to be square
+	ExpectNear(Snap(FGridVector(130.0, 130.0, 0.0), 200.0, 50.0, ESnapMode::Center), FGridVector(100.0, 125.0, 0.0));
+}
+
+TEST(GridMathSnap, EdgesSnapToTheClosestEdgeOfTheCell)
+{
+	ExpectNear(Snap(FGridVector(190.0, 150.0, 0.0), 100.0, 100.0, ESnapMode::Edges), FGridVector(200.0, 150.0, 0.0));
+	ExpectNear(Snap(FGridVector(110.0, 150.0, 0.0), 100.0, 100.0, ESnapMode::Edges), FGridVector(100.0, 150.0, 0.0));
+	ExpectNear(Snap(FGridVector(150.0, 195.0, 0.0), 100.0, 100.0, ESnapMode::Edges), FGridVector(150.0, 200.0, 0.0));
+	ExpectNear(Snap(FGridVector(-150.0, -195.0, 3.0), 100.0, 100.0, ESnapMode::Edges), FGridVector(-150.0, -200.0, 3.0));
+}
+
+TEST(GridMathSnap, CornersSnapToTheClosestCorner)
+{
+	ExpectNear(Snap(FGridVector(140.0, 160.0, 0.0), 100.0, 100.0, ESnapMode::Corners), FGridVector(100.0, 200.0, 0.0));
+	ExpectNear(Snap(FGridVector(-140.0, -160.0, 7.0), 100.0, 100.0, ESnapMode::Corners), FGridVector(-100.0, -200.0, 7.0));
+}
+
+TEST(GridMathSnap, NoneKeepsThePosition)
+{
+	ExpectNear(Snap(FGridVector(12.5, -7.25, 3.0), 100.0, 100.0, ESnapMode::None), FGridVector(12.5, -7.25, 3.0));
+}
+
+TEST(GridMathSnap, CellCornerIsTheLowerCornerOfTheCell)
+{
+	ExpectNear(GetCellCorner(FGridVector(130.0, -20.0, 5.0), 100.0, 100.0), FGridVector(100.0, -100.0, 5.0));
+}
+
+TEST(GridMathHeightOffset, GlobalGoesAlongWorldUp)
+{
+	const FGridRotation Tilted(std::sin(0.25), 0.0, 0.0, std::cos(0.25));
+	ExpectNear(GetHeightOffset(50.0, EOffsetSpace::Global, Tilted, nullptr), FGridVector(0.0, 0.0, 50.0));
+}
+
+TEST(GridMathHeightOffset, LocalGoesAlongGridUp)
+{
+	//A quarter turn around X takes the grid's up axis to -Y
+	const double Half = std::sqrt(0.5);
+	const FGridRotation QuarterTurnX(Half, 0.0, 0.0, Half);
+	ExpectNear(GetHeightOffset(50.0, EOffsetSpace::Local, QuarterTurnX, nullptr), FGridVector(0.0, -50.0, 0.0));
+	ExpectNear(GetHeightOffset(50.0, EOffsetSpace::Local, FGridRotation(), nullptr), FGridVector(0.0, 0.0, 50.0));
+}
+
+TEST(GridMathHeightOffset, CustomGoesAlongTargetUpOrWorldUpWithoutTarget)
+{
+	const FGridVector CustomUp(1.0, 0.0, 0.0);
+	ExpectNear(GetHeightOffset(-20.0, EOffsetSpace::Custom, FGridRotation(), &CustomUp), FGridVector(-20.0, 0.0, 0.0));
+	ExpectNear(GetHeightOffset(-20.0, EOffsetSpace::Custom, FGridRotation(), nullptr), FGridVector(0.0, 0.0, -20.0));
+}
+
+TEST(GridMathRandomValue, WithoutDivisionsMapsLinearly)
+{
+	EXPECT_NEAR(GetRandomValue(10.0, 20.0, 0, false, 0.0), 10.0, Tolerance);
+	EXPECT_NEAR(GetRandomValue(10.0, 20.0, 0, false, 0.25), 12.5, Tolerance);
+	EXPECT_NEAR(GetRandomValue(10.0, 20.0, 0, true, 0.25), 12.5, Tolerance);
+}
+
+TEST(GridMathRandomValue, WithoutIncludeMaxNeverReachesMax)
+{
+	//Full turns: 360 would be the same as 0
+	std::set<double> Values;
+	for(int32_t i = 0; i < 1000; ++i)
+		Values.insert(GetRandomValue(0.0, 360.0, 4, false, i / 1000.0));
+	EXPECT_EQ(Values, (std::set<double>{0.0, 90.0, 180.0, 270.0}));
+	EXPECT_NEAR(GetRandomValue(0.0, 360.0, 4, false, 0.999999), 270.0, Tolerance);
+}
+
+TEST(GridMathRandomValue, WithIncludeMaxReachesMax)
+{
+	std::set<double> Values;
+	for(int32_t i = 0; i < 1000; ++i)
+		Values.insert(GetRandomValue(1.0, 2.0, 4, true, i / 1000.0));
+	EXPECT_EQ(Values, (std::set<double>{1.0, 1.25, 1.5, 1.75, 2.0}));
+	EXPECT_NEAR(GetRandomValue(1.0, 2.0, 4, true, 0.999999), 2.0, Tolerance);
+}
+
+TEST(GridMathRandomValue, RandomOfOneStaysInRange)
+{
+	EXPECT_NEAR(GetRandomValue(0.0, 360.0, 4, false, 1.0), 270.0, Tolerance);
+	EXPECT_NEAR(GetRandomValue(1.0, 2.0, 4, true, 1.0), 2.0, Tolerance);
+}
+
+TEST(GridMathLine, MatchesBresenham)
+{
+	const std::vector<std::pair<int32_t, int32_t>> Expected = {{0, 0}, {1, 0}, {2, 1}, {3, 1}, {4, 2}, {5, 2}};
+	EXPECT_EQ(GetLineCells(0, 0, 5, 2), Expected);
+}
+
+TEST(GridMathLine, SingleCell)
+{
+	const std::vector<std::pair<int32_t, int32_t>> Expected = {{3, -4}};
+	EXPECT_EQ(GetLineCells(3, -4, 3, -4), Expected);
+}
+
+TEST(GridMathLine, CoversEveryOctant)
+{
+	//Two lines per octant plus the axes and diagonals between them, starting off the origin
+	const int32_t StartX = 3;
+	const int32_t StartY = -2;
+	const std::pair<int32_t, int32_t> Deltas[] = {
+		{7, 3}, {7, 0}, {3, 7}, {5, 5}, {0, 7}, {-3, 7}, {-5, 5}, {-7, 3}, {-7, 0}, {-7, -3},
+		{-5, -5}, {-3, -7}, {0, -7}, {3, -7}, {5, -5}, {7, -3}, {6, 1}, {1, 6}, {-1, -6}, {-6, -1}
+	};
+	for(const std::pair<int32_t, int32_t>& Delta : Deltas)
+	{
+		SCOPED_TRACE(testing::Message() << "Delta " << Delta.first << ", " << Delta.second);
+		const int32_t EndX = StartX + Delta.first;
+		const int32_t EndY = StartY + Delta.second;
+		const std::vector<std::pair<int32_t, int32_t>> Cells = GetLineCells(StartX, StartY, EndX, EndY);
+
+		const int32_t Major = std::max(Abs(Delta.first), Abs(Delta.second));
+		ASSERT_EQ(static_cast<int32_t>(Cells.size()), Major + 1);
+		EXPECT_EQ(Cells.front(), std::make_pair(StartX, StartY));
+		EXPECT_EQ(Cells.back(), std::make_pair(EndX, EndY));
+		for(size_t i = 0; i < Cells.size(); ++i)
+		{
+			const int32_t X = Cells[i].first - StartX;
+			const int32_t Y = Cells[i].second - StartY;
+			//Every cell advances along the major axis by exactly one and sticks to the ideal line
+			if(Abs(Delta.first) >= Abs(Delta.second))
+			{
+				EXPECT_EQ(Abs(X), static_cast<int32_t>(i));
+				EXPECT_LE(std::abs(Y - X * static_cast<double>(Delta.second) / Delta.first), 0.5 + Tolerance);
+			}
+			else
+			{
+				EXPECT_EQ(Abs(Y), static_cast<int32_t>(i));
+				EXPECT_LE(std::abs(X - Y * static_cast<double>(Delta.first) / Delta.second), 0.5 + Tolerance);
+			}
+		}
+	}
+}
+
+TEST(GridMathLine, ReversedLineCoversTheSameCellCount)
+{
+	EXPECT_EQ(GetLineCells(-4, 9, 11, 2).size(), GetLineCells(11, 2, -4, 9).size());
+}